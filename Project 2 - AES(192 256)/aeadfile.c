@@ -0,0 +1,354 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifdef __linux__
+#include <bsd/stdlib.h>
+#elif __APPLE__
+#include <stdlib.h>
+#else
+#include <stdlib.h>
+#endif
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "aeadfile.h"
+#include "sha2.h"
+
+#define SEG_FULL(seg) ((uint64_t)(seg) + GCM_TAGLEN)  /* 암호문 파일에서 세그먼트 하나의 크기 */
+
+static int read_full(int fd, uint8_t *buf, size_t len, off_t off)
+{
+  while (len > 0) {
+    ssize_t n = pread(fd, buf, len, off);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+    buf += n; len -= n; off += n;
+  }
+  return 1;
+}
+
+static int write_full(int fd, const uint8_t *buf, size_t len, off_t off)
+{
+  while (len > 0) {
+    ssize_t n = pwrite(fd, buf, len, off);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+    buf += n; len -= n; off += n;
+  }
+  return 1;
+}
+
+// HMAC-SHA256(key, msg)를 mac에 저장합니다. key는 SHA256_BLOCK_SIZE 바이트 이하여야 합니다.
+static void hmac_sha256(const uint8_t *key, size_t key_len, const uint8_t *msg, size_t len, uint8_t *mac)
+{
+  uint8_t pad[SHA256_BLOCK_SIZE];
+  sha256_ctx ctx;
+
+  memset(pad, 0x36, sizeof(pad));
+  for (size_t i = 0; i < key_len; i++)
+    pad[i] ^= key[i];
+  sha256_init(&ctx);
+  sha256_update(&ctx, pad, sizeof(pad));
+  sha256_update(&ctx, msg, len);
+  sha256_final(&ctx, mac);
+  for (size_t i = 0; i < sizeof(pad); i++)
+    pad[i] ^= 0x36 ^ 0x5c;
+  sha256_init(&ctx);
+  sha256_update(&ctx, pad, sizeof(pad));
+  sha256_update(&ctx, mac, SHA256_DIGEST_SIZE);
+  sha256_final(&ctx, mac);
+  memset(pad, 0, sizeof(pad));
+  memset(&ctx, 0, sizeof(ctx));
+}
+
+// 헤더의 salt와 앞 16바이트로 HKDF-SHA256(RFC 5869)을 계산하여 파일 키를 만듭니다.
+// 키는 최대 32바이트이므로 확장 단계는 T(1) 한 블록으로 충분합니다.
+static void file_key(const uint8_t *key, int length, const uint8_t *hdr, uint8_t *fkey)
+{
+  uint8_t prk[SHA256_DIGEST_SIZE], info[17], t[SHA256_DIGEST_SIZE];
+
+  hmac_sha256(hdr + 16, AEADFILE_SALTLEN, key, KEYLEN + 8*length, prk);
+  memcpy(info, hdr, 16);
+  info[16] = 1;
+  hmac_sha256(prk, sizeof(prk), info, sizeof(info), t);
+  memcpy(fkey, t, KEYLEN + 8*length);
+  memset(prk, 0, sizeof(prk));
+  memset(t, 0, sizeof(t));
+}
+
+// 세그먼트 번호와 마지막 세그먼트 여부로 nonce를 만듭니다.
+// 같은 파일 안에서 nonce가 겹치지 않고, 파일마다 키가 다르므로 파일 사이에서도 (키, nonce) 쌍이 겹치지 않습니다.
+static void seg_nonce(const uint8_t *hdr, uint64_t idx, int last, uint8_t *nonce)
+{
+  memcpy(nonce, hdr + 16 + AEADFILE_SALTLEN, 7);
+  nonce[7] = (idx >> 24) & 0xFF;
+  nonce[8] = (idx >> 16) & 0xFF;
+  nonce[9] = (idx >> 8) & 0xFF;
+  nonce[10] = idx & 0xFF;
+  nonce[11] = last ? 1 : 0;
+}
+
+/*
+ * aeadfile_seal() - 파일 in을 seg_size 바이트 세그먼트로 나누어 암호화한 결과를 out에 저장한다.
+ * seg_size가 0이면 AEADFILE_SEGSIZE를 사용한다. 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int aeadfile_seal(const char *in, const char *out, const uint8_t *key, int length, uint32_t seg_size)
+{
+  uint8_t hdr[AEADFILE_HDRLEN] = {0}, nonce[GCM_IVLEN], fkey[KEYLEN_256], *buf = NULL;
+  gcm_ctx_t gcm;
+  struct stat st;
+  uint64_t size, nseg, i;
+  int ifd = -1, ofd = -1, result = 0;
+
+  if (seg_size == 0)
+    seg_size = AEADFILE_SEGSIZE;
+  if (in == NULL || out == NULL || key == NULL || length < AES128 || length > AES256
+      || seg_size > AEADFILE_MAXSEG)
+    return AEADFILE_INVALID_ARG;
+
+  if ((ifd = open(in, O_RDONLY)) < 0 || fstat(ifd, &st) < 0) {
+    result = AEADFILE_OPEN_FAIL;
+    goto done;
+  }
+  // 평문이 비어 있어도 마지막 세그먼트 하나(태그만 있음)는 항상 기록합니다.
+  size = st.st_size;
+  nseg = size ? (size + seg_size - 1) / seg_size : 1;
+  if (nseg > 0x100000000ULL) {
+    result = AEADFILE_INVALID_ARG;
+    goto done;
+  }
+  if ((ofd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+    result = AEADFILE_OPEN_FAIL;
+    goto done;
+  }
+  if ((buf = malloc(SEG_FULL(seg_size))) == NULL) {
+    result = AEADFILE_NO_MEMORY;
+    goto done;
+  }
+
+  memcpy(hdr, AEADFILE_MAGIC, 8);
+  hdr[8] = length;
+  hdr[12] = (seg_size >> 24) & 0xFF;
+  hdr[13] = (seg_size >> 16) & 0xFF;
+  hdr[14] = (seg_size >> 8) & 0xFF;
+  hdr[15] = seg_size & 0xFF;
+  arc4random_buf(hdr + 16, AEADFILE_SALTLEN + 7);
+  if (!write_full(ofd, hdr, AEADFILE_HDRLEN, 0)) {
+    result = AEADFILE_WRITE_FAIL;
+    goto done;
+  }
+
+  file_key(key, length, hdr, fkey);
+  aes_gcm_init(&gcm, fkey, length);
+  memset(fkey, 0, sizeof(fkey));
+  for (i = 0; i < nseg; i++) {
+    size_t n = size - i * seg_size < seg_size ? size - i * seg_size : seg_size;
+    if (!read_full(ifd, buf, n, i * seg_size)) {
+      result = AEADFILE_READ_FAIL;
+      break;
+    }
+    seg_nonce(hdr, i, i == nseg - 1, nonce);
+    aes_gcm_seal(&gcm, nonce, hdr, AEADFILE_HDRLEN, buf, n, buf, buf + n);
+    if (!write_full(ofd, buf, n + GCM_TAGLEN, AEADFILE_HDRLEN + i * SEG_FULL(seg_size))) {
+      result = AEADFILE_WRITE_FAIL;
+      break;
+    }
+  }
+  memset(&gcm, 0, sizeof(gcm));
+  memset(buf, 0, SEG_FULL(seg_size));
+
+done:
+  free(buf);
+  if (ifd >= 0)
+    close(ifd);
+  if (ofd >= 0 && close(ofd) < 0 && result == 0)
+    result = AEADFILE_WRITE_FAIL;
+  return result;
+}
+
+/*
+ * aeadfile_open() - 암호화된 파일을 메모리에 매핑하고 헤더를 검사한다.
+ * 세그먼트 수와 평문 길이는 파일 크기로부터 계산한다. 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int aeadfile_open(aeadfile_t *f, const char *path, const uint8_t *key, int length)
+{
+  const uint8_t *h;
+  uint8_t fkey[KEYLEN_256];
+  struct stat st;
+  uint64_t body, last;
+
+  memset(f, 0, sizeof(aeadfile_t));
+  f->fd = -1;
+  if (path == NULL || key == NULL || length < AES128 || length > AES256)
+    return AEADFILE_INVALID_ARG;
+  if ((f->fd = open(path, O_RDONLY)) < 0 || fstat(f->fd, &st) < 0) {
+    aeadfile_close(f);
+    return AEADFILE_OPEN_FAIL;
+  }
+  if (st.st_size < AEADFILE_HDRLEN + GCM_TAGLEN) {
+    aeadfile_close(f);
+    return AEADFILE_BAD_FORMAT;
+  }
+  f->map_len = st.st_size;
+  f->map = mmap(NULL, f->map_len, PROT_READ, MAP_PRIVATE, f->fd, 0);
+  if (f->map == MAP_FAILED) {
+    f->map = NULL;
+    aeadfile_close(f);
+    return AEADFILE_READ_FAIL;
+  }
+
+  h = f->map;
+  f->seg_size = ((uint32_t)h[12] << 24) | ((uint32_t)h[13] << 16) | ((uint32_t)h[14] << 8) | h[15];
+  if (memcmp(h, AEADFILE_MAGIC, 8) || h[8] != length || h[9] || h[10] || h[11] || h[AEADFILE_HDRLEN - 1]
+      || f->seg_size == 0 || f->seg_size > AEADFILE_MAXSEG) {
+    aeadfile_close(f);
+    return AEADFILE_BAD_FORMAT;
+  }
+  // 마지막 세그먼트는 태그보다 짧을 수 없고 세그먼트 크기보다 길 수 없습니다.
+  body = f->map_len - AEADFILE_HDRLEN;
+  f->nseg = (body + SEG_FULL(f->seg_size) - 1) / SEG_FULL(f->seg_size);
+  last = body - (f->nseg - 1) * SEG_FULL(f->seg_size);
+  if (last < GCM_TAGLEN || f->nseg > 0x100000000ULL) {
+    aeadfile_close(f);
+    return AEADFILE_BAD_FORMAT;
+  }
+  f->pt_len = (f->nseg - 1) * f->seg_size + last - GCM_TAGLEN;
+  file_key(key, length, h, fkey);
+  aes_gcm_init(&f->gcm, fkey, length);
+  memset(fkey, 0, sizeof(fkey));
+  return 0;
+}
+
+/*
+ * aeadfile_read_segment() - idx번째 세그먼트를 매핑 영역에서 바로 검증, 복호화하여 out에 저장한다.
+ * out은 seg_size 바이트 이상이어야 하며 len에 평문 길이를 저장한다.
+ */
+int aeadfile_read_segment(const aeadfile_t *f, uint64_t idx, uint8_t *out, size_t *len)
+{
+  uint8_t nonce[GCM_IVLEN];
+  const uint8_t *seg;
+  size_t n;
+
+  if (idx >= f->nseg)
+    return AEADFILE_INVALID_ARG;
+  seg = f->map + AEADFILE_HDRLEN + idx * SEG_FULL(f->seg_size);
+  n = idx == f->nseg - 1 ? f->pt_len - idx * f->seg_size : f->seg_size;
+  seg_nonce(f->map, idx, idx == f->nseg - 1, nonce);
+  if (aes_gcm_open(&f->gcm, nonce, f->map, AEADFILE_HDRLEN, seg, n, out, seg + n))
+    return AEADFILE_AUTH_FAIL;
+  if (len != NULL)
+    *len = n;
+  return 0;
+}
+
+/*
+ * aeadfile_pread() - 평문의 off 위치부터 len 바이트를 buf에 복호화한다.
+ * 요청 범위에 걸친 세그먼트만 복호화하며 세그먼트 전체가 포함되면 buf에 바로 복호화한다.
+ */
+int aeadfile_pread(const aeadfile_t *f, void *buf, size_t len, uint64_t off)
+{
+  uint8_t *dst = buf, *tmp = NULL;
+  int result = 0;
+
+  if (off > f->pt_len || len > f->pt_len - off)
+    return AEADFILE_INVALID_ARG;
+  while (len > 0) {
+    uint64_t idx = off / f->seg_size;
+    size_t skip = off % f->seg_size, n, seg_len;
+
+    seg_len = idx == f->nseg - 1 ? f->pt_len - idx * f->seg_size : f->seg_size;
+    n = seg_len - skip < len ? seg_len - skip : len;
+    if (skip == 0 && n == seg_len) {
+      result = aeadfile_read_segment(f, idx, dst, NULL);
+    } else {
+      // 세그먼트 일부만 필요하더라도 태그 검증을 위해 세그먼트 전체를 복호화해야 합니다.
+      if (tmp == NULL && (tmp = malloc(f->seg_size)) == NULL) {
+        result = AEADFILE_NO_MEMORY;
+        break;
+      }
+      if ((result = aeadfile_read_segment(f, idx, tmp, NULL)) == 0)
+        memcpy(dst, tmp + skip, n);
+    }
+    if (result)
+      break;
+    dst += n;
+    off += n;
+    len -= n;
+  }
+  if (tmp != NULL) {
+    memset(tmp, 0, f->seg_size);
+    free(tmp);
+  }
+  return result;
+}
+
+typedef struct {
+  const aeadfile_t *f;
+  uint8_t *out;
+  uint64_t first, step;
+  int result;
+} job_t;
+
+static void *decrypt_worker(void *arg)
+{
+  job_t *j = arg;
+
+  for (uint64_t i = j->first; i < j->f->nseg && !j->result; i += j->step)
+    j->result = aeadfile_read_segment(j->f, i, j->out + i * j->f->seg_size, NULL);
+  return NULL;
+}
+
+/*
+ * aeadfile_decrypt_all() - 모든 세그먼트를 nthreads개의 스레드로 나누어 복호화한다.
+ * out은 pt_len 바이트 이상이어야 한다. 하나라도 검증에 실패하면 오류 코드를 넘겨준다.
+ */
+int aeadfile_decrypt_all(const aeadfile_t *f, uint8_t *out, int nthreads)
+{
+  pthread_t th[nthreads > 0 ? nthreads : 1];
+  job_t job[nthreads > 0 ? nthreads : 1];
+  int i, n, result = 0;
+
+  if (nthreads < 1)
+    return AEADFILE_INVALID_ARG;
+  // 스레드 i는 세그먼트 i, i + nthreads, i + 2*nthreads, ...를 맡습니다.
+  // 스레드를 만들지 못한 몫도 아래에서 처리하므로 몫을 모두 채운 뒤에 스레드를 만듭니다.
+  for (n = 0; n < nthreads; n++)
+    job[n] = (job_t){ f, out, n, nthreads, 0 };
+  for (n = 1; n < nthreads; n++)
+    if (pthread_create(&th[n], NULL, decrypt_worker, &job[n]) != 0)
+      break;
+  decrypt_worker(&job[0]);
+  for (i = 1; i < n; i++)
+    pthread_join(th[i], NULL);
+  // 스레드를 만들지 못한 몫은 호출한 스레드가 처리합니다.
+  for (i = n; i < nthreads; i++)
+    decrypt_worker(&job[i]);
+  for (i = 0; i < nthreads; i++)
+    if (job[i].result && !result)
+      result = job[i].result;
+  if (result)
+    memset(out, 0, f->pt_len);
+  return result;
+}
+
+void aeadfile_close(aeadfile_t *f)
+{
+  if (f->map != NULL)
+    munmap((void *)f->map, f->map_len);
+  if (f->fd >= 0)
+    close(f->fd);
+  memset(f, 0, sizeof(aeadfile_t));
+  f->fd = -1;
+}
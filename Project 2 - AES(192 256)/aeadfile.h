@@ -0,0 +1,72 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _AEADFILE_H_
+#define _AEADFILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "gcm.h"
+
+/*
+ * 세그먼트 단위 AES-GCM 파일 형식
+ *
+ *   헤더(AEADFILE_HDRLEN 바이트)
+ *     magic[8] = "AEADSEG2" | 키 길이 색인(1) | 예약(3) = 0 | 세그먼트 크기(4, 빅 엔디안)
+ *     | salt(AEADFILE_SALTLEN) | nonce 접두사(7) | 예약(1) = 0
+ *   세그먼트 0 .. n-1
+ *     암호문(세그먼트 크기, 마지막 세그먼트는 0 ~ 세그먼트 크기) || 태그(GCM_TAGLEN)
+ *
+ * 세그먼트는 주어진 키가 아니라 파일 키로 암호화한다. 파일 키는 HKDF-SHA256(IKM = 키, salt, info = 헤더의
+ * 앞 16바이트)의 앞 키 길이 바이트이고 salt는 파일마다 새로 뽑는 난수이다. 세그먼트 i의 nonce는
+ * nonce 접두사(7) || i(4, 빅 엔디안) || 마지막 세그먼트 플래그(1)이며 헤더 전체를 AAD로 인증한다.
+ * 마지막 세그먼트만 플래그가 1이므로 세그먼트 경계에서 잘린 파일도 검증에 실패한다. 세그먼트마다
+ * 독립적으로 복호화할 수 있어 임의 위치 읽기와 병렬 복호화가 가능하다.
+ *
+ * 한계: nonce의 무작위 부분은 56비트뿐이어서 한 키로 직접 암호화하면 약 2^28개 파일부터 nonce가 겹칠
+ * 확률을 무시할 수 없다. 그래서 파일마다 256비트 salt로 다른 키를 유도하고, 한 파일 안에서는 세그먼트
+ * 번호로 nonce가 겹치지 않게 한다. 같은 키로 2^64개 파일을 암호화해도 두 파일의 salt가 겹칠 확률은
+ * 2^-128 이하이다. 한 파일은 최대 2^32개 세그먼트, 세그먼트 하나는 최대 AEADFILE_MAXSEG 바이트이다.
+ */
+#define AEADFILE_MAGIC   "AEADSEG2"
+#define AEADFILE_SALTLEN 32
+#define AEADFILE_HDRLEN  (24 + AEADFILE_SALTLEN)
+#define AEADFILE_SEGSIZE (64 * 1024)  /* 기본 세그먼트 크기 */
+#define AEADFILE_MAXSEG  (1u << 30)
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define AEADFILE_INVALID_ARG 1
+#define AEADFILE_OPEN_FAIL   2
+#define AEADFILE_READ_FAIL   3
+#define AEADFILE_WRITE_FAIL  4
+#define AEADFILE_BAD_FORMAT  5
+#define AEADFILE_AUTH_FAIL   6
+#define AEADFILE_NO_MEMORY   7
+
+/*
+ * 읽기 문맥: 파일 전체를 읽기 전용으로 메모리에 매핑하고 세그먼트를 매핑 영역에서 바로 복호화한다.
+ */
+typedef struct {
+    int fd;
+    const uint8_t *map;
+    size_t map_len;
+    uint32_t seg_size;
+    uint64_t nseg;
+    uint64_t pt_len;   /* 평문 전체 길이 */
+    gcm_ctx_t gcm;
+} aeadfile_t;
+
+int aeadfile_seal(const char *in, const char *out, const uint8_t *key, int length, uint32_t seg_size);
+int aeadfile_open(aeadfile_t *f, const char *path, const uint8_t *key, int length);
+int aeadfile_read_segment(const aeadfile_t *f, uint64_t idx, uint8_t *out, size_t *len);
+int aeadfile_pread(const aeadfile_t *f, void *buf, size_t len, uint64_t off);
+int aeadfile_decrypt_all(const aeadfile_t *f, uint8_t *out, int nthreads);
+void aeadfile_close(aeadfile_t *f);
+
+#endif
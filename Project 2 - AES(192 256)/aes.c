@@ -10,6 +10,10 @@
 #include "aes.h"
 #include <endian.h>
 #include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GF8_X86
+#endif
 
 static const uint8_t sbox[256] = {
   0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
@@ -53,6 +57,64 @@ static const uint8_t M[16] = {2, 3, 1, 1, 1, 2, 3, 1, 1, 1, 2, 3, 3, 1, 1, 2};
 
 static const uint8_t IM[16] = {0x0e, 0x0b, 0x0d, 0x09, 0x09, 0x0e, 0x0b, 0x0d, 0x0d, 0x09, 0x0e, 0x0b, 0x0b, 0x0d, 0x09, 0x0e};
 
+// GF(2^8)의 생성원 {03}에 대한 로그 테이블입니다. gf_log[0]은 값이 의미 없으며 gf8_mul에서 마스크로 결과를 지웁니다.
+static const uint8_t gf_log[256] = {
+  0x00, 0x00, 0x19, 0x01, 0x32, 0x02, 0x1a, 0xc6, 0x4b, 0xc7, 0x1b, 0x68, 0x33, 0xee, 0xdf, 0x03,
+  0x64, 0x04, 0xe0, 0x0e, 0x34, 0x8d, 0x81, 0xef, 0x4c, 0x71, 0x08, 0xc8, 0xf8, 0x69, 0x1c, 0xc1,
+  0x7d, 0xc2, 0x1d, 0xb5, 0xf9, 0xb9, 0x27, 0x6a, 0x4d, 0xe4, 0xa6, 0x72, 0x9a, 0xc9, 0x09, 0x78,
+  0x65, 0x2f, 0x8a, 0x05, 0x21, 0x0f, 0xe1, 0x24, 0x12, 0xf0, 0x82, 0x45, 0x35, 0x93, 0xda, 0x8e,
+  0x96, 0x8f, 0xdb, 0xbd, 0x36, 0xd0, 0xce, 0x94, 0x13, 0x5c, 0xd2, 0xf1, 0x40, 0x46, 0x83, 0x38,
+  0x66, 0xdd, 0xfd, 0x30, 0xbf, 0x06, 0x8b, 0x62, 0xb3, 0x25, 0xe2, 0x98, 0x22, 0x88, 0x91, 0x10,
+  0x7e, 0x6e, 0x48, 0xc3, 0xa3, 0xb6, 0x1e, 0x42, 0x3a, 0x6b, 0x28, 0x54, 0xfa, 0x85, 0x3d, 0xba,
+  0x2b, 0x79, 0x0a, 0x15, 0x9b, 0x9f, 0x5e, 0xca, 0x4e, 0xd4, 0xac, 0xe5, 0xf3, 0x73, 0xa7, 0x57,
+  0xaf, 0x58, 0xa8, 0x50, 0xf4, 0xea, 0xd6, 0x74, 0x4f, 0xae, 0xe9, 0xd5, 0xe7, 0xe6, 0xad, 0xe8,
+  0x2c, 0xd7, 0x75, 0x7a, 0xeb, 0x16, 0x0b, 0xf5, 0x59, 0xcb, 0x5f, 0xb0, 0x9c, 0xa9, 0x51, 0xa0,
+  0x7f, 0x0c, 0xf6, 0x6f, 0x17, 0xc4, 0x49, 0xec, 0xd8, 0x43, 0x1f, 0x2d, 0xa4, 0x76, 0x7b, 0xb7,
+  0xcc, 0xbb, 0x3e, 0x5a, 0xfb, 0x60, 0xb1, 0x86, 0x3b, 0x52, 0xa1, 0x6c, 0xaa, 0x55, 0x29, 0x9d,
+  0x97, 0xb2, 0x87, 0x90, 0x61, 0xbe, 0xdc, 0xfc, 0xbc, 0x95, 0xcf, 0xcd, 0x37, 0x3f, 0x5b, 0xd1,
+  0x53, 0x39, 0x84, 0x3c, 0x41, 0xa2, 0x6d, 0x47, 0x14, 0x2a, 0x9e, 0x5d, 0x56, 0xf2, 0xd3, 0xab,
+  0x44, 0x11, 0x92, 0xd9, 0x23, 0x20, 0x2e, 0x89, 0xb4, 0x7c, 0xb8, 0x26, 0x77, 0x99, 0xe3, 0xa5,
+  0x67, 0x4a, 0xed, 0xde, 0xc5, 0x31, 0xfe, 0x18, 0x0d, 0x63, 0x8c, 0x80, 0xc0, 0xf7, 0x70, 0x07 };
+
+// 지수 테이블입니다. 두 로그의 합(최대 508)을 mod 255 없이 바로 조회할 수 있도록 510개를 둡니다.
+static const uint8_t gf_alog[510] = {
+  0x01, 0x03, 0x05, 0x0f, 0x11, 0x33, 0x55, 0xff, 0x1a, 0x2e, 0x72, 0x96, 0xa1, 0xf8, 0x13, 0x35,
+  0x5f, 0xe1, 0x38, 0x48, 0xd8, 0x73, 0x95, 0xa4, 0xf7, 0x02, 0x06, 0x0a, 0x1e, 0x22, 0x66, 0xaa,
+  0xe5, 0x34, 0x5c, 0xe4, 0x37, 0x59, 0xeb, 0x26, 0x6a, 0xbe, 0xd9, 0x70, 0x90, 0xab, 0xe6, 0x31,
+  0x53, 0xf5, 0x04, 0x0c, 0x14, 0x3c, 0x44, 0xcc, 0x4f, 0xd1, 0x68, 0xb8, 0xd3, 0x6e, 0xb2, 0xcd,
+  0x4c, 0xd4, 0x67, 0xa9, 0xe0, 0x3b, 0x4d, 0xd7, 0x62, 0xa6, 0xf1, 0x08, 0x18, 0x28, 0x78, 0x88,
+  0x83, 0x9e, 0xb9, 0xd0, 0x6b, 0xbd, 0xdc, 0x7f, 0x81, 0x98, 0xb3, 0xce, 0x49, 0xdb, 0x76, 0x9a,
+  0xb5, 0xc4, 0x57, 0xf9, 0x10, 0x30, 0x50, 0xf0, 0x0b, 0x1d, 0x27, 0x69, 0xbb, 0xd6, 0x61, 0xa3,
+  0xfe, 0x19, 0x2b, 0x7d, 0x87, 0x92, 0xad, 0xec, 0x2f, 0x71, 0x93, 0xae, 0xe9, 0x20, 0x60, 0xa0,
+  0xfb, 0x16, 0x3a, 0x4e, 0xd2, 0x6d, 0xb7, 0xc2, 0x5d, 0xe7, 0x32, 0x56, 0xfa, 0x15, 0x3f, 0x41,
+  0xc3, 0x5e, 0xe2, 0x3d, 0x47, 0xc9, 0x40, 0xc0, 0x5b, 0xed, 0x2c, 0x74, 0x9c, 0xbf, 0xda, 0x75,
+  0x9f, 0xba, 0xd5, 0x64, 0xac, 0xef, 0x2a, 0x7e, 0x82, 0x9d, 0xbc, 0xdf, 0x7a, 0x8e, 0x89, 0x80,
+  0x9b, 0xb6, 0xc1, 0x58, 0xe8, 0x23, 0x65, 0xaf, 0xea, 0x25, 0x6f, 0xb1, 0xc8, 0x43, 0xc5, 0x54,
+  0xfc, 0x1f, 0x21, 0x63, 0xa5, 0xf4, 0x07, 0x09, 0x1b, 0x2d, 0x77, 0x99, 0xb0, 0xcb, 0x46, 0xca,
+  0x45, 0xcf, 0x4a, 0xde, 0x79, 0x8b, 0x86, 0x91, 0xa8, 0xe3, 0x3e, 0x42, 0xc6, 0x51, 0xf3, 0x0e,
+  0x12, 0x36, 0x5a, 0xee, 0x29, 0x7b, 0x8d, 0x8c, 0x8f, 0x8a, 0x85, 0x94, 0xa7, 0xf2, 0x0d, 0x17,
+  0x39, 0x4b, 0xdd, 0x7c, 0x84, 0x97, 0xa2, 0xfd, 0x1c, 0x24, 0x6c, 0xb4, 0xc7, 0x52, 0xf6, 0x01,
+  0x03, 0x05, 0x0f, 0x11, 0x33, 0x55, 0xff, 0x1a, 0x2e, 0x72, 0x96, 0xa1, 0xf8, 0x13, 0x35, 0x5f,
+  0xe1, 0x38, 0x48, 0xd8, 0x73, 0x95, 0xa4, 0xf7, 0x02, 0x06, 0x0a, 0x1e, 0x22, 0x66, 0xaa, 0xe5,
+  0x34, 0x5c, 0xe4, 0x37, 0x59, 0xeb, 0x26, 0x6a, 0xbe, 0xd9, 0x70, 0x90, 0xab, 0xe6, 0x31, 0x53,
+  0xf5, 0x04, 0x0c, 0x14, 0x3c, 0x44, 0xcc, 0x4f, 0xd1, 0x68, 0xb8, 0xd3, 0x6e, 0xb2, 0xcd, 0x4c,
+  0xd4, 0x67, 0xa9, 0xe0, 0x3b, 0x4d, 0xd7, 0x62, 0xa6, 0xf1, 0x08, 0x18, 0x28, 0x78, 0x88, 0x83,
+  0x9e, 0xb9, 0xd0, 0x6b, 0xbd, 0xdc, 0x7f, 0x81, 0x98, 0xb3, 0xce, 0x49, 0xdb, 0x76, 0x9a, 0xb5,
+  0xc4, 0x57, 0xf9, 0x10, 0x30, 0x50, 0xf0, 0x0b, 0x1d, 0x27, 0x69, 0xbb, 0xd6, 0x61, 0xa3, 0xfe,
+  0x19, 0x2b, 0x7d, 0x87, 0x92, 0xad, 0xec, 0x2f, 0x71, 0x93, 0xae, 0xe9, 0x20, 0x60, 0xa0, 0xfb,
+  0x16, 0x3a, 0x4e, 0xd2, 0x6d, 0xb7, 0xc2, 0x5d, 0xe7, 0x32, 0x56, 0xfa, 0x15, 0x3f, 0x41, 0xc3,
+  0x5e, 0xe2, 0x3d, 0x47, 0xc9, 0x40, 0xc0, 0x5b, 0xed, 0x2c, 0x74, 0x9c, 0xbf, 0xda, 0x75, 0x9f,
+  0xba, 0xd5, 0x64, 0xac, 0xef, 0x2a, 0x7e, 0x82, 0x9d, 0xbc, 0xdf, 0x7a, 0x8e, 0x89, 0x80, 0x9b,
+  0xb6, 0xc1, 0x58, 0xe8, 0x23, 0x65, 0xaf, 0xea, 0x25, 0x6f, 0xb1, 0xc8, 0x43, 0xc5, 0x54, 0xfc,
+  0x1f, 0x21, 0x63, 0xa5, 0xf4, 0x07, 0x09, 0x1b, 0x2d, 0x77, 0x99, 0xb0, 0xcb, 0x46, 0xca, 0x45,
+  0xcf, 0x4a, 0xde, 0x79, 0x8b, 0x86, 0x91, 0xa8, 0xe3, 0x3e, 0x42, 0xc6, 0x51, 0xf3, 0x0e, 0x12,
+  0x36, 0x5a, 0xee, 0x29, 0x7b, 0x8d, 0x8c, 0x8f, 0x8a, 0x85, 0x94, 0xa7, 0xf2, 0x0d, 0x17, 0x39,
+  0x4b, 0xdd, 0x7c, 0x84, 0x97, 0xa2, 0xfd, 0x1c, 0x24, 0x6c, 0xb4, 0xc7, 0x52, 0xf6 };
+
+// gf8_mul_region의 pshufb용 테이블입니다. gf_nib[c][0][i] = c * i, gf_nib[c][1][i] = c * (i << 4)이며
+// 곱셈이 XOR에 대해 분배되므로 c * x = gf_nib[c][0][x & 0xf] ^ gf_nib[c][1][x >> 4]입니다.
+static uint8_t gf_nib[256][2][16] __attribute__((aligned(16)));
+
 /*
  * Generate an AES key schedule
  */
@@ -201,48 +263,126 @@ static void ShiftRows(uint8_t *state, int mode) {
 }
 
 // 주어진 두 수 a, b를 곱하고 결과를 기약 다항식 𝑥^8 + 𝑥^4 + 𝑥^3 + 𝑥 + 1로 나눈 나머지를 구합니다.
-// MixColums 함수에서 사용됩니다.
+// a = {03}^i, b = {03}^j이면 a * b = {03}^(i+j)이므로 로그/지수 테이블을 한 번씩 조회하여 구할 수 있습니다.
+// 0은 로그가 정의되지 않으므로 일단 gf_log[0]으로 조회한 뒤, 둘 중 하나라도 0이면 마스크로 결과를 지웁니다.
+// 입력이 0인지에 따라 분기하지 않으므로 비밀 값을 곱해도 실행 경로가 달라지지 않습니다.
 uint8_t gf8_mul(uint8_t a, uint8_t b)
-{   
-    // 계산한 나머지를 담을 변수를 초기화합니다.
-    uint8_t r = 0;
+{
+    uint8_t mask = -(uint8_t)((a != 0) & (b != 0));
+    return gf_alog[gf_log[a] + gf_log[b]] & mask;
+}
+
+// gf_nib 테이블을 사용하는 범용 구현입니다. dst[i] ^= c * src[i]
+// SIMD 구현과 같이 니블마다 16바이트 행 하나만 조회하므로 src나 c가 0인지에 따라 분기하지 않습니다.
+static void gf8_mul_region_c(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+{
+    const uint8_t *lo = gf_nib[c][0], *hi = gf_nib[c][1];
+    for (size_t i = 0; i < len; i++)
+        dst[i] ^= lo[src[i] & 0xf] ^ hi[src[i] >> 4];
+}
+
+#ifdef GF8_X86
+// 16바이트씩 하위/상위 니블로 나누어 pshufb로 테이블을 조회하고 두 결과를 XOR합니다.
+__attribute__((target("ssse3")))
+static void gf8_mul_region_ssse3(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+{
+    const __m128i tlo = _mm_load_si128((const __m128i *)gf_nib[c][0]);
+    const __m128i thi = _mm_load_si128((const __m128i *)gf_nib[c][1]);
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
 
-    // b가 0보다 클 동안 곱하기(XOR + shift)를 반복합니다.
-    while (b > 0) {
-        // coefficient가 1인 경우에만 XOR합니다.
-        if (b & 1) 
-            r = r ^ a;
-        // b를 왼쪽으로 한 칸 shift 합니다(곱셈 횟수 차감, 시간복잡도를 log 스케일로 줄일 수 있음).
-        b = b >> 1;
-        a = XTIME(a);
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_and_si128(x, mask);
+        __m128i hi = _mm_and_si128(_mm_srli_epi64(x, 4), mask);
+        __m128i p = _mm_xor_si128(_mm_shuffle_epi8(tlo, lo), _mm_shuffle_epi8(thi, hi));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(_mm_loadu_si128((const __m128i *)(dst + i)), p));
     }
-    // 계산된 나머지를 반환합니다.
-    return r;
+    gf8_mul_region_c(dst + i, src + i, c, len - i);
+}
+
+// AVX2는 vpshufb가 128비트 lane마다 동작하므로 테이블을 두 lane에 복사해서 32바이트씩 처리합니다.
+__attribute__((target("avx2")))
+static void gf8_mul_region_avx2(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+{
+    const __m256i tlo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)gf_nib[c][0]));
+    const __m256i thi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)gf_nib[c][1]));
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i lo = _mm256_and_si256(x, mask);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi64(x, 4), mask);
+        __m256i p = _mm256_xor_si256(_mm256_shuffle_epi8(tlo, lo), _mm256_shuffle_epi8(thi, hi));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(dst + i)), p));
+    }
+    // 남은 16바이트는 여기서 VEX 인코딩으로 처리합니다. SSSE3 함수로 넘기면 AVX/SSE 전환 비용이 생깁니다.
+    if (i + 16 <= len) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_and_si128(x, _mm256_castsi256_si128(mask));
+        __m128i hi = _mm_and_si128(_mm_srli_epi64(x, 4), _mm256_castsi256_si128(mask));
+        __m128i p = _mm_xor_si128(_mm_shuffle_epi8(_mm256_castsi256_si128(tlo), lo),
+                                  _mm_shuffle_epi8(_mm256_castsi256_si128(thi), hi));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(_mm_loadu_si128((const __m128i *)(dst + i)), p));
+        i += 16;
+    }
+    _mm256_zeroupper();
+    gf8_mul_region_c(dst + i, src + i, c, len - i);
+}
+#endif
+
+static void (*gf8_mul_region_impl)(uint8_t *, const uint8_t *, uint8_t, size_t) = gf8_mul_region_c;
+
+// 프로그램이 시작될 때 pshufb용 테이블을 만들고 CPU가 지원하는 구현을 선택합니다.
+__attribute__((constructor))
+static void gf8_init(void)
+{
+    for (int c = 0; c < 256; c++)
+        for (int i = 0; i < 16; i++) {
+            gf_nib[c][0][i] = gf8_mul(c, i);
+            gf_nib[c][1][i] = gf8_mul(c, i << 4);
+        }
+#ifdef GF8_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        gf8_mul_region_impl = gf8_mul_region_avx2;
+    else if (__builtin_cpu_supports("ssse3"))
+        gf8_mul_region_impl = gf8_mul_region_ssse3;
+#endif
+}
+
+// 길이가 len인 src의 각 바이트에 c를 곱해 dst에 XOR로 누적합니다. dst[i] ^= c * src[i]
+void gf8_mul_region(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+{
+    gf8_mul_region_impl(dst, src, c, len);
 }
 
 // 기약 다항식 𝑥^8 + 𝑥^4 + 𝑥^3 + 𝑥 + 1을 사용한 GF(2^8)에서 행렬곱셈을 수행합니다.
+// 각 열의 바이트를 위로 k칸 회전한 state를 rot[k-1]에 만들어 두면 행렬곱셈은
+// state 전체(16바이트)에 대한 상수 곱셈 4번의 XOR이 되므로 gf8_mul_region으로 한 번에 계산할 수 있습니다.
+// ex. 암호화: state' = {02}*state ^ {03}*rot1 ^ rot2 ^ rot3
 static void MixColumns(uint8_t *state, int mode) {
   // state를 그대로 사용하면 계산 중 값이 변동되므로 계산을 위해 t_state라는 변수를 새로 만들고 state의 값을 t_state에 저장합니다. 
-  uint8_t t_state[BLOCKLEN];
+  uint8_t t_state[BLOCKLEN], rot[3][BLOCKLEN];
   memcpy(t_state, state, BLOCKLEN);
-  // 모드가 ENCRYPT인 경우
+  for (int i = 0 ; i < Nb ; i++)
+    for (int r = 0 ; r < 4 ; r++)
+      for (int k = 1 ; k < 4 ; k++)
+        rot[k-1][Nb*i+r] = t_state[Nb*i + ((r+k) & 3)];
+  // 모드가 ENCRYPT인 경우 M의 첫 행 {02, 03, 01, 01}을 사용합니다.
   if (mode > 0) {
-    // state(4 x 4 행렬로 가정)를 세로로 한 줄씩 읽어서 각 byte를 gf8_mul 함수를 이용하여 M[16]의 원소들과 차례대로 곱한 후 XOR 해줍니다.
-    for (int i = 0 ; i < Nb; i++) {
-      state[Nb*i+0] = gf8_mul(t_state[Nb*i+0], M[0]) ^ gf8_mul(t_state[Nb*i+1], M[1]) ^ t_state[Nb*i+2] ^ t_state[Nb*i+3];
-      state[Nb*i+1] = t_state[Nb*i+0] ^ gf8_mul(t_state[Nb*i+1], M[5]) ^ gf8_mul(t_state[Nb*i+2], M[6]) ^ t_state[Nb*i+3];
-      state[Nb*i+2] = t_state[Nb*i+0] ^ t_state[Nb*i+1] ^ gf8_mul(t_state[Nb*i+2], M[10]) ^ gf8_mul(t_state[Nb*i+3], M[11]);
-      state[Nb*i+3] = gf8_mul(t_state[Nb*i+0], M[12]) ^ t_state[Nb*i+1] ^ t_state[Nb*i+2] ^ gf8_mul(t_state[Nb*i+3], M[15]);
-    }
-  // 모드가 DECRYPT인 경우
+    for (int i = 0 ; i < BLOCKLEN ; i++)
+      state[i] = rot[1][i] ^ rot[2][i];
+    gf8_mul_region(state, t_state, M[0], BLOCKLEN);
+    gf8_mul_region(state, rot[0], M[1], BLOCKLEN);
+  // 모드가 DECRYPT인 경우 IM의 첫 행 {0e, 0b, 0d, 09}를 사용합니다.
   } else {
-    // state(4 x 4 행렬로 가정)를 세로로 한 줄씩 읽어서 각 byte를 gf8_mul 함수를 이용하여 IM[16]의 원소들과 차례대로 곱한 후 XOR 해줍니다.
-    for (int i = 0 ; i < Nb; i++) {
-      state[Nb*i+0] = gf8_mul(t_state[Nb*i+0], IM[0]) ^ gf8_mul(t_state[Nb*i+1], IM[1]) ^ gf8_mul(t_state[Nb*i+2], IM[2]) ^ gf8_mul(t_state[Nb*i+3], IM[3]);
-      state[Nb*i+1] = gf8_mul(t_state[Nb*i+0], IM[4]) ^ gf8_mul(t_state[Nb*i+1], IM[5]) ^ gf8_mul(t_state[Nb*i+2], IM[6]) ^ gf8_mul(t_state[Nb*i+3], IM[7]);
-      state[Nb*i+2] = gf8_mul(t_state[Nb*i+0], IM[8]) ^ gf8_mul(t_state[Nb*i+1], IM[9]) ^ gf8_mul(t_state[Nb*i+2], IM[10]) ^ gf8_mul(t_state[Nb*i+3], IM[11]);
-      state[Nb*i+3] = gf8_mul(t_state[Nb*i+0], IM[12]) ^ gf8_mul(t_state[Nb*i+1], IM[13]) ^ gf8_mul(t_state[Nb*i+2], IM[14]) ^ gf8_mul(t_state[Nb*i+3], IM[15]);
-    }
+    memset(state, 0, BLOCKLEN);
+    gf8_mul_region(state, t_state, IM[0], BLOCKLEN);
+    gf8_mul_region(state, rot[0], IM[1], BLOCKLEN);
+    gf8_mul_region(state, rot[1], IM[2], BLOCKLEN);
+    gf8_mul_region(state, rot[2], IM[3], BLOCKLEN);
   }
 }
 
@@ -8,6 +8,7 @@
 #ifndef _AES_H_
 #define _AES_H_
 
+#include <stddef.h>
 #include <stdint.h>
 /*
  * AES128 (128 비트 키, 10 라운드): Nb = 4, Nk = 4, Nr = 10
@@ -43,5 +44,7 @@
 
 void KeyExpansion(const uint8_t *key, uint32_t *roundKey, int length);
 void Cipher(uint8_t *state, const uint32_t *roundKey, int mode, int length);
+uint8_t gf8_mul(uint8_t a, uint8_t b);
+void gf8_mul_region(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len);
 
 #endif
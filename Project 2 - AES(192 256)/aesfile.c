@@ -0,0 +1,192 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "aes.h"
+#include "filecrypt.h"
+#include "aeadfile.h"
+#include "encreader.h"
+
+/*
+ * AES 파일 암복호화 도구
+ * 사용법: aesfile [-d] [-g | -x] [-r 위치:길이] -k <16진수 키> [-c 청크(KiB)] [-q 링 깊이] [-t 암호화 스레드] [-i I/O 스레드] [-p] 입력 출력
+ * 키의 길이(16, 24, 32바이트)로 AES128/192/256을 선택하고 -p를 주면 io_uring 대신 pread를 사용한다.
+ * -g를 주면 세그먼트 단위 AES-GCM 형식(aeadfile.h)을 사용하며 -c가 세그먼트 크기가 된다.
+ * -x를 주면 XTS 형식(encreader.h)을 사용하며 키는 데이터 키와 트윅 키를 이어 붙인 것이다.
+ * -d와 함께 -r을 주면 CTR 또는 XTS 파일에서 평문의 해당 범위만 복호화한다.
+ */
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-d] [-g | -x] [-r off:len] -k hexkey [-c chunk_kib] [-q depth] [-t threads] [-i io_threads] [-p] in out\n", prog);
+    exit(2);
+}
+
+/*
+ * 세그먼트 단위 GCM 파일을 복호화한다. 출력 파일도 메모리에 매핑하여
+ * 입력 매핑 영역에서 출력 매핑 영역으로 여러 스레드가 바로 복호화한다.
+ */
+static int gcm_decrypt(const char *in, const char *out, const uint8_t *key, int length, int nthreads)
+{
+    aeadfile_t f;
+    uint8_t *dst = NULL;
+    int fd, val;
+
+    if ((val = aeadfile_open(&f, in, key, length)) != 0)
+        return val;
+    if ((fd = open(out, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0 || ftruncate(fd, f.pt_len) < 0) {
+        val = AEADFILE_OPEN_FAIL;
+    } else if (f.pt_len > 0
+               && (dst = mmap(NULL, f.pt_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        dst = NULL;
+        val = AEADFILE_WRITE_FAIL;
+    } else if (f.pt_len > 0) {
+        val = aeadfile_decrypt_all(&f, dst, nthreads);
+        munmap(dst, f.pt_len);
+    }
+    if (fd >= 0) {
+        if (val)
+            ftruncate(fd, 0);
+        close(fd);
+    }
+    aeadfile_close(&f);
+    return val;
+}
+
+/*
+ * CTR 또는 XTS 파일의 평문 [off, off + len)을 encreader로 복호화하여 out에 저장한다.
+ * len이 0이면 off부터 파일 끝까지이며, 순차로 읽으므로 read-ahead가 동작한다.
+ */
+static int reader_decrypt(const char *in, const char *out, const uint8_t *key, int length, int format,
+                          uint64_t off, uint64_t len)
+{
+    encreader_t r;
+    uint8_t *buf;
+    FILE *fp;
+    int val;
+
+    if ((val = encreader_open(&r, in, format, key, length, NULL)) != 0)
+        return val;
+    if (off > r.size) {
+        encreader_close(&r);
+        return ENCREADER_INVALID_ARG;
+    }
+    if (len == 0)
+        len = r.size - off;
+    if ((fp = fopen(out, "wb")) == NULL || (buf = malloc(64 * ENCREADER_PAGE)) == NULL) {
+        if (fp != NULL)
+            fclose(fp);
+        encreader_close(&r);
+        return fp == NULL ? ENCREADER_OPEN_FAIL : ENCREADER_NO_MEMORY;
+    }
+    while (len > 0 && val == 0) {
+        size_t n = len < 64 * ENCREADER_PAGE ? len : 64 * ENCREADER_PAGE;
+        if ((val = encreader_pread(&r, buf, n, off)) == 0 && fwrite(buf, 1, n, fp) != n)
+            val = ENCREADER_WRITE_FAIL;
+        off += n;
+        len -= n;
+    }
+    if (fclose(fp) != 0 && val == 0)
+        val = ENCREADER_WRITE_FAIL;
+    free(buf);
+    encreader_close(&r);
+    return val;
+}
+
+// 키의 길이로 AES128/192/256을 정합니다. XTS이면 두 키를 이어 붙였으므로 길이가 두 배입니다.
+static int parse_key(const char *hex, uint8_t *key, int xts)
+{
+    size_t n = strlen(hex) >> xts;
+    unsigned int b;
+
+    if (n != 2*KEYLEN && n != 2*KEYLEN + 16 && n != 2*KEYLEN_256)
+        return -1;
+    for (size_t i = 0; i < (n << xts) / 2; i++) {
+        if (sscanf(hex + 2*i, "%2x", &b) != 1)
+            return -1;
+        key[i] = b;
+    }
+    return n == 2*KEYLEN ? AES128 : n == 2*KEYLEN_256 ? AES256 : AES192;
+}
+
+int main(int argc, char *argv[])
+{
+    filecrypt_opt_t opt;
+    filecrypt_stat_t st;
+    uint8_t key[2*KEYLEN_256];
+    unsigned long long roff = 0, rlen = 0;
+    const char *hexkey = NULL;
+    int c, length = -1, mode = ENCRYPT, gcm = 0, xts = 0, range = 0, val;
+
+    filecrypt_default(&opt);
+    while ((c = getopt(argc, argv, "dgxr:k:c:q:t:i:p")) != -1) {
+        switch (c) {
+        case 'd': mode = DECRYPT; break;
+        case 'g': gcm = 1; break;
+        case 'x': xts = 1; break;
+        case 'r':
+            if (sscanf(optarg, "%llu:%llu", &roff, &rlen) != 2)
+                usage(argv[0]);
+            range = 1;
+            break;
+        case 'k': hexkey = optarg; break;
+        case 'c': opt.chunk_size = (size_t)atol(optarg) * 1024; break;
+        case 'q': opt.depth = atoi(optarg); break;
+        case 't': opt.nthreads = atoi(optarg); break;
+        case 'i': opt.io_threads = atoi(optarg); break;
+        case 'p': opt.use_uring = 0; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (hexkey != NULL)
+        length = parse_key(hexkey, key, xts);
+    if (length < 0 || argc - optind != 2 || (gcm && xts) || (range && (gcm || mode == ENCRYPT)))
+        usage(argv[0]);
+
+    if (xts || range) {
+        if (mode == ENCRYPT)
+            val = encreader_xts_seal(argv[optind], argv[optind+1], key, length);
+        else
+            val = reader_decrypt(argv[optind], argv[optind+1], key, length,
+                                 xts ? ENCREADER_XTS : ENCREADER_CTR, roff, rlen);
+        memset(key, 0, sizeof(key));
+        if (val) {
+            fprintf(stderr, "encreader error: %d\n", val);
+            return 1;
+        }
+        return 0;
+    }
+
+    if (gcm) {
+        if (mode == ENCRYPT)
+            val = aeadfile_seal(argv[optind], argv[optind+1], key, length, opt.chunk_size);
+        else
+            val = gcm_decrypt(argv[optind], argv[optind+1], key, length, opt.nthreads);
+        memset(key, 0, sizeof(key));
+        if (val) {
+            fprintf(stderr, "aeadfile error: %d\n", val);
+            return 1;
+        }
+        return 0;
+    }
+
+    val = filecrypt(argv[optind], argv[optind+1], key, length, mode, &opt, &st);
+    memset(key, 0, sizeof(key));
+    if (val) {
+        fprintf(stderr, "filecrypt error: %d\n", val);
+        return 1;
+    }
+    printf("%s %llu bytes in %llu chunks, %.4f s, %.2f MB/s\n",
+           mode == ENCRYPT ? "encrypted" : "decrypted",
+           (unsigned long long)st.bytes, (unsigned long long)st.nchunks, st.seconds, st.throughput);
+    printf("I/O: %s, queue depth avg %.2f max %d\n",
+           st.uring ? "io_uring" : "pread", st.avg_qdepth, st.max_qdepth);
+    return 0;
+}
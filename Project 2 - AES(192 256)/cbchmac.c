@@ -0,0 +1,181 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include "cbchmac.h"
+#include <string.h>
+
+/*
+ * 블록 단위로 섞어서 수행하는 SHA-256 압축 상태입니다.
+ * 암호문 블록이 ctx->block에 64바이트 모이면 메시지 스케줄을 만들어 두고, 이후 AES 블록을 하나 처리할 때마다
+ * 압축 함수를 16라운드씩 진행합니다. AES 4블록이 SHA-256 1블록이므로 다음 64바이트가 모일 때 압축이 끝납니다.
+ * CBC의 AES 연산과 SHA-256 라운드는 서로 의존하지 않으므로 CPU가 두 연산을 겹쳐서 실행할 수 있습니다.
+ */
+typedef struct {
+  sha256_ctx *ctx;
+  uint32 w[64], wv[8];
+  int round;          /* 다음에 수행할 라운드, 64이면 진행 중인 압축이 없음 */
+} stitch_t;
+
+static void stitch_step(stitch_t *st)
+{
+  if (st->round >= 64)
+    return;
+  sha256_round16(st->wv, st->w, st->round);
+  st->round += 16;
+  if (st->round == 64)
+    for (int i = 0; i < 8; i++)
+      st->ctx->h[i] += st->wv[i];
+}
+
+// 암호문 블록 하나를 SHA-256 입력으로 추가합니다. A || IV의 길이에 따라 블록 경계가 어긋날 수 있습니다.
+static void stitch_push(stitch_t *st, const uint8_t *blk)
+{
+  sha256_ctx *ctx = st->ctx;
+  size_t n = SHA256_BLOCK_SIZE - ctx->len < BLOCKLEN ? SHA256_BLOCK_SIZE - ctx->len : BLOCKLEN;
+
+  memcpy(ctx->block + ctx->len, blk, n);
+  ctx->len += n;
+  if (ctx->len < SHA256_BLOCK_SIZE)
+    return;
+  while (st->round < 64)
+    stitch_step(st);
+  sha256_sched(ctx->block, st->w);
+  memcpy(st->wv, ctx->h, sizeof(st->wv));
+  st->round = 0;
+  ctx->tot_len += SHA256_BLOCK_SIZE;
+  ctx->len = BLOCKLEN - n;
+  memcpy(ctx->block, blk + n, ctx->len);
+}
+
+static void stitch_begin(stitch_t *st, sha256_ctx *ictx, const cbchmac_ctx_t *ctx,
+                         const uint8_t *iv, const uint8_t *aad, size_t aad_len)
+{
+  *ictx = ctx->ipad;
+  sha256_update(ictx, aad, aad_len);
+  sha256_update(ictx, iv, BLOCKLEN);
+  st->ctx = ictx;
+  st->round = 64;
+}
+
+// 남은 압축을 끝내고 AL을 더해 HMAC을 완성한 후 앞 CBCHMAC_TAGLEN 바이트를 태그로 사용합니다.
+static void stitch_end(stitch_t *st, const cbchmac_ctx_t *ctx, size_t aad_len, uint8_t *tag)
+{
+  uint8_t al[8], mac[SHA256_DIGEST_SIZE];
+  uint64_t bits = (uint64_t)aad_len << 3;
+  sha256_ctx octx;
+
+  while (st->round < 64)
+    stitch_step(st);
+  for (int i = 7; i >= 0; i--, bits >>= 8)
+    al[i] = bits & 0xFF;
+  sha256_update(st->ctx, al, sizeof(al));
+  sha256_final(st->ctx, mac);
+  octx = ctx->opad;
+  sha256_update(&octx, mac, SHA256_DIGEST_SIZE);
+  sha256_final(&octx, mac);
+  memcpy(tag, mac, CBCHMAC_TAGLEN);
+}
+
+// 암호화 키로 라운드 키를 만들고, MAC 키로 HMAC의 K ^ ipad, K ^ opad 블록을 미리 처리해 둡니다.
+void aes_cbc_hmac_init(cbchmac_ctx_t *ctx, const uint8_t *enc_key, int length,
+                       const uint8_t *mac_key, size_t mac_key_len)
+{
+  uint8_t k[SHA256_BLOCK_SIZE] = {0}, pad[SHA256_BLOCK_SIZE];
+
+  ctx->length = length;
+  KeyExpansion(enc_key, ctx->roundKey, length);
+  if (mac_key_len > SHA256_BLOCK_SIZE)
+    sha256(mac_key, mac_key_len, k);
+  else
+    memcpy(k, mac_key, mac_key_len);
+  for (int i = 0; i < SHA256_BLOCK_SIZE; i++)
+    pad[i] = k[i] ^ 0x36;
+  sha256_init(&ctx->ipad);
+  sha256_update(&ctx->ipad, pad, SHA256_BLOCK_SIZE);
+  for (int i = 0; i < SHA256_BLOCK_SIZE; i++)
+    pad[i] = k[i] ^ 0x5c;
+  sha256_init(&ctx->opad);
+  sha256_update(&ctx->opad, pad, SHA256_BLOCK_SIZE);
+  memset(k, 0, sizeof(k));
+  memset(pad, 0, sizeof(pad));
+}
+
+/*
+ * aes_cbc_hmac_seal() - 길이가 len인 in을 PKCS#7로 패딩하여 CBC 암호화한 결과를 out에 저장하고
+ * aad와 함께 인증하는 태그를 tag에 저장한다. out에는 CBCHMAC_CTLEN(len) 바이트가 쓰인다.
+ * iv는 BLOCKLEN 바이트이며 예측할 수 없는 값이어야 한다. in과 out은 같아도 된다.
+ */
+void aes_cbc_hmac_seal(const cbchmac_ctx_t *ctx, const uint8_t *iv, const uint8_t *aad, size_t aad_len,
+                       const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag)
+{
+  uint8_t c[BLOCKLEN], last[BLOCKLEN];
+  size_t rem = len % BLOCKLEN;
+  sha256_ctx ictx;
+  stitch_t st;
+
+  stitch_begin(&st, &ictx, ctx, iv, aad, aad_len);
+  memcpy(c, iv, BLOCKLEN);
+  // 마지막 블록은 남은 평문 뒤에 (BLOCKLEN - rem)을 그 개수만큼 채운 블록입니다.
+  memcpy(last, in + len - rem, rem);
+  memset(last + rem, BLOCKLEN - rem, BLOCKLEN - rem);
+  for (size_t off = 0; off <= len - rem; off += BLOCKLEN) {
+    const uint8_t *p = off < len - rem ? in + off : last;
+    for (int i = 0; i < BLOCKLEN; i++)
+      c[i] ^= p[i];
+    Cipher(c, ctx->roundKey, ENCRYPT, ctx->length);
+    stitch_step(&st);
+    memcpy(out + off, c, BLOCKLEN);
+    stitch_push(&st, c);
+  }
+  stitch_end(&st, ctx, aad_len, tag);
+  memset(&ictx, 0, sizeof(ictx));
+}
+
+/*
+ * aes_cbc_hmac_open() - in을 복호화하여 out에 저장하고 태그를 검증한 후 패딩을 제거한 평문 길이를 out_len에 저장한다.
+ * 복호화와 태그 계산을 한 번에 수행하므로 검증 전에 out에 평문이 쓰이며, 검증에 실패하면 out을 0으로 지우고
+ * CBCHMAC_AUTH_FAIL을 넘겨준다. 패딩은 태그 검증에 성공한 뒤에만 확인한다.
+ */
+int aes_cbc_hmac_open(const cbchmac_ctx_t *ctx, const uint8_t *iv, const uint8_t *aad, size_t aad_len,
+                      const uint8_t *in, size_t len, uint8_t *out, size_t *out_len, const uint8_t *tag)
+{
+  uint8_t prev[BLOCKLEN], c[BLOCKLEN], b[BLOCKLEN], t[CBCHMAC_TAGLEN], diff = 0, pad;
+  sha256_ctx ictx;
+  stitch_t st;
+
+  if (len == 0 || len % BLOCKLEN)
+    return CBCHMAC_INVALID_ARG;
+  stitch_begin(&st, &ictx, ctx, iv, aad, aad_len);
+  memcpy(prev, iv, BLOCKLEN);
+  for (size_t off = 0; off < len; off += BLOCKLEN) {
+    memcpy(c, in + off, BLOCKLEN);
+    memcpy(b, c, BLOCKLEN);
+    Cipher(b, ctx->roundKey, DECRYPT, ctx->length);
+    stitch_step(&st);
+    for (int i = 0; i < BLOCKLEN; i++)
+      out[off + i] = b[i] ^ prev[i];
+    memcpy(prev, c, BLOCKLEN);
+    stitch_push(&st, c);
+  }
+  stitch_end(&st, ctx, aad_len, t);
+  memset(&ictx, 0, sizeof(ictx));
+  // 태그 비교 시간이 일치하는 바이트 수에 따라 달라지지 않도록 모든 바이트를 비교합니다.
+  for (int i = 0; i < CBCHMAC_TAGLEN; i++)
+    diff |= t[i] ^ tag[i];
+  if (diff) {
+    memset(out, 0, len);
+    return CBCHMAC_AUTH_FAIL;
+  }
+  pad = out[len - 1];
+  if (pad == 0 || pad > BLOCKLEN)
+    return CBCHMAC_BAD_PADDING;
+  for (int i = 1; i <= pad; i++)
+    if (out[len - i] != pad)
+      return CBCHMAC_BAD_PADDING;
+  *out_len = len - pad;
+  return 0;
+}
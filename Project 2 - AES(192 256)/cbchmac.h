@@ -0,0 +1,49 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _CBCHMAC_H_
+#define _CBCHMAC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "aes.h"
+#include "sha2.h"
+
+/*
+ * AES-CBC + HMAC-SHA256 encrypt-then-MAC (draft-mcgrew-aead-aes-cbc-hmac-sha2의 AEAD_AES_CBC_HMAC_SHA_256)
+ *   C = AES-CBC(PKCS#7 패딩한 평문), T = HMAC-SHA256(A || IV || C || AL)의 앞 CBCHMAC_TAGLEN 바이트
+ * AL은 A의 비트 길이(8바이트, 빅 엔디안)이다. CBC 암복호화와 HMAC 계산을 한 번의 루프에서 블록 단위로
+ * 섞어서 수행하므로 데이터를 한 번만 읽는다.
+ */
+#define CBCHMAC_TAGLEN 16
+#define CBCHMAC_CTLEN(len) (((len) / BLOCKLEN + 1) * BLOCKLEN)  /* 패딩을 포함한 암호문 길이 */
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define CBCHMAC_AUTH_FAIL   1
+#define CBCHMAC_BAD_PADDING 2
+#define CBCHMAC_INVALID_ARG 3
+
+/*
+ * 키마다 한 번 만드는 문맥으로 라운드 키와 HMAC의 ipad, opad 블록을 처리한 중간 상태를 담는다.
+ * 초기화 이후에는 읽기만 하므로 여러 스레드가 공유해도 된다.
+ */
+typedef struct {
+    uint32_t roundKey[RNDKEYLEN_256];
+    int length;
+    sha256_ctx ipad, opad;
+} cbchmac_ctx_t;
+
+void aes_cbc_hmac_init(cbchmac_ctx_t *ctx, const uint8_t *enc_key, int length,
+                       const uint8_t *mac_key, size_t mac_key_len);
+void aes_cbc_hmac_seal(const cbchmac_ctx_t *ctx, const uint8_t *iv, const uint8_t *aad, size_t aad_len,
+                       const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag);
+int aes_cbc_hmac_open(const cbchmac_ctx_t *ctx, const uint8_t *iv, const uint8_t *aad, size_t aad_len,
+                      const uint8_t *in, size_t len, uint8_t *out, size_t *out_len, const uint8_t *tag);
+
+#endif
@@ -0,0 +1,414 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "encreader.h"
+#include "modes.h"
+
+#define ENCREADER_CACHE     256  /* 기본 캐시 크기(페이지), 1 MiB */
+#define ENCREADER_READAHEAD 16   /* 기본 read-ahead 페이지 수 */
+#define UNIT_MAX (ENCREADER_PAGE + BLOCKLEN)  /* XTS에서 합쳐진 마지막 데이터 단위의 최대 길이 */
+
+struct encreader_page {
+  uint64_t idx;
+  size_t len;
+  int valid, prev, next, hnext;
+  uint8_t data[ENCREADER_PAGE];
+};
+
+static int read_full(int fd, uint8_t *buf, size_t len, off_t off)
+{
+  while (len > 0) {
+    ssize_t n = pread(fd, buf, len, off);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+    buf += n; len -= n; off += n;
+  }
+  return 1;
+}
+
+static int write_full(int fd, const uint8_t *buf, size_t len, off_t off)
+{
+  while (len > 0) {
+    ssize_t n = pwrite(fd, buf, len, off);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+    buf += n; len -= n; off += n;
+  }
+  return 1;
+}
+
+// XTS 파일에서 평문 길이 size의 데이터 단위 u가 시작하는 위치와 길이를 구합니다.
+// 마지막 단위가 BLOCKLEN보다 짧으면 바로 앞 단위에 합치므로 단위 수가 하나 줄어듭니다.
+static uint64_t xts_units(uint64_t size)
+{
+  uint64_t n = (size + ENCREADER_PAGE - 1) / ENCREADER_PAGE;
+  if (n > 1 && size % ENCREADER_PAGE && size % ENCREADER_PAGE < BLOCKLEN)
+    n--;
+  return n;
+}
+
+static size_t xts_unit_len(uint64_t size, uint64_t u)
+{
+  return u == xts_units(size) - 1 ? size - u * ENCREADER_PAGE : ENCREADER_PAGE;
+}
+
+void encreader_default(encreader_opt_t *opt)
+{
+  opt->cache_pages = ENCREADER_CACHE;
+  opt->readahead = ENCREADER_READAHEAD;
+}
+
+/*
+ * 파일에서 평문의 off 위치부터 len 바이트를 복호화하여 out에 저장한다. 캐시와 무관하게 동작한다.
+ * CTR은 요청 범위에 걸친 블록만, XTS는 요청 범위에 걸친 데이터 단위 전체를 복호화한다.
+ */
+static int decrypt_range(const encreader_t *r, uint8_t *out, size_t len, uint64_t off)
+{
+  uint8_t buf[UNIT_MAX], ctr[BLOCKLEN];
+
+  while (len > 0) {
+    size_t skip, n, cnt;
+    if (r->format == ENCREADER_CTR) {
+      uint64_t blk = off / BLOCKLEN;
+      skip = off % BLOCKLEN;
+      cnt = skip + len < sizeof(buf) ? skip + len : sizeof(buf) - sizeof(buf) % BLOCKLEN;
+      if (!read_full(r->fd, buf, cnt, BLOCKLEN + blk * BLOCKLEN))
+        return ENCREADER_READ_FAIL;
+      memcpy(ctr, r->iv, BLOCKLEN);
+      aes_ctr_add(ctr, blk);
+      aes_ctr_crypt(r->roundKey, r->length, ctr, buf, buf, cnt);
+    } else {
+      uint64_t u = off / ENCREADER_PAGE;
+      if (u >= xts_units(r->size))
+        u = xts_units(r->size) - 1;
+      skip = off - u * ENCREADER_PAGE;
+      cnt = xts_unit_len(r->size, u);
+      if (!read_full(r->fd, buf, cnt, u * ENCREADER_PAGE))
+        return ENCREADER_READ_FAIL;
+      aes_xts_crypt(r->roundKey, r->roundKey2, r->length, DECRYPT, u, buf, buf, cnt);
+    }
+    n = cnt - skip < len ? cnt - skip : len;
+    memcpy(out, buf + skip, n);
+    out += n;
+    off += n;
+    len -= n;
+  }
+  memset(buf, 0, sizeof(buf));
+  return 0;
+}
+
+static size_t page_len(const encreader_t *r, uint64_t idx)
+{
+  return idx == r->npage - 1 ? r->size - idx * ENCREADER_PAGE : ENCREADER_PAGE;
+}
+
+// 아래의 캐시 함수들은 모두 lock을 잡은 상태에서 호출해야 합니다.
+static int cache_find(const encreader_t *r, uint64_t idx)
+{
+  int s = r->bucket[idx & (r->nbucket - 1)];
+  while (s >= 0 && r->pages[s].idx != idx)
+    s = r->pages[s].hnext;
+  return s;
+}
+
+static void lru_unlink(encreader_t *r, int s)
+{
+  struct encreader_page *p = &r->pages[s];
+  if (p->prev >= 0) r->pages[p->prev].next = p->next; else r->lru_head = p->next;
+  if (p->next >= 0) r->pages[p->next].prev = p->prev; else r->lru_tail = p->prev;
+}
+
+// 가장 최근에 사용한 페이지가 lru_head, 가장 오래된 페이지가 lru_tail입니다.
+static void lru_push_front(encreader_t *r, int s)
+{
+  r->pages[s].prev = -1;
+  r->pages[s].next = r->lru_head;
+  if (r->lru_head >= 0)
+    r->pages[r->lru_head].prev = s;
+  r->lru_head = s;
+  if (r->lru_tail < 0)
+    r->lru_tail = s;
+}
+
+// 가장 오래된 페이지를 해시 체인에서 빼고 새 페이지 idx로 다시 사용합니다.
+static void cache_insert(encreader_t *r, uint64_t idx, const uint8_t *data, size_t len)
+{
+  int s = r->lru_tail, *pp;
+  struct encreader_page *p = &r->pages[s];
+
+  if (p->valid) {
+    for (pp = &r->bucket[p->idx & (r->nbucket - 1)]; *pp != s; pp = &r->pages[*pp].hnext)
+      ;
+    *pp = p->hnext;
+  }
+  p->idx = idx;
+  p->len = len;
+  p->valid = 1;
+  memcpy(p->data, data, len);
+  p->hnext = r->bucket[idx & (r->nbucket - 1)];
+  r->bucket[idx & (r->nbucket - 1)] = s;
+  lru_unlink(r, s);
+  lru_push_front(r, s);
+}
+
+// read-ahead 스레드: pread가 알려 준 [ra_next, ra_end) 범위에서 캐시에 없는 페이지를 미리 복호화합니다.
+static void *ra_worker(void *arg)
+{
+  encreader_t *r = arg;
+  uint8_t page[ENCREADER_PAGE];
+
+  pthread_mutex_lock(&r->lock);
+  while (!r->stop) {
+    if (r->ra_next >= r->ra_end || r->ra_next >= r->npage) {
+      pthread_cond_wait(&r->cond, &r->lock);
+      continue;
+    }
+    uint64_t idx = r->ra_next++;
+    if (cache_find(r, idx) >= 0)
+      continue;
+    pthread_mutex_unlock(&r->lock);
+    int val = decrypt_range(r, page, page_len(r, idx), idx * ENCREADER_PAGE);
+    pthread_mutex_lock(&r->lock);
+    if (val == 0 && cache_find(r, idx) < 0) {
+      cache_insert(r, idx, page, page_len(r, idx));
+      r->prefetched++;
+    }
+  }
+  pthread_mutex_unlock(&r->lock);
+  memset(page, 0, sizeof(page));
+  return NULL;
+}
+
+/*
+ * encreader_open() - 암호화된 파일 path를 format 형식으로 열어 임의 위치 읽기를 준비한다.
+ * key는 CTR이면 AES 키, XTS이면 데이터 키 || 트윅 키(각각 length에 맞는 길이)이다.
+ * opt가 NULL이면 encreader_default()의 값을 사용한다. 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int encreader_open(encreader_t *r, const char *path, int format, const uint8_t *key, int length,
+                   const encreader_opt_t *opt)
+{
+  encreader_opt_t o;
+  struct stat st;
+  int result = 0;
+
+  if (opt == NULL)
+    encreader_default(&o);
+  else
+    o = *opt;
+  if (r == NULL || path == NULL || key == NULL || length < AES128 || length > AES256
+      || (format != ENCREADER_CTR && format != ENCREADER_XTS) || o.cache_pages < 0 || o.readahead < 0)
+    return ENCREADER_INVALID_ARG;
+  memset(r, 0, sizeof(*r));
+  r->format = format;
+  r->length = length;
+  r->lru_head = r->lru_tail = -1;
+  if ((r->fd = open(path, O_RDONLY)) < 0)
+    return ENCREADER_OPEN_FAIL;
+  if (fstat(r->fd, &st) < 0) {
+    result = ENCREADER_OPEN_FAIL;
+    goto fail;
+  }
+  if (format == ENCREADER_CTR) {
+    if ((uint64_t)st.st_size < BLOCKLEN || !read_full(r->fd, r->iv, BLOCKLEN, 0)) {
+      result = ENCREADER_BAD_FORMAT;
+      goto fail;
+    }
+    r->size = st.st_size - BLOCKLEN;
+    KeyExpansion(key, r->roundKey, length);
+  } else {
+    // XTS는 BLOCKLEN보다 짧은 데이터 단위를 암호화할 수 없습니다.
+    if (st.st_size > 0 && st.st_size < BLOCKLEN) {
+      result = ENCREADER_BAD_FORMAT;
+      goto fail;
+    }
+    r->size = st.st_size;
+    KeyExpansion(key, r->roundKey, length);
+    KeyExpansion(key + KEYLEN + 8*length, r->roundKey2, length);
+  }
+  r->npage = (r->size + ENCREADER_PAGE - 1) / ENCREADER_PAGE;
+
+  if (o.cache_pages > 0) {
+    r->npages = o.cache_pages;
+    for (r->nbucket = 1; r->nbucket < 2 * r->npages; r->nbucket <<= 1)
+      ;
+    if ((r->pages = calloc(r->npages, sizeof(*r->pages))) == NULL
+        || (r->bucket = malloc(r->nbucket * sizeof(int))) == NULL) {
+      result = ENCREADER_NO_MEMORY;
+      goto fail;
+    }
+    for (int i = 0; i < r->nbucket; i++)
+      r->bucket[i] = -1;
+    for (int i = r->npages - 1; i >= 0; i--)
+      lru_push_front(r, i);
+  }
+  pthread_mutex_init(&r->lock, NULL);
+  pthread_cond_init(&r->cond, NULL);
+  // 캐시가 없으면 미리 복호화한 페이지를 둘 곳이 없으므로 read-ahead도 사용하지 않습니다.
+  if (o.readahead > 0 && r->npages > 0) {
+    r->readahead = o.readahead < r->npages ? o.readahead : r->npages;
+    if (pthread_create(&r->ra_thread, NULL, ra_worker, r) == 0)
+      r->ra_running = 1;
+  }
+  return 0;
+
+fail:
+  free(r->pages);
+  free(r->bucket);
+  close(r->fd);
+  memset(r, 0, sizeof(*r));
+  r->fd = -1;
+  return result;
+}
+
+/*
+ * encreader_pread() - 평문의 off 위치부터 len 바이트를 buf에 복호화한다.
+ * 캐시에 있는 페이지는 그대로 복사하고, 없는 페이지는 복호화한 후 캐시에 넣는다.
+ * 여러 스레드가 동시에 호출해도 된다. 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int encreader_pread(encreader_t *r, void *buf, size_t len, uint64_t off)
+{
+  uint8_t *dst = buf, page[ENCREADER_PAGE];
+  uint64_t start = off;
+  int result = 0;
+
+  if (off > r->size || len > r->size - off)
+    return ENCREADER_INVALID_ARG;
+  if (r->npages == 0)
+    return decrypt_range(r, dst, len, off);
+
+  while (len > 0) {
+    uint64_t idx = off / ENCREADER_PAGE;
+    size_t skip = off % ENCREADER_PAGE, plen = page_len(r, idx);
+    size_t n = plen - skip < len ? plen - skip : len;
+    int s;
+
+    pthread_mutex_lock(&r->lock);
+    if ((s = cache_find(r, idx)) >= 0) {
+      memcpy(dst, r->pages[s].data + skip, n);
+      lru_unlink(r, s);
+      lru_push_front(r, s);
+      r->hits++;
+      pthread_mutex_unlock(&r->lock);
+    } else {
+      r->misses++;
+      pthread_mutex_unlock(&r->lock);
+      // 복호화는 lock을 놓고 수행하므로 다른 스레드의 캐시 적중은 기다리지 않습니다.
+      if ((result = decrypt_range(r, page, plen, idx * ENCREADER_PAGE)) != 0)
+        break;
+      memcpy(dst, page + skip, n);
+      pthread_mutex_lock(&r->lock);
+      if (cache_find(r, idx) < 0)
+        cache_insert(r, idx, page, plen);
+      pthread_mutex_unlock(&r->lock);
+    }
+    dst += n;
+    off += n;
+    len -= n;
+  }
+  memset(page, 0, sizeof(page));
+
+  // 직전 읽기가 끝난 곳에서 이어 읽으면 순차 읽기로 보고 다음 페이지들을 미리 복호화하게 합니다.
+  if (result == 0 && r->ra_running) {
+    pthread_mutex_lock(&r->lock);
+    if (start == r->last_end) {
+      r->ra_next = (off + ENCREADER_PAGE - 1) / ENCREADER_PAGE;
+      r->ra_end = r->ra_next + r->readahead;
+      pthread_cond_signal(&r->cond);
+    }
+    r->last_end = off;
+    pthread_mutex_unlock(&r->lock);
+  }
+  return result;
+}
+
+void encreader_close(encreader_t *r)
+{
+  if (r->fd < 0)
+    return;
+  if (r->ra_running) {
+    pthread_mutex_lock(&r->lock);
+    r->stop = 1;
+    pthread_cond_signal(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+    pthread_join(r->ra_thread, NULL);
+  }
+  pthread_mutex_destroy(&r->lock);
+  pthread_cond_destroy(&r->cond);
+  if (r->pages != NULL)
+    memset(r->pages, 0, r->npages * sizeof(*r->pages));
+  free(r->pages);
+  free(r->bucket);
+  close(r->fd);
+  memset(r, 0, sizeof(*r));
+  r->fd = -1;
+}
+
+/*
+ * encreader_xts_seal() - 파일 in을 ENCREADER_XTS 형식으로 암호화하여 out에 저장한다.
+ * key는 데이터 키 || 트윅 키이다. 1 ~ BLOCKLEN-1 바이트 파일은 XTS로 암호화할 수 없으므로
+ * ENCREADER_INVALID_ARG를 넘겨준다. 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int encreader_xts_seal(const char *in, const char *out, const uint8_t *key, int length)
+{
+  uint32_t roundKey1[RNDKEYLEN_256], roundKey2[RNDKEYLEN_256];
+  uint8_t buf[UNIT_MAX];
+  struct stat st;
+  uint64_t size, nunit, u;
+  int ifd = -1, ofd = -1, result = 0;
+
+  if (in == NULL || out == NULL || key == NULL || length < AES128 || length > AES256)
+    return ENCREADER_INVALID_ARG;
+  if ((ifd = open(in, O_RDONLY)) < 0 || fstat(ifd, &st) < 0) {
+    result = ENCREADER_OPEN_FAIL;
+    goto done;
+  }
+  size = st.st_size;
+  if (size > 0 && size < BLOCKLEN) {
+    result = ENCREADER_INVALID_ARG;
+    goto done;
+  }
+  if ((ofd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+    result = ENCREADER_OPEN_FAIL;
+    goto done;
+  }
+
+  KeyExpansion(key, roundKey1, length);
+  KeyExpansion(key + KEYLEN + 8*length, roundKey2, length);
+  nunit = xts_units(size);
+  for (u = 0; u < nunit; u++) {
+    size_t n = xts_unit_len(size, u);
+    if (!read_full(ifd, buf, n, u * ENCREADER_PAGE)) {
+      result = ENCREADER_READ_FAIL;
+      break;
+    }
+    aes_xts_crypt(roundKey1, roundKey2, length, ENCRYPT, u, buf, buf, n);
+    if (!write_full(ofd, buf, n, u * ENCREADER_PAGE)) {
+      result = ENCREADER_WRITE_FAIL;
+      break;
+    }
+  }
+  memset(roundKey1, 0, sizeof(roundKey1));
+  memset(roundKey2, 0, sizeof(roundKey2));
+  memset(buf, 0, sizeof(buf));
+
+done:
+  if (ifd >= 0)
+    close(ifd);
+  if (ofd >= 0 && close(ofd) < 0 && result == 0)
+    result = ENCREADER_WRITE_FAIL;
+  return result;
+}
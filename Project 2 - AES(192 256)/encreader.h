@@ -0,0 +1,77 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _ENCREADER_H_
+#define _ENCREADER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "aes.h"
+
+/*
+ * 암호화된 파일의 임의 위치 읽기
+ *
+ * 지원하는 파일 형식은 다음과 같다.
+ *   ENCREADER_CTR : filecrypt()가 만든 파일, IV(BLOCKLEN) || CTR 암호문
+ *   ENCREADER_XTS : encreader_xts_seal()이 만든 파일, 헤더 없이 ENCREADER_PAGE 바이트 데이터 단위로
+ *                   XTS 암호화하며 단위 번호가 트윅이다. 마지막 단위가 BLOCKLEN보다 짧으면 바로 앞
+ *                   단위에 합쳐서 하나의 데이터 단위로 암호화한다. 키는 데이터 키 || 트윅 키이다.
+ *
+ * 복호화한 평문은 ENCREADER_PAGE 바이트 페이지 단위로 LRU 캐시에 보관하고, read-ahead를 켜면
+ * 순차 읽기가 감지될 때 다음 페이지들을 백그라운드 스레드가 미리 복호화해 둔다.
+ */
+#define ENCREADER_PAGE  4096
+#define ENCREADER_CTR   0
+#define ENCREADER_XTS   1
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define ENCREADER_INVALID_ARG 1
+#define ENCREADER_OPEN_FAIL   2
+#define ENCREADER_READ_FAIL   3
+#define ENCREADER_WRITE_FAIL  4
+#define ENCREADER_BAD_FORMAT  5
+#define ENCREADER_NO_MEMORY   6
+
+/*
+ * 옵션: cache_pages가 0이면 캐시 없이 요청한 블록만 복호화하고, readahead가 0이면 read-ahead 스레드를 만들지 않는다.
+ */
+typedef struct {
+    int cache_pages;  /* 캐시할 페이지 수 */
+    int readahead;    /* 순차 읽기 때 미리 복호화할 페이지 수 */
+} encreader_opt_t;
+
+struct encreader_page;
+
+typedef struct {
+    int fd, format, length;
+    uint64_t size;             /* 평문 전체 길이 */
+    uint64_t npage;
+    uint8_t iv[BLOCKLEN];
+    uint32_t roundKey[RNDKEYLEN_256], roundKey2[RNDKEYLEN_256];
+    /* LRU 캐시, lock으로 보호한다 */
+    struct encreader_page *pages;
+    int npages, nbucket, *bucket, lru_head, lru_tail;
+    uint64_t hits, misses, prefetched;
+    /* read-ahead */
+    int readahead, ra_running, stop;
+    uint64_t ra_next, ra_end, last_end;
+    pthread_t ra_thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} encreader_t;
+
+void encreader_default(encreader_opt_t *opt);
+int encreader_open(encreader_t *r, const char *path, int format, const uint8_t *key, int length,
+                   const encreader_opt_t *opt);
+int encreader_pread(encreader_t *r, void *buf, size_t len, uint64_t off);
+void encreader_close(encreader_t *r);
+int encreader_xts_seal(const char *in, const char *out, const uint8_t *key, int length);
+
+#endif
@@ -0,0 +1,468 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifdef __linux__
+#include <bsd/stdlib.h>
+#elif __APPLE__
+#include <stdlib.h>
+#else
+#include <stdlib.h>
+#endif
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+#ifdef USE_IO_URING
+#include <liburing.h>
+#endif
+#include "aes.h"
+#include "modes.h"
+#include "filecrypt.h"
+
+/*
+ * 버퍼 하나(슬롯)는 FREE -> 읽기 -> ready 큐 -> 암호화 -> done 큐 -> 쓰기 -> FREE 순서로 순환합니다.
+ * 큐와 카운터는 모두 lock으로 보호하고 상태가 바뀔 때마다 cond로 대기 중인 스레드를 깨웁니다.
+ */
+typedef struct {
+  uint8_t *buf;
+  uint64_t idx;   /* 청크 번호 */
+  size_t len;     /* 청크 길이 */
+  size_t done;    /* 부분 읽기/쓰기로 이미 처리된 바이트 수 */
+} slot_t;
+
+typedef struct {
+  int ifd, ofd;
+  off_t ibase, obase;
+  uint64_t size, nchunks;
+  size_t chunk;
+  int depth;
+  uint32_t roundKey[RNDKEYLEN_256];
+  int length;
+  uint8_t iv[BLOCKLEN];
+
+  slot_t *slot;
+  int *freeq, nfree;
+  int *readyq, rhead, rcount;
+  int *doneq, dhead, dcount;
+  uint64_t next_read, nread, written;
+  int error;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+
+  int inflight, qd_max;
+  uint64_t qd_sum, qd_samples;
+} pipe_t;
+
+void filecrypt_default(filecrypt_opt_t *opt)
+{
+  opt->chunk_size = FILECRYPT_CHUNK;
+  opt->depth = FILECRYPT_DEPTH;
+  opt->nthreads = FILECRYPT_THREADS;
+  opt->io_threads = FILECRYPT_IO;
+  opt->use_uring = 1;
+}
+
+// 아래의 큐 함수들은 모두 lock을 잡은 상태에서 호출해야 합니다.
+static void q_push(int *q, int head, int *count, int depth, int s)
+{
+  q[(head + *count) % depth] = s;
+  (*count)++;
+}
+
+static int q_pop(int *q, int *head, int *count, int depth)
+{
+  int s = q[*head];
+  *head = (*head + 1) % depth;
+  (*count)--;
+  return s;
+}
+
+// I/O 요청을 제출할 때마다 진행 중인 요청 수를 기록하여 평균/최대 큐 깊이를 구합니다.
+static void sample_qdepth(pipe_t *p)
+{
+  p->inflight++;
+  p->qd_sum += p->inflight;
+  p->qd_samples++;
+  if (p->inflight > p->qd_max)
+    p->qd_max = p->inflight;
+}
+
+// 빈 슬롯을 하나 꺼내 다음 청크를 읽을 준비를 합니다.
+static int take_read(pipe_t *p)
+{
+  int s = p->freeq[--p->nfree];
+  slot_t *sl = &p->slot[s];
+  uint64_t off = p->next_read * p->chunk;
+
+  sl->idx = p->next_read++;
+  sl->len = p->size - off < p->chunk ? p->size - off : p->chunk;
+  sl->done = 0;
+  sample_qdepth(p);
+  return s;
+}
+
+static void finish_read(pipe_t *p, int s)
+{
+  p->inflight--;
+  p->nread++;
+  q_push(p->readyq, p->rhead, &p->rcount, p->depth, s);
+  pthread_cond_broadcast(&p->cond);
+}
+
+static int take_write(pipe_t *p)
+{
+  int s = q_pop(p->doneq, &p->dhead, &p->dcount, p->depth);
+  p->slot[s].done = 0;
+  sample_qdepth(p);
+  return s;
+}
+
+static void finish_write(pipe_t *p, int s)
+{
+  p->inflight--;
+  p->written++;
+  p->freeq[p->nfree++] = s;
+  pthread_cond_broadcast(&p->cond);
+}
+
+static void fail(pipe_t *p, int err)
+{
+  if (!p->error)
+    p->error = err;
+  pthread_cond_broadcast(&p->cond);
+}
+
+// 짧은 읽기/쓰기가 일어나도 len 바이트를 모두 처리할 때까지 반복합니다.
+static int read_full(int fd, uint8_t *buf, size_t len, off_t off)
+{
+  while (len > 0) {
+    ssize_t n = pread(fd, buf, len, off);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+    buf += n; len -= n; off += n;
+  }
+  return 1;
+}
+
+static int write_full(int fd, const uint8_t *buf, size_t len, off_t off)
+{
+  while (len > 0) {
+    ssize_t n = pwrite(fd, buf, len, off);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return 0;
+    buf += n; len -= n; off += n;
+  }
+  return 1;
+}
+
+// 암호화 스레드: ready 큐에서 읽기가 끝난 청크를 꺼내 제자리에서 CTR 암호화합니다.
+// 청크 번호로 시작 카운터를 계산하므로 청크들은 어떤 순서로 처리해도 됩니다.
+static void *crypt_worker(void *arg)
+{
+  pipe_t *p = arg;
+  uint8_t ctr[BLOCKLEN];
+
+  pthread_mutex_lock(&p->lock);
+  for (;;) {
+    while (p->rcount == 0 && p->nread < p->nchunks && !p->error)
+      pthread_cond_wait(&p->cond, &p->lock);
+    if (p->error || p->rcount == 0)
+      break;
+    int s = q_pop(p->readyq, &p->rhead, &p->rcount, p->depth);
+    pthread_mutex_unlock(&p->lock);
+
+    slot_t *sl = &p->slot[s];
+    memcpy(ctr, p->iv, BLOCKLEN);
+    aes_ctr_add(ctr, sl->idx * (p->chunk / BLOCKLEN));
+    aes_ctr_crypt(p->roundKey, p->length, ctr, sl->buf, sl->buf, sl->len);
+
+    pthread_mutex_lock(&p->lock);
+    q_push(p->doneq, p->dhead, &p->dcount, p->depth, s);
+    pthread_cond_broadcast(&p->cond);
+  }
+  pthread_mutex_unlock(&p->lock);
+  return NULL;
+}
+
+// pread/pwrite I/O 스레드: 버퍼를 빨리 돌려받기 위해 쓰기를 읽기보다 먼저 처리합니다.
+static void *io_worker(void *arg)
+{
+  pipe_t *p = arg;
+
+  pthread_mutex_lock(&p->lock);
+  for (;;) {
+    while (!p->error && p->written < p->nchunks && p->dcount == 0
+           && !(p->nfree > 0 && p->next_read < p->nchunks))
+      pthread_cond_wait(&p->cond, &p->lock);
+    if (p->error || p->written == p->nchunks)
+      break;
+    int wr = p->dcount > 0;
+    int s = wr ? take_write(p) : take_read(p);
+    slot_t *sl = &p->slot[s];
+    pthread_mutex_unlock(&p->lock);
+
+    int ok = wr ? write_full(p->ofd, sl->buf, sl->len, p->obase + (off_t)(sl->idx * p->chunk))
+                : read_full(p->ifd, sl->buf, sl->len, p->ibase + (off_t)(sl->idx * p->chunk));
+
+    pthread_mutex_lock(&p->lock);
+    if (!ok) {
+      fail(p, wr ? FILECRYPT_WRITE_FAIL : FILECRYPT_READ_FAIL);
+      break;
+    }
+    if (wr)
+      finish_write(p, s);
+    else
+      finish_read(p, s);
+  }
+  pthread_mutex_unlock(&p->lock);
+  return NULL;
+}
+
+#ifdef USE_IO_URING
+// 슬롯의 남은 부분에 대한 읽기 또는 쓰기 요청을 SQ에 넣습니다.
+// user_data의 최하위 비트로 쓰기 여부를, 나머지 비트로 슬롯 번호를 구분합니다.
+static void uring_prep(struct io_uring *ring, pipe_t *p, int s, int wr)
+{
+  struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+  slot_t *sl = &p->slot[s];
+  off_t off = (wr ? p->obase : p->ibase) + (off_t)(sl->idx * p->chunk) + sl->done;
+
+  if (wr)
+    io_uring_prep_write(sqe, p->ofd, sl->buf + sl->done, sl->len - sl->done, off);
+  else
+    io_uring_prep_read(sqe, p->ifd, sl->buf + sl->done, sl->len - sl->done, off);
+  io_uring_sqe_set_data(sqe, (void *)(uintptr_t)(((uint64_t)s << 1) | wr));
+}
+
+// io_uring I/O 루프: 호출한 스레드 하나가 읽기와 쓰기를 모두 제출하고 완료를 수거합니다.
+// 링 크기는 depth이고 슬롯마다 요청이 최대 하나이므로 SQ가 넘치지 않습니다.
+// io_uring을 초기화할 수 없으면 -1을 반환하여 pread 경로로 대체하게 합니다.
+static int uring_run(pipe_t *p)
+{
+  struct io_uring ring;
+  struct io_uring_cqe *cqe;
+
+  if (io_uring_queue_init(p->depth, &ring, 0) < 0)
+    return -1;
+
+  pthread_mutex_lock(&p->lock);
+  while (!p->error && p->written < p->nchunks) {
+    while (p->dcount > 0)
+      uring_prep(&ring, p, take_write(p), 1);
+    while (p->nfree > 0 && p->next_read < p->nchunks)
+      uring_prep(&ring, p, take_read(p), 0);
+    // 진행 중인 I/O가 없으면 암호화 스레드가 청크를 넘겨줄 때까지 기다립니다.
+    if (p->inflight == 0) {
+      pthread_cond_wait(&p->cond, &p->lock);
+      continue;
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    // 암호화가 끝난 청크를 제때 쓰기 위해 짧은 타임아웃으로 완료를 기다립니다.
+    struct __kernel_timespec ts = { .tv_sec = 0, .tv_nsec = 1000000 };
+    int ret = io_uring_submit(&ring);
+    if (ret >= 0)
+      ret = io_uring_wait_cqe_timeout(&ring, &cqe, &ts);
+
+    pthread_mutex_lock(&p->lock);
+    if (ret == -ETIME || ret == -EINTR)
+      continue;
+    if (ret < 0) {
+      fail(p, FILECRYPT_READ_FAIL);
+      break;
+    }
+    while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+      uint64_t data = (uint64_t)(uintptr_t)io_uring_cqe_get_data(cqe);
+      int s = data >> 1, wr = data & 1, res = cqe->res;
+      slot_t *sl = &p->slot[s];
+
+      io_uring_cqe_seen(&ring, cqe);
+      if (res <= 0) {
+        p->inflight--;
+        fail(p, wr ? FILECRYPT_WRITE_FAIL : FILECRYPT_READ_FAIL);
+        continue;
+      }
+      sl->done += res;
+      if (sl->done < sl->len)
+        uring_prep(&ring, p, s, wr);
+      else if (wr)
+        finish_write(p, s);
+      else
+        finish_read(p, s);
+    }
+  }
+  // 오류로 중단한 경우에도 버퍼를 해제하기 전에 진행 중인 요청을 모두 수거합니다.
+  while (p->inflight > 0) {
+    pthread_mutex_unlock(&p->lock);
+    io_uring_submit_and_wait(&ring, 1);
+    pthread_mutex_lock(&p->lock);
+    while (io_uring_peek_cqe(&ring, &cqe) == 0) {
+      io_uring_cqe_seen(&ring, cqe);
+      p->inflight--;
+    }
+  }
+  pthread_mutex_unlock(&p->lock);
+  io_uring_queue_exit(&ring);
+  return 0;
+}
+#endif
+
+/*
+ * filecrypt() - 파일 in을 AES-CTR로 암호화(mode = ENCRYPT) 또는 복호화(mode = DECRYPT)하여 out에 저장한다.
+ * key의 길이는 length(AES128, AES192, AES256)에 맞아야 하며 opt가 NULL이면 기본값을 사용한다.
+ * stat이 NULL이 아니면 처리량과 큐 깊이 통계를 저장한다. 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int filecrypt(const char *in, const char *out, const uint8_t *key, int length, int mode,
+              const filecrypt_opt_t *opt, filecrypt_stat_t *stat)
+{
+  filecrypt_opt_t o;
+  pipe_t *p;
+  pthread_t *th;
+  struct stat st;
+  struct timespec t0, t1;
+  int i, n, uring = 0, result = 0;
+
+  if (opt == NULL)
+    filecrypt_default(&o);
+  else
+    o = *opt;
+  if (in == NULL || out == NULL || key == NULL || length < AES128 || length > AES256
+      || o.chunk_size == 0 || o.chunk_size % BLOCKLEN || o.depth < 1 || o.nthreads < 1 || o.io_threads < 1)
+    return FILECRYPT_INVALID_ARG;
+
+  if ((p = calloc(1, sizeof(pipe_t))) == NULL)
+    return FILECRYPT_NO_MEMORY;
+  p->chunk = o.chunk_size;
+  p->depth = o.depth;
+  p->length = length;
+  p->ofd = -1;
+
+  // 입력 파일을 열고 평문 크기와 초기 카운터 블록을 결정합니다.
+  // 암호화할 때는 무작위 카운터 블록을 만들어 출력 파일의 맨 앞에 기록하고
+  // 복호화할 때는 입력 파일의 맨 앞에서 읽습니다.
+  if ((p->ifd = open(in, O_RDONLY)) < 0 || fstat(p->ifd, &st) < 0) {
+    result = FILECRYPT_OPEN_FAIL;
+    goto done;
+  }
+  if (mode == ENCRYPT) {
+    arc4random_buf(p->iv, BLOCKLEN);
+    p->size = st.st_size;
+    p->ibase = 0;
+    p->obase = BLOCKLEN;
+  } else {
+    if (st.st_size < BLOCKLEN || !read_full(p->ifd, p->iv, BLOCKLEN, 0)) {
+      result = FILECRYPT_BAD_FORMAT;
+      goto done;
+    }
+    p->size = st.st_size - BLOCKLEN;
+    p->ibase = BLOCKLEN;
+    p->obase = 0;
+  }
+  if ((p->ofd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+    result = FILECRYPT_OPEN_FAIL;
+    goto done;
+  }
+  // 청크가 순서와 무관하게 기록되므로 출력 파일의 크기를 먼저 맞춰 둡니다.
+  if ((mode == ENCRYPT && !write_full(p->ofd, p->iv, BLOCKLEN, 0))
+      || ftruncate(p->ofd, p->obase + p->size) < 0) {
+    result = FILECRYPT_WRITE_FAIL;
+    goto done;
+  }
+  KeyExpansion(key, p->roundKey, length);
+  p->nchunks = (p->size + p->chunk - 1) / p->chunk;
+
+  // depth개의 버퍼와 세 개의 큐를 준비합니다. 처음에는 모든 버퍼가 비어 있습니다.
+  p->slot = calloc(p->depth, sizeof(slot_t));
+  p->freeq = calloc(p->depth, sizeof(int));
+  p->readyq = calloc(p->depth, sizeof(int));
+  p->doneq = calloc(p->depth, sizeof(int));
+  th = calloc(o.nthreads + o.io_threads, sizeof(pthread_t));
+  if (p->slot == NULL || p->freeq == NULL || p->readyq == NULL || p->doneq == NULL || th == NULL) {
+    free(th);
+    result = FILECRYPT_NO_MEMORY;
+    goto done;
+  }
+  for (i = 0; i < p->depth; i++) {
+    if ((p->slot[i].buf = malloc(p->chunk)) == NULL) {
+      free(th);
+      result = FILECRYPT_NO_MEMORY;
+      goto done;
+    }
+    p->freeq[p->nfree++] = i;
+  }
+  pthread_mutex_init(&p->lock, NULL);
+  pthread_cond_init(&p->cond, NULL);
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (n = 0; n < o.nthreads; n++)
+    if (pthread_create(&th[n], NULL, crypt_worker, p) != 0)
+      break;
+  if (n == 0) {
+    pthread_mutex_lock(&p->lock);
+    fail(p, FILECRYPT_NO_MEMORY);
+    pthread_mutex_unlock(&p->lock);
+  }
+#ifdef USE_IO_URING
+  if (o.use_uring && uring_run(p) == 0)
+    uring = 1;
+#endif
+  if (!uring) {
+    for (i = 0; i < o.io_threads; i++, n++)
+      if (pthread_create(&th[n], NULL, io_worker, p) != 0)
+        break;
+    if (i == 0) {
+      pthread_mutex_lock(&p->lock);
+      fail(p, FILECRYPT_NO_MEMORY);
+      pthread_mutex_unlock(&p->lock);
+    }
+  }
+  while (n-- > 0)
+    pthread_join(th[n], NULL);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  free(th);
+  result = p->error;
+
+  if (stat != NULL) {
+    memset(stat, 0, sizeof(filecrypt_stat_t));
+    stat->bytes = p->size;
+    stat->nchunks = p->written;
+    stat->seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    stat->throughput = stat->seconds > 0 ? p->size / 1e6 / stat->seconds : 0;
+    stat->avg_qdepth = p->qd_samples ? (double)p->qd_sum / p->qd_samples : 0;
+    stat->max_qdepth = p->qd_max;
+    stat->uring = uring;
+  }
+  pthread_cond_destroy(&p->cond);
+  pthread_mutex_destroy(&p->lock);
+
+done:
+  // 라운드 키와 평문이 남아 있을 수 있는 버퍼를 지운 후 해제합니다.
+  memset(p->roundKey, 0, sizeof(p->roundKey));
+  if (p->slot != NULL)
+    for (i = 0; i < p->depth; i++)
+      if (p->slot[i].buf != NULL) {
+        memset(p->slot[i].buf, 0, p->chunk);
+        free(p->slot[i].buf);
+      }
+  free(p->slot);
+  free(p->freeq);
+  free(p->readyq);
+  free(p->doneq);
+  if (p->ifd >= 0)
+    close(p->ifd);
+  if (p->ofd >= 0 && close(p->ofd) < 0 && result == 0)
+    result = FILECRYPT_WRITE_FAIL;
+  free(p);
+  return result;
+}
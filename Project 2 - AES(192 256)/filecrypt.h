@@ -0,0 +1,57 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _FILECRYPT_H_
+#define _FILECRYPT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 파일 암호화 파이프라인 (AES-CTR)
+ * 암호문 파일은 BLOCKLEN 바이트의 초기 카운터 블록 뒤에 CTR 암호문이 이어지는 형식이다.
+ * 읽기, 암호화, 쓰기를 서로 다른 스레드가 담당하고 depth개의 버퍼를 돌려 쓰므로
+ * 디스크 I/O와 암호화 연산이 겹쳐서 진행된다.
+ */
+#define FILECRYPT_CHUNK   (1 << 20) /* 기본 청크 크기(바이트) */
+#define FILECRYPT_DEPTH   3         /* 기본 링 깊이(버퍼 수): 3이면 삼중 버퍼링 */
+#define FILECRYPT_THREADS 2         /* 기본 암호화 스레드 수 */
+#define FILECRYPT_IO      2         /* pread 대체 경로의 기본 I/O 스레드 수 */
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define FILECRYPT_INVALID_ARG 1
+#define FILECRYPT_OPEN_FAIL   2
+#define FILECRYPT_READ_FAIL   3
+#define FILECRYPT_WRITE_FAIL  4
+#define FILECRYPT_NO_MEMORY   5
+#define FILECRYPT_BAD_FORMAT  6
+
+typedef struct {
+    size_t chunk_size; /* 청크 크기, BLOCKLEN의 배수여야 한다 */
+    int depth;         /* 링 깊이: 동시에 사용하는 버퍼 수이며 io_uring 큐 크기이다 */
+    int nthreads;      /* 암호화 스레드 수 */
+    int io_threads;    /* pread/pwrite 스레드 수 (io_uring을 쓰지 않을 때) */
+    int use_uring;     /* USE_IO_URING으로 빌드된 경우 io_uring을 사용한다 */
+} filecrypt_opt_t;
+
+typedef struct {
+    uint64_t bytes;      /* 처리한 평문 바이트 수 */
+    uint64_t nchunks;    /* 처리한 청크 수 */
+    double seconds;      /* 경과 시간(초) */
+    double throughput;   /* 처리량(MB/s) */
+    double avg_qdepth;   /* 요청을 제출할 때마다 측정한 진행 중인 I/O 수의 평균 */
+    int max_qdepth;      /* 진행 중인 I/O 수의 최댓값 */
+    int uring;           /* 실제로 io_uring을 사용했으면 1 */
+} filecrypt_stat_t;
+
+void filecrypt_default(filecrypt_opt_t *opt);
+int filecrypt(const char *in, const char *out, const uint8_t *key, int length, int mode,
+              const filecrypt_opt_t *opt, filecrypt_stat_t *stat);
+
+#endif
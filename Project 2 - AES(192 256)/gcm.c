@@ -0,0 +1,180 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include "gcm.h"
+#include <string.h>
+
+// 4비트씩 오른쪽으로 밀 때 넘쳐 나간 비트를 기약 다항식 x^128 + x^7 + x^2 + x + 1로 줄인 값입니다.
+static const uint64_t last4[16] = {
+  0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+  0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0 };
+
+static uint64_t get_be64(const uint8_t *p)
+{
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+static void put_be64(uint8_t *p, uint64_t v)
+{
+  for (int i = 7; i >= 0; i--, v >>= 8)
+    p[i] = v & 0xFF;
+}
+
+// H = E_K(0^128)를 구하고 0~15의 4비트 값 각각에 H를 곱한 결과를 테이블로 만듭니다.
+// GF(2^128)에서 GCM은 비트 순서가 반대이므로 테이블의 8, 4, 2, 1 위치가 H, Hx, Hx^2, Hx^3입니다.
+void aes_gcm_init(gcm_ctx_t *ctx, const uint8_t *key, int length)
+{
+  uint8_t h[BLOCKLEN] = {0};
+  uint64_t vh, vl;
+
+  ctx->length = length;
+  KeyExpansion(key, ctx->roundKey, length);
+  Cipher(h, ctx->roundKey, ENCRYPT, length);
+
+  vh = get_be64(h);
+  vl = get_be64(h + 8);
+  ctx->HH[0] = ctx->HL[0] = 0;
+  ctx->HH[8] = vh;
+  ctx->HL[8] = vl;
+  for (int i = 4; i > 0; i >>= 1) {
+    uint64_t t = (vl & 1) * 0xe1000000U;
+    vl = (vh << 63) | (vl >> 1);
+    vh = (vh >> 1) ^ (t << 32);
+    ctx->HH[i] = vh;
+    ctx->HL[i] = vl;
+  }
+  for (int i = 2; i <= 8; i <<= 1)
+    for (int j = 1; j < i; j++) {
+      ctx->HH[i+j] = ctx->HH[i] ^ ctx->HH[j];
+      ctx->HL[i+j] = ctx->HL[i] ^ ctx->HL[j];
+    }
+}
+
+// x = x * H 를 4비트 테이블로 계산합니다.
+static void gcm_mult(const gcm_ctx_t *ctx, uint8_t *x)
+{
+  uint8_t lo, hi, rem;
+  uint64_t zh, zl;
+
+  lo = x[15] & 0xf;
+  zh = ctx->HH[lo];
+  zl = ctx->HL[lo];
+  for (int i = 15; i >= 0; i--) {
+    lo = x[i] & 0xf;
+    hi = (x[i] >> 4) & 0xf;
+    if (i != 15) {
+      rem = zl & 0xf;
+      zl = (zh << 60) | (zl >> 4);
+      zh = (zh >> 4) ^ (last4[rem] << 48);
+      zh ^= ctx->HH[lo];
+      zl ^= ctx->HL[lo];
+    }
+    rem = zl & 0xf;
+    zl = (zh << 60) | (zl >> 4);
+    zh = (zh >> 4) ^ (last4[rem] << 48);
+    zh ^= ctx->HH[hi];
+    zl ^= ctx->HL[hi];
+  }
+  put_be64(x, zh);
+  put_be64(x + 8, zl);
+}
+
+// 데이터를 16바이트씩 GHASH 누산기 y에 흡수합니다. 마지막 블록은 0으로 채운 것으로 봅니다.
+static void ghash(const gcm_ctx_t *ctx, uint8_t *y, const uint8_t *data, size_t len)
+{
+  while (len > 0) {
+    size_t n = len < BLOCKLEN ? len : BLOCKLEN;
+    for (size_t i = 0; i < n; i++)
+      y[i] ^= data[i];
+    gcm_mult(ctx, y);
+    data += n;
+    len -= n;
+  }
+}
+
+// 카운터 블록의 하위 32비트만 증가시킵니다(inc32).
+static void inc32(uint8_t *cb)
+{
+  for (int i = BLOCKLEN - 1; i >= BLOCKLEN - 4; i--)
+    if (++cb[i] != 0)
+      break;
+}
+
+static void gctr(const gcm_ctx_t *ctx, uint8_t *cb, const uint8_t *in, uint8_t *out, size_t len)
+{
+  uint8_t ks[BLOCKLEN];
+
+  while (len > 0) {
+    size_t n = len < BLOCKLEN ? len : BLOCKLEN;
+    inc32(cb);
+    memcpy(ks, cb, BLOCKLEN);
+    Cipher(ks, ctx->roundKey, ENCRYPT, ctx->length);
+    for (size_t i = 0; i < n; i++)
+      out[i] = in[i] ^ ks[i];
+    in += n;
+    out += n;
+    len -= n;
+  }
+}
+
+// GHASH(A || C || len(A) || len(C))를 E_K(J0)와 XOR하여 인증 태그를 만듭니다.
+static void gcm_tag(const gcm_ctx_t *ctx, const uint8_t *j0, const uint8_t *aad, size_t aad_len,
+                    const uint8_t *c, size_t len, uint8_t *tag)
+{
+  uint8_t y[BLOCKLEN] = {0}, lens[BLOCKLEN];
+
+  ghash(ctx, y, aad, aad_len);
+  ghash(ctx, y, c, len);
+  put_be64(lens, (uint64_t)aad_len << 3);
+  put_be64(lens + 8, (uint64_t)len << 3);
+  ghash(ctx, y, lens, BLOCKLEN);
+  memcpy(tag, j0, BLOCKLEN);
+  Cipher(tag, ctx->roundKey, ENCRYPT, ctx->length);
+  for (int i = 0; i < BLOCKLEN; i++)
+    tag[i] ^= y[i];
+}
+
+/*
+ * aes_gcm_seal() - 길이가 len인 in을 암호화하여 out에 저장하고 aad와 함께 인증하는 태그를 tag에 저장한다.
+ * iv는 GCM_IVLEN 바이트이며 같은 키로 두 번 사용해서는 안 된다. in과 out은 같아도 된다.
+ */
+void aes_gcm_seal(const gcm_ctx_t *ctx, const uint8_t *iv, const uint8_t *aad, size_t aad_len,
+                  const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag)
+{
+  uint8_t j0[BLOCKLEN] = {0}, cb[BLOCKLEN];
+
+  memcpy(j0, iv, GCM_IVLEN);
+  j0[BLOCKLEN-1] = 1;
+  memcpy(cb, j0, BLOCKLEN);
+  gctr(ctx, cb, in, out, len);
+  gcm_tag(ctx, j0, aad, aad_len, out, len, tag);
+}
+
+/*
+ * aes_gcm_open() - 태그를 검증한 후 in을 복호화하여 out에 저장한다.
+ * 검증에 실패하면 out에 아무것도 쓰지 않고 GCM_AUTH_FAIL을 넘겨준다.
+ */
+int aes_gcm_open(const gcm_ctx_t *ctx, const uint8_t *iv, const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out, const uint8_t *tag)
+{
+  uint8_t j0[BLOCKLEN] = {0}, cb[BLOCKLEN], t[GCM_TAGLEN], diff = 0;
+
+  memcpy(j0, iv, GCM_IVLEN);
+  j0[BLOCKLEN-1] = 1;
+  gcm_tag(ctx, j0, aad, aad_len, in, len, t);
+  // 태그 비교 시간이 일치하는 바이트 수에 따라 달라지지 않도록 모든 바이트를 비교합니다.
+  for (int i = 0; i < GCM_TAGLEN; i++)
+    diff |= t[i] ^ tag[i];
+  if (diff)
+    return GCM_AUTH_FAIL;
+  memcpy(cb, j0, BLOCKLEN);
+  gctr(ctx, cb, in, out, len);
+  return 0;
+}
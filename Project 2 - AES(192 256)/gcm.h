@@ -0,0 +1,42 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _GCM_H_
+#define _GCM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "aes.h"
+
+/*
+ * AES-GCM (NIST SP 800-38D), 96비트 IV만 지원한다.
+ */
+#define GCM_IVLEN  12
+#define GCM_TAGLEN 16
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define GCM_AUTH_FAIL 1
+
+/*
+ * 키마다 한 번 만드는 문맥으로 라운드 키와 GHASH 곱셈용 4비트 테이블(H의 배수)을 담는다.
+ * 초기화 이후에는 읽기만 하므로 여러 스레드가 공유해도 된다.
+ */
+typedef struct {
+    uint32_t roundKey[RNDKEYLEN_256];
+    int length;
+    uint64_t HL[16], HH[16];
+} gcm_ctx_t;
+
+void aes_gcm_init(gcm_ctx_t *ctx, const uint8_t *key, int length);
+void aes_gcm_seal(const gcm_ctx_t *ctx, const uint8_t *iv, const uint8_t *aad, size_t aad_len,
+                  const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag);
+int aes_gcm_open(const gcm_ctx_t *ctx, const uint8_t *iv, const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out, const uint8_t *tag);
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include "modes.h"
+#include <string.h>
+
+// 카운터 블록을 빅 엔디안 128비트 정수로 보고 blocks만큼 더합니다.
+// 청크 단위로 나누어 병렬 처리할 때 각 청크의 시작 카운터를 바로 계산하기 위해 사용합니다.
+void aes_ctr_add(uint8_t *ctr, uint64_t blocks)
+{
+  uint64_t carry = blocks;
+  for (int i = BLOCKLEN - 1; i >= 0 && carry; i--) {
+    carry += ctr[i];
+    ctr[i] = carry & 0xFF;
+    carry >>= 8;
+  }
+}
+
+// 카운터 블록을 암호화한 키 스트림을 입력과 XOR합니다.
+// 마지막 블록이 일부만 사용되더라도 카운터는 한 블록 증가합니다.
+void aes_ctr_crypt(const uint32_t *roundKey, int length, uint8_t *ctr,
+                   const uint8_t *in, uint8_t *out, size_t len)
+{
+  uint8_t ks[BLOCKLEN];
+
+  while (len > 0) {
+    size_t n = len < BLOCKLEN ? len : BLOCKLEN;
+    memcpy(ks, ctr, BLOCKLEN);
+    Cipher(ks, roundKey, ENCRYPT, length);
+    for (size_t i = 0; i < n; i++)
+      out[i] = in[i] ^ ks[i];
+    aes_ctr_add(ctr, 1);
+    in += n;
+    out += n;
+    len -= n;
+  }
+}
+
+// 평문 블록을 직전 암호문 블록(처음에는 iv)과 XOR한 후 암호화합니다.
+void aes_cbc_encrypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                     const uint8_t *in, uint8_t *out, size_t len)
+{
+  for (; len >= BLOCKLEN; len -= BLOCKLEN, in += BLOCKLEN, out += BLOCKLEN) {
+    for (int i = 0; i < BLOCKLEN; i++)
+      iv[i] ^= in[i];
+    Cipher(iv, roundKey, ENCRYPT, length);
+    memcpy(out, iv, BLOCKLEN);
+  }
+}
+
+// 암호문 블록을 복호화한 후 직전 암호문 블록과 XOR합니다. in과 out이 같을 수 있으므로 암호문을 먼저 보관합니다.
+void aes_cbc_decrypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                     const uint8_t *in, uint8_t *out, size_t len)
+{
+  uint8_t c[BLOCKLEN], b[BLOCKLEN];
+
+  for (; len >= BLOCKLEN; len -= BLOCKLEN, in += BLOCKLEN, out += BLOCKLEN) {
+    memcpy(c, in, BLOCKLEN);
+    memcpy(b, in, BLOCKLEN);
+    Cipher(b, roundKey, DECRYPT, length);
+    for (int i = 0; i < BLOCKLEN; i++)
+      out[i] = b[i] ^ iv[i];
+    memcpy(iv, c, BLOCKLEN);
+  }
+}
+
+// 직전 키 스트림 블록을 다시 암호화하여 다음 키 스트림 블록을 만들고 입력과 XOR합니다.
+void aes_ofb_crypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                   const uint8_t *in, uint8_t *out, size_t len)
+{
+  while (len > 0) {
+    size_t n = len < BLOCKLEN ? len : BLOCKLEN;
+    Cipher(iv, roundKey, ENCRYPT, length);
+    for (size_t i = 0; i < n; i++)
+      out[i] = in[i] ^ iv[i];
+    in += n;
+    out += n;
+    len -= n;
+  }
+}
+
+// 직전 암호문 블록을 암호화한 값과 평문을 XOR하여 암호문을 만들고, 그 암호문이 다음 입력이 됩니다.
+void aes_cfb_encrypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                     const uint8_t *in, uint8_t *out, size_t len)
+{
+  while (len > 0) {
+    size_t n = len < BLOCKLEN ? len : BLOCKLEN;
+    Cipher(iv, roundKey, ENCRYPT, length);
+    for (size_t i = 0; i < n; i++)
+      out[i] = iv[i] ^= in[i];
+    in += n;
+    out += n;
+    len -= n;
+  }
+}
+
+// 복호화도 블록 암호는 암호화 방향으로 사용합니다. in과 out이 같을 수 있으므로 암호문을 먼저 보관합니다.
+void aes_cfb_decrypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                     const uint8_t *in, uint8_t *out, size_t len)
+{
+  uint8_t c;
+
+  while (len > 0) {
+    size_t n = len < BLOCKLEN ? len : BLOCKLEN;
+    Cipher(iv, roundKey, ENCRYPT, length);
+    for (size_t i = 0; i < n; i++) {
+      c = in[i];
+      out[i] = iv[i] ^ c;
+      iv[i] = c;
+    }
+    in += n;
+    out += n;
+    len -= n;
+  }
+}
+
+// 트윅에 GF(2^128)의 원시원소 α를 곱합니다. XTS는 리틀 엔디안이므로 바이트 0이 최하위입니다.
+static void xts_mul_alpha(uint8_t *t)
+{
+  uint8_t carry = t[BLOCKLEN-1] >> 7;
+
+  for (int i = BLOCKLEN - 1; i > 0; i--)
+    t[i] = (t[i] << 1) | (t[i-1] >> 7);
+  t[0] = (t[0] << 1) ^ (carry * 0x87);
+}
+
+// 한 블록을 out = E(in ^ t) ^ t (복호화는 D)로 처리합니다.
+static void xts_block(const uint32_t *roundKey, int length, int mode, const uint8_t *t,
+                      const uint8_t *in, uint8_t *out)
+{
+  uint8_t b[BLOCKLEN];
+
+  for (int i = 0; i < BLOCKLEN; i++)
+    b[i] = in[i] ^ t[i];
+  Cipher(b, roundKey, mode, length);
+  for (int i = 0; i < BLOCKLEN; i++)
+    out[i] = b[i] ^ t[i];
+}
+
+// 트윅 T = E_K2(unit)를 구하고 블록마다 α를 곱해 가며 처리합니다.
+// 마지막 블록이 b바이트뿐이면 바로 앞 블록의 암호문 뒷부분을 빌려 채우고, 두 블록의 자리를 바꿉니다.
+int aes_xts_crypt(const uint32_t *roundKey1, const uint32_t *roundKey2, int length, int mode,
+                  uint64_t unit, const uint8_t *in, uint8_t *out, size_t len)
+{
+  uint8_t t[BLOCKLEN] = {0}, t2[BLOCKLEN], cc[BLOCKLEN], tail[BLOCKLEN];
+  size_t m = len / BLOCKLEN, b = len % BLOCKLEN;
+
+  if (len < BLOCKLEN)
+    return XTS_INVALID_LEN;
+  for (int i = 0; i < 8; i++)
+    t[i] = (unit >> (8*i)) & 0xFF;
+  Cipher(t, roundKey2, ENCRYPT, length);
+  // 암호문 훔치기를 하는 경우 마지막 완전한 블록은 따로 처리합니다.
+  for (size_t j = 0; j < (b ? m - 1 : m); j++) {
+    xts_block(roundKey1, length, mode, t, in, out);
+    xts_mul_alpha(t);
+    in += BLOCKLEN;
+    out += BLOCKLEN;
+  }
+  if (b == 0)
+    return 0;
+  // 복호화에서는 훔친 블록을 나중 트윅(T_m)으로 먼저 풀어야 하므로 두 트윅의 사용 순서가 바뀝니다.
+  memcpy(t2, t, BLOCKLEN);
+  xts_mul_alpha(t2);
+  memcpy(tail, in + BLOCKLEN, b);
+  xts_block(roundKey1, length, mode, mode == ENCRYPT ? t : t2, in, cc);
+  memcpy(out + BLOCKLEN, cc, b);
+  memcpy(cc, tail, b);
+  xts_block(roundKey1, length, mode, mode == ENCRYPT ? t2 : t, cc, out);
+  return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _MODES_H_
+#define _MODES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "aes.h"
+
+/*
+ * 블록 암호 운영 모드 (NIST SP 800-38A)
+ * roundKey와 length는 KeyExpansion(), Cipher()에 전달하는 값과 같다.
+ * length는 AES128, AES192, AES256 중 하나이다.
+ */
+
+/*
+ * CTR 모드: ctr는 BLOCKLEN 바이트 카운터 블록으로 호출이 끝나면 다음 블록 위치로 갱신된다.
+ * 암호화와 복호화가 같은 연산이며 len은 BLOCKLEN의 배수가 아니어도 된다.
+ */
+void aes_ctr_crypt(const uint32_t *roundKey, int length, uint8_t *ctr,
+                   const uint8_t *in, uint8_t *out, size_t len);
+void aes_ctr_add(uint8_t *ctr, uint64_t blocks);
+
+/*
+ * CBC 모드: iv는 BLOCKLEN 바이트이며 호출이 끝나면 마지막 암호문 블록으로 갱신되어 이어서 호출할 수 있다.
+ * len은 BLOCKLEN의 배수여야 하며 패딩은 호출하는 쪽에서 처리한다. in과 out은 같아도 된다.
+ */
+void aes_cbc_encrypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                     const uint8_t *in, uint8_t *out, size_t len);
+void aes_cbc_decrypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                     const uint8_t *in, uint8_t *out, size_t len);
+
+/*
+ * OFB 모드: iv는 직전 키 스트림 블록(처음에는 IV)이며 호출이 끝나면 갱신된다. 암호화와 복호화가 같은 연산이며
+ * 마지막 블록이 일부만 사용되더라도 다음 호출은 새 키 스트림 블록부터 시작한다.
+ * CFB 모드(CFB128): iv는 직전 암호문 블록(처음에는 IV)이며 len이 BLOCKLEN의 배수가 아니면 마지막 호출이어야 한다.
+ */
+void aes_ofb_crypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                   const uint8_t *in, uint8_t *out, size_t len);
+void aes_cfb_encrypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                     const uint8_t *in, uint8_t *out, size_t len);
+void aes_cfb_decrypt(const uint32_t *roundKey, int length, uint8_t *iv,
+                     const uint8_t *in, uint8_t *out, size_t len);
+
+/*
+ * XTS 모드 (IEEE 1619, NIST SP 800-38E): roundKey1은 데이터 키, roundKey2는 트윅 키의 라운드 키이고
+ * unit은 데이터 단위(섹터) 번호이다. 한 번의 호출이 데이터 단위 하나를 처리하며
+ * len이 BLOCKLEN의 배수가 아니면 암호문 훔치기(ciphertext stealing)를 사용한다.
+ * len이 BLOCKLEN보다 작으면 XTS_INVALID_LEN을 넘겨준다.
+ */
+#define XTS_INVALID_LEN 1
+
+int aes_xts_crypt(const uint32_t *roundKey1, const uint32_t *roundKey2, int length, int mode,
+                  uint64_t unit, const uint8_t *in, uint8_t *out, size_t len);
+
+#endif
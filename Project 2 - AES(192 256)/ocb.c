@@ -0,0 +1,198 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include "ocb.h"
+#include <string.h>
+
+// 한 번에 처리하는 블록 수입니다. 오프셋 계산과 블록 암호화를 나누어 블록 사이의 의존성을 없앱니다.
+#define OCB_PAR 8
+
+// d = a ^ b (16바이트), 64비트 단위로 XOR합니다.
+static void xor_block(uint8_t *d, const uint8_t *a, const uint8_t *b)
+{
+  uint64_t x[2], y[2];
+
+  memcpy(x, a, BLOCKLEN);
+  memcpy(y, b, BLOCKLEN);
+  x[0] ^= y[0];
+  x[1] ^= y[1];
+  memcpy(d, x, BLOCKLEN);
+}
+
+// GF(2^128)에서 2를 곱합니다(double). 최상위 비트가 넘치면 x^7 + x^2 + x + 1(0x87)로 줄입니다.
+static void dbl(uint8_t *d, const uint8_t *s)
+{
+  uint8_t carry = s[0] >> 7;
+
+  for (int i = 0; i < BLOCKLEN - 1; i++)
+    d[i] = (s[i] << 1) | (s[i+1] >> 7);
+  d[BLOCKLEN-1] = (s[BLOCKLEN-1] << 1) ^ (carry * 0x87);
+}
+
+// L_* = E_K(0^128), L_$ = double(L_*), L_0 = double(L_$), L_i = double(L_{i-1})를 미리 계산합니다.
+void aes_ocb_init(ocb_ctx_t *ctx, const uint8_t *key, int length)
+{
+  ctx->length = length;
+  KeyExpansion(key, ctx->roundKey, length);
+  memset(ctx->L_star, 0, BLOCKLEN);
+  Cipher(ctx->L_star, ctx->roundKey, ENCRYPT, length);
+  dbl(ctx->L_dollar, ctx->L_star);
+  dbl(ctx->L[0], ctx->L_dollar);
+  for (int i = 1; i < OCB_LMAX; i++)
+    dbl(ctx->L[i], ctx->L[i-1]);
+}
+
+// nonce로부터 첫 오프셋 Offset_0를 만듭니다.
+// Nonce = 태그 길이(7비트) || 0...0 || 1 || N 에서 하위 6비트(bottom)를 떼어 Ktop = E_K(나머지)를 구하고
+// Stretch = Ktop || (Ktop[0..7] ^ Ktop[1..8])를 bottom 비트만큼 왼쪽으로 민 앞 128비트가 Offset_0입니다.
+static void ocb_offset0(const ocb_ctx_t *ctx, const uint8_t *nonce, uint8_t *off)
+{
+  uint8_t n[BLOCKLEN] = {0}, stretch[BLOCKLEN + 8];
+  int bottom, byte, bit;
+
+  n[0] = ((OCB_TAGLEN * 8) % 128) << 1;
+  n[BLOCKLEN - 1 - OCB_NONCELEN] |= 1;
+  memcpy(n + BLOCKLEN - OCB_NONCELEN, nonce, OCB_NONCELEN);
+  bottom = n[BLOCKLEN-1] & 0x3f;
+  n[BLOCKLEN-1] &= 0xc0;
+  Cipher(n, ctx->roundKey, ENCRYPT, ctx->length);
+  memcpy(stretch, n, BLOCKLEN);
+  for (int i = 0; i < 8; i++)
+    stretch[BLOCKLEN+i] = n[i] ^ n[i+1];
+  byte = bottom / 8;
+  bit = bottom % 8;
+  for (int i = 0; i < BLOCKLEN; i++)
+    off[i] = bit ? (stretch[i+byte] << bit) | (stretch[i+byte+1] >> (8 - bit)) : stretch[i+byte];
+}
+
+// HASH(K, A): 블록마다 오프셋을 L_ntz(i)로 갱신하여 E_K(A_i ^ Offset_i)를 모두 XOR합니다.
+static void ocb_hash(const ocb_ctx_t *ctx, const uint8_t *aad, size_t aad_len, uint8_t *sum)
+{
+  uint8_t off[BLOCKLEN] = {0}, t[BLOCKLEN];
+  uint64_t i;
+
+  memset(sum, 0, BLOCKLEN);
+  for (i = 1; aad_len >= BLOCKLEN; i++, aad += BLOCKLEN, aad_len -= BLOCKLEN) {
+    xor_block(off, off, ctx->L[__builtin_ctzll(i)]);
+    xor_block(t, aad, off);
+    Cipher(t, ctx->roundKey, ENCRYPT, ctx->length);
+    xor_block(sum, sum, t);
+  }
+  // 마지막 블록이 16바이트보다 짧으면 10...0으로 채우고 L_*를 오프셋에 더합니다.
+  if (aad_len > 0) {
+    xor_block(off, off, ctx->L_star);
+    memset(t, 0, BLOCKLEN);
+    memcpy(t, aad, aad_len);
+    t[aad_len] = 0x80;
+    xor_block(t, t, off);
+    Cipher(t, ctx->roundKey, ENCRYPT, ctx->length);
+    xor_block(sum, sum, t);
+  }
+}
+
+// 암호화와 복호화 공통 부분으로, 처리 결과를 out에 쓰고 계산한 태그를 tag에 저장합니다.
+// 본 루프는 OCB_PAR개 블록의 오프셋을 먼저 모두 구한 뒤 블록 암호화를 연달아 수행하고,
+// 평문 체크섬은 64비트 단위 XOR로 누적합니다.
+static void ocb_crypt(const ocb_ctx_t *ctx, int mode, const uint8_t *nonce, const uint8_t *aad, size_t aad_len,
+                      const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag)
+{
+  uint8_t off[BLOCKLEN], sum[BLOCKLEN] = {0}, pad[BLOCKLEN], h[BLOCKLEN];
+  uint8_t offs[OCB_PAR][BLOCKLEN], buf[OCB_PAR][BLOCKLEN];
+  uint64_t i = 0;
+  size_t rem;
+
+  ocb_offset0(ctx, nonce, off);
+  for (; len >= OCB_PAR * BLOCKLEN; len -= OCB_PAR * BLOCKLEN, in += OCB_PAR * BLOCKLEN, out += OCB_PAR * BLOCKLEN) {
+    for (int j = 0; j < OCB_PAR; j++) {
+      xor_block(off, off, ctx->L[__builtin_ctzll(++i)]);
+      memcpy(offs[j], off, BLOCKLEN);
+      xor_block(buf[j], in + j*BLOCKLEN, off);
+      if (mode == ENCRYPT)
+        xor_block(sum, sum, in + j*BLOCKLEN);
+    }
+    for (int j = 0; j < OCB_PAR; j++)
+      Cipher(buf[j], ctx->roundKey, mode, ctx->length);
+    for (int j = 0; j < OCB_PAR; j++) {
+      xor_block(out + j*BLOCKLEN, buf[j], offs[j]);
+      if (mode == DECRYPT)
+        xor_block(sum, sum, out + j*BLOCKLEN);
+    }
+  }
+  // OCB_PAR개가 안 되는 나머지 완전한 블록은 한 블록씩 처리합니다.
+  for (; len >= BLOCKLEN; len -= BLOCKLEN, in += BLOCKLEN, out += BLOCKLEN) {
+    xor_block(off, off, ctx->L[__builtin_ctzll(++i)]);
+    xor_block(buf[0], in, off);
+    if (mode == ENCRYPT)
+      xor_block(sum, sum, in);
+    Cipher(buf[0], ctx->roundKey, mode, ctx->length);
+    xor_block(out, buf[0], off);
+    if (mode == DECRYPT)
+      xor_block(sum, sum, out);
+  }
+  // 마지막 블록이 16바이트보다 짧으면 Pad = E_K(Offset ^ L_*)와 XOR하고 평문을 10...0으로 채워 체크섬에 더합니다.
+  rem = len;
+  if (rem > 0) {
+    xor_block(off, off, ctx->L_star);
+    memcpy(pad, off, BLOCKLEN);
+    Cipher(pad, ctx->roundKey, ENCRYPT, ctx->length);
+    for (size_t k = 0; k < rem; k++) {
+      uint8_t p = mode == ENCRYPT ? in[k] : in[k] ^ pad[k];
+      out[k] = in[k] ^ pad[k];
+      sum[k] ^= p;
+    }
+    sum[rem] ^= 0x80;
+  }
+  // Tag = E_K(Checksum ^ Offset ^ L_$) ^ HASH(K, A)
+  xor_block(tag, sum, off);
+  xor_block(tag, tag, ctx->L_dollar);
+  Cipher(tag, ctx->roundKey, ENCRYPT, ctx->length);
+  ocb_hash(ctx, aad, aad_len, h);
+  xor_block(tag, tag, h);
+}
+
+// 블록 번호 i의 ntz(i)가 L 테이블 범위 안에 들도록 메시지와 AAD는 2^OCB_LMAX 블록보다 짧아야 합니다.
+static int ocb_too_long(size_t aad_len, size_t len)
+{
+  return ((uint64_t)aad_len / BLOCKLEN >> OCB_LMAX) || ((uint64_t)len / BLOCKLEN >> OCB_LMAX);
+}
+
+/*
+ * aes_ocb_seal() - 길이가 len인 in을 암호화하여 out에 저장하고 aad와 함께 인증하는 태그를 tag에 저장한다.
+ * nonce는 OCB_NONCELEN 바이트이며 같은 키로 두 번 사용해서는 안 된다. in과 out은 같아도 된다.
+ * 메시지나 AAD가 2^32 블록 이상이면 아무것도 쓰지 않고 OCB_INVALID_LEN을 넘겨준다.
+ */
+int aes_ocb_seal(const ocb_ctx_t *ctx, const uint8_t *nonce, const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag)
+{
+  if (ocb_too_long(aad_len, len))
+    return OCB_INVALID_LEN;
+  ocb_crypt(ctx, ENCRYPT, nonce, aad, aad_len, in, len, out, tag);
+  return 0;
+}
+
+/*
+ * aes_ocb_open() - in을 복호화하여 out에 저장하고 태그를 검증한다.
+ * OCB는 복호화한 평문으로 체크섬을 만들기 때문에 검증 전에 out에 평문이 쓰인다.
+ * 검증에 실패하면 out을 0으로 지우고 OCB_AUTH_FAIL을, 길이가 너무 길면 OCB_INVALID_LEN을 넘겨준다.
+ */
+int aes_ocb_open(const ocb_ctx_t *ctx, const uint8_t *nonce, const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out, const uint8_t *tag)
+{
+  uint8_t t[OCB_TAGLEN], diff = 0;
+
+  if (ocb_too_long(aad_len, len))
+    return OCB_INVALID_LEN;
+  ocb_crypt(ctx, DECRYPT, nonce, aad, aad_len, in, len, out, t);
+  // 태그 비교 시간이 일치하는 바이트 수에 따라 달라지지 않도록 모든 바이트를 비교합니다.
+  for (int i = 0; i < OCB_TAGLEN; i++)
+    diff |= t[i] ^ tag[i];
+  if (diff) {
+    memset(out, 0, len);
+    return OCB_AUTH_FAIL;
+  }
+  return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _OCB_H_
+#define _OCB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "aes.h"
+
+/*
+ * AES-OCB3 (RFC 7253), 96비트 nonce와 128비트 태그만 지원한다.
+ */
+#define OCB_NONCELEN 12
+#define OCB_TAGLEN   16
+#define OCB_LMAX     32  /* L_0 .. L_31, 메시지와 AAD는 각각 최대 2^32 - 1 블록 */
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define OCB_AUTH_FAIL   1
+#define OCB_INVALID_LEN 2  /* 메시지나 AAD가 2^32 블록 이상이다. */
+
+/*
+ * 키마다 한 번 만드는 문맥으로 라운드 키와 오프셋 계산용 L_*, L_$, L_i 테이블을 담는다.
+ * 초기화 이후에는 읽기만 하므로 여러 스레드가 공유해도 된다.
+ */
+typedef struct {
+    uint32_t roundKey[RNDKEYLEN_256];
+    int length;
+    uint8_t L_star[BLOCKLEN], L_dollar[BLOCKLEN];
+    uint8_t L[OCB_LMAX][BLOCKLEN];
+} ocb_ctx_t;
+
+void aes_ocb_init(ocb_ctx_t *ctx, const uint8_t *key, int length);
+int aes_ocb_seal(const ocb_ctx_t *ctx, const uint8_t *nonce, const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out, uint8_t *tag);
+int aes_ocb_open(const ocb_ctx_t *ctx, const uint8_t *nonce, const uint8_t *aad, size_t aad_len,
+                 const uint8_t *in, size_t len, uint8_t *out, const uint8_t *tag);
+
+#endif
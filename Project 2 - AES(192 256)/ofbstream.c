@@ -0,0 +1,144 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "ofbstream.h"
+
+// 생성 스레드: 링 버퍼에 빈 자리가 한 블록 이상 있으면 다음 키 스트림 블록을 만들어 채웁니다.
+// 버퍼가 가득 차면 소비자가 자리를 비울 때까지 잠듭니다.
+static void *generator(void *arg)
+{
+  ofbstream_t *s = arg;
+  uint64_t h, t;
+
+  while (!atomic_load(&s->stop)) {
+    h = atomic_load_explicit(&s->head, memory_order_relaxed);
+    t = atomic_load_explicit(&s->tail, memory_order_acquire);
+    if (h - t + BLOCKLEN > s->size) {
+      pthread_mutex_lock(&s->lock);
+      atomic_store(&s->gen_waiting, 1);
+      while (!atomic_load(&s->stop) && h - atomic_load(&s->tail) + BLOCKLEN > s->size)
+        pthread_cond_wait(&s->space, &s->lock);
+      atomic_store(&s->gen_waiting, 0);
+      pthread_mutex_unlock(&s->lock);
+      continue;
+    }
+    Cipher(s->iv, s->roundKey, ENCRYPT, s->length);
+    memcpy(s->ring + (h & (s->size - 1)), s->iv, BLOCKLEN);
+    // head 저장과 cons_waiting 읽기의 순서가 바뀌지 않도록 seq_cst로 저장합니다(소비자도 같음).
+    atomic_store(&s->head, h + BLOCKLEN);
+    // 소비자가 키 스트림을 기다리며 잠들어 있을 때만 잠금을 잡고 깨웁니다.
+    if (atomic_load(&s->cons_waiting)) {
+      pthread_mutex_lock(&s->lock);
+      pthread_cond_signal(&s->data);
+      pthread_mutex_unlock(&s->lock);
+    }
+  }
+  return NULL;
+}
+
+/*
+ * ofbstream_start() - key와 iv로 OFB 키 스트림 생성 스레드를 시작한다.
+ * ring_size는 BLOCKLEN 이상인 2의 거듭제곱이어야 하며 0이면 OFBSTREAM_RING을 사용한다.
+ * 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int ofbstream_start(ofbstream_t *s, const uint8_t *key, int length, const uint8_t *iv, size_t ring_size)
+{
+  if (ring_size == 0)
+    ring_size = OFBSTREAM_RING;
+  if (s == NULL || key == NULL || iv == NULL || length < AES128 || length > AES256
+      || ring_size < BLOCKLEN || (ring_size & (ring_size - 1)))
+    return OFBSTREAM_INVALID_ARG;
+  memset(s, 0, sizeof(*s));
+  if ((s->ring = malloc(ring_size)) == NULL)
+    return OFBSTREAM_NO_MEMORY;
+  s->size = ring_size;
+  s->length = length;
+  KeyExpansion(key, s->roundKey, length);
+  memcpy(s->iv, iv, BLOCKLEN);
+  atomic_init(&s->head, 0);
+  atomic_init(&s->tail, 0);
+  atomic_init(&s->gen_waiting, 0);
+  atomic_init(&s->cons_waiting, 0);
+  atomic_init(&s->stop, 0);
+  pthread_mutex_init(&s->lock, NULL);
+  pthread_cond_init(&s->space, NULL);
+  pthread_cond_init(&s->data, NULL);
+  if (pthread_create(&s->thread, NULL, generator, s) != 0) {
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->space);
+    pthread_cond_destroy(&s->data);
+    free(s->ring);
+    memset(s, 0, sizeof(*s));
+    return OFBSTREAM_THREAD_FAIL;
+  }
+  return 0;
+}
+
+/*
+ * ofbstream_xor() - 링 버퍼의 키 스트림 len 바이트를 in과 XOR하여 out에 저장한다. in과 out은 같아도 된다.
+ * 키 스트림이 모자라면 생성 스레드가 채울 때까지 기다린다. 한 스트림은 한 스레드만 소비해야 한다.
+ */
+void ofbstream_xor(ofbstream_t *s, const uint8_t *in, uint8_t *out, size_t len)
+{
+  uint64_t t = atomic_load_explicit(&s->tail, memory_order_relaxed), h;
+
+  while (len > 0) {
+    h = atomic_load_explicit(&s->head, memory_order_acquire);
+    if (h == t) {
+      pthread_mutex_lock(&s->lock);
+      atomic_store(&s->cons_waiting, 1);
+      while (atomic_load(&s->head) == t)
+        pthread_cond_wait(&s->data, &s->lock);
+      atomic_store(&s->cons_waiting, 0);
+      pthread_mutex_unlock(&s->lock);
+      continue;
+    }
+    // 링 버퍼 끝에서 끊기지 않는 만큼만 한 번에 처리합니다.
+    size_t off = t & (s->size - 1), n = h - t;
+    if (n > s->size - off)
+      n = s->size - off;
+    if (n > len)
+      n = len;
+    for (size_t i = 0; i < n; i++)
+      out[i] = in[i] ^ s->ring[off + i];
+    t += n;
+    in += n;
+    out += n;
+    len -= n;
+    atomic_store(&s->tail, t);
+    if (atomic_load(&s->gen_waiting)) {
+      pthread_mutex_lock(&s->lock);
+      pthread_cond_signal(&s->space);
+      pthread_mutex_unlock(&s->lock);
+    }
+  }
+}
+
+// 지금 바로 사용할 수 있는 키 스트림의 바이트 수를 넘겨줍니다.
+size_t ofbstream_avail(ofbstream_t *s)
+{
+  return atomic_load(&s->head) - atomic_load(&s->tail);
+}
+
+void ofbstream_stop(ofbstream_t *s)
+{
+  if (s->ring == NULL)
+    return;
+  pthread_mutex_lock(&s->lock);
+  atomic_store(&s->stop, 1);
+  pthread_cond_signal(&s->space);
+  pthread_mutex_unlock(&s->lock);
+  pthread_join(s->thread, NULL);
+  pthread_mutex_destroy(&s->lock);
+  pthread_cond_destroy(&s->space);
+  pthread_cond_destroy(&s->data);
+  memset(s->ring, 0, s->size);
+  free(s->ring);
+  memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _OFBSTREAM_H_
+#define _OFBSTREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "aes.h"
+
+/*
+ * OFB 키 스트림 미리 생성기
+ *
+ * OFB의 키 스트림은 평문과 무관하므로 백그라운드 스레드가 링 버퍼를 미리 채워 두고,
+ * ofbstream_xor()는 링 버퍼에서 키 스트림을 꺼내 XOR만 한다. 생성 스레드 하나와 소비자 하나가
+ * head, tail을 원자적으로 갱신하므로 키 스트림이 남아 있는 동안 소비자는 잠금을 잡지 않는다.
+ * 출력은 같은 키와 IV로 aes_ofb_crypt()를 이어서 호출한 결과와 같다(블록 중간에서 끊어 호출해도 된다).
+ */
+#define OFBSTREAM_RING (64 * 1024)  /* 기본 링 버퍼 크기(바이트) */
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define OFBSTREAM_INVALID_ARG 1
+#define OFBSTREAM_NO_MEMORY   2
+#define OFBSTREAM_THREAD_FAIL 3
+
+typedef struct {
+    uint32_t roundKey[RNDKEYLEN_256];
+    int length;
+    uint8_t iv[BLOCKLEN];          /* 생성 스레드만 사용하는 직전 키 스트림 블록 */
+    uint8_t *ring;
+    size_t size;                   /* 링 버퍼 크기, BLOCKLEN 이상인 2의 거듭제곱 */
+    atomic_uint_fast64_t head;     /* 지금까지 생성한 바이트 수 */
+    atomic_uint_fast64_t tail;     /* 지금까지 소비한 바이트 수 */
+    atomic_int gen_waiting, cons_waiting, stop;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t space, data;
+} ofbstream_t;
+
+int ofbstream_start(ofbstream_t *s, const uint8_t *key, int length, const uint8_t *iv, size_t ring_size);
+void ofbstream_xor(ofbstream_t *s, const uint8_t *in, uint8_t *out, size_t len);
+size_t ofbstream_avail(ofbstream_t *s);
+void ofbstream_stop(ofbstream_t *s);
+
+#endif
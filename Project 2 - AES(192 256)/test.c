@@ -7,10 +7,23 @@
  * 수정 내용 : 
  *   - 20240916 : 없음
  *   - 20240927 : AES-192,256 검증용 벡터값 추가, AES-192,256 검증 로직 추가
+ *   - 20261018 : CTR 모드 검증 추가 (NIST SP 800-38A F.5.1)
+ *   - 20261018 : GCM 검증 추가 (GCM 명세 Test Case 4)
+ *   - 20261018 : gf8_mul_region 검증 추가
+ *   - 20261018 : OCB 검증 추가 (RFC 7253 부록 A)
+ *   - 20261018 : XTS 모드 검증 추가 (IEEE 1619 Vector 1, 암호문 훔치기 왕복)
+ *   - 20261018 : AES-CBC + HMAC-SHA256 검증 추가 (draft-mcgrew-aead-aes-cbc-hmac-sha2 5.1)
+ *   - 20261018 : OFB, CFB 모드 및 OFB 키 스트림 생성기 검증 추가 (NIST SP 800-38A F.3.13, F.4.1)
+ *   - 20261018 : 세그먼트 단위 AES-GCM 파일 왕복 및 잘림, 변조 거부 검증 추가
+ *   - 20261019 : CTR 파일 암호화 파이프라인 왕복 검증 추가
+ *   - 20261019 : XTS 검증 벡터 추가 (IEEE 1619 Vector 2, 15), 암호 파일 임의 위치 읽기 검증 추가
+ *   - 20261019 : gf8_mul 전수 검증 추가 (0을 곱하는 경우 포함)
+ *   - 20261019 : 세그먼트 GCM 파일 키의 salt 검증 추가
  */
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #ifdef __linux__
 #include <bsd/stdlib.h>
 #elif __APPLE__
@@ -19,6 +32,14 @@
 #include <stdlib.h>
 #endif
 #include "aes.h"
+#include "modes.h"
+#include "gcm.h"
+#include "aeadfile.h"
+#include "filecrypt.h"
+#include "encreader.h"
+#include "ocb.h"
+#include "cbchmac.h"
+#include "ofbstream.h"
 #include <endian.h>
 
 /*
@@ -111,6 +132,168 @@ uint32_t rkey[3][RNDKEYLEN_256] = {
      0xcc79fc24, 0xe97909bf, 0x3cc21a37, 0x36de686d}
 };
 
+/*
+ * 운영 모드 검증용 벡터값 (NIST SP 800-38A, AES-128)
+ */
+uint8_t mkey[KEYLEN] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+uint8_t mptxt[4*BLOCKLEN] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+uint8_t ctr_iv[BLOCKLEN] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+uint8_t ctr_ctxt[4*BLOCKLEN] = {
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee
+};
+
+/*
+ * OFB, CFB128 검증용 벡터값 (NIST SP 800-38A F.4.1, F.3.13), 키와 평문은 CTR과 같다.
+ */
+uint8_t ofb_iv[BLOCKLEN] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+uint8_t ofb_ctxt[4*BLOCKLEN] = {
+    0x3b, 0x3f, 0xd9, 0x2e, 0xb7, 0x2d, 0xad, 0x20, 0x33, 0x34, 0x49, 0xf8, 0xe8, 0x3c, 0xfb, 0x4a,
+    0x77, 0x89, 0x50, 0x8d, 0x16, 0x91, 0x8f, 0x03, 0xf5, 0x3c, 0x52, 0xda, 0xc5, 0x4e, 0xd8, 0x25,
+    0x97, 0x40, 0x05, 0x1e, 0x9c, 0x5f, 0xec, 0xf6, 0x43, 0x44, 0xf7, 0xa8, 0x22, 0x60, 0xed, 0xcc,
+    0x30, 0x4c, 0x65, 0x28, 0xf6, 0x59, 0xc7, 0x78, 0x66, 0xa5, 0x10, 0xd9, 0xc1, 0xd6, 0xae, 0x5e
+};
+uint8_t cfb_ctxt[4*BLOCKLEN] = {
+    0x3b, 0x3f, 0xd9, 0x2e, 0xb7, 0x2d, 0xad, 0x20, 0x33, 0x34, 0x49, 0xf8, 0xe8, 0x3c, 0xfb, 0x4a,
+    0xc8, 0xa6, 0x45, 0x37, 0xa0, 0xb3, 0xa9, 0x3f, 0xcd, 0xe3, 0xcd, 0xad, 0x9f, 0x1c, 0xe5, 0x8b,
+    0x26, 0x75, 0x1f, 0x67, 0xa3, 0xcb, 0xb1, 0x40, 0xb1, 0x80, 0x8c, 0xf1, 0x87, 0xa4, 0xf4, 0xdf,
+    0xc0, 0x4b, 0x05, 0x35, 0x7c, 0x5d, 0x1c, 0x0e, 0xea, 0xc4, 0xc6, 0x6f, 0x9f, 0xf7, 0xf2, 0xe6
+};
+
+/*
+ * XTS 검증용 벡터값 (IEEE 1619-2007 Vector 1, 두 키와 평문 32바이트가 모두 0, 데이터 단위 0)
+ */
+uint8_t xts_ctxt[32] = {
+    0x91, 0x7c, 0xf6, 0x9e, 0xbd, 0x68, 0xb2, 0xec, 0x9b, 0x9f, 0xe9, 0xa3, 0xea, 0xdd, 0xa6, 0x92,
+    0xcd, 0x43, 0xd2, 0xf5, 0x95, 0x98, 0xed, 0x85, 0x8c, 0x02, 0xc2, 0x65, 0x2f, 0xbf, 0x92, 0x2e
+};
+
+/*
+ * XTS 검증용 벡터값 (IEEE 1619-2007 Vector 2, 데이터 키 11..11, 트윅 키 22..22, 평문 44..44, 데이터 단위 0x3333333333)
+ */
+uint8_t xts_ctxt2[32] = {
+    0xc4, 0x54, 0x18, 0x5e, 0x6a, 0x16, 0x93, 0x6e, 0x39, 0x33, 0x40, 0x38, 0xac, 0xef, 0x83, 0x8b,
+    0xfb, 0x18, 0x6f, 0xff, 0x74, 0x80, 0xad, 0xc4, 0x28, 0x93, 0x82, 0xec, 0xd6, 0xd3, 0x94, 0xf0
+};
+
+/*
+ * XTS 검증용 벡터값 (IEEE 1619-2007 Vector 15, 암호문 훔치기, 데이터 키 ff fe .. f0, 트윅 키 bf be .. b0,
+ * 평문 00 01 .. 10, 데이터 단위 0x123456789a)
+ */
+uint8_t xts_ctxt15[17] = {
+    0x6c, 0x16, 0x25, 0xdb, 0x46, 0x71, 0x52, 0x2d, 0x3d, 0x75, 0x99, 0x60, 0x1d, 0xe7, 0xca, 0x09, 0xed
+};
+
+/*
+ * GCM 검증용 벡터값 (The Galois/Counter Mode of Operation, Test Case 4)
+ */
+uint8_t gkey[KEYLEN] = {0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08};
+uint8_t giv[GCM_IVLEN] = {0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88};
+uint8_t gaad[20] = {0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xab, 0xad, 0xda, 0xd2};
+uint8_t gptxt[60] = {
+    0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+    0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+    0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+    0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39
+};
+uint8_t gctxt[60] = {
+    0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24, 0x4b, 0x72, 0x21, 0xb7, 0x84, 0xd0, 0xd4, 0x9c,
+    0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0, 0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac, 0xa1, 0x2e,
+    0x21, 0xd5, 0x14, 0xb2, 0x54, 0x66, 0x93, 0x1c, 0x7d, 0x8f, 0x6a, 0x5a, 0xac, 0x84, 0xaa, 0x05,
+    0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97, 0x3d, 0x58, 0xe0, 0x91
+};
+uint8_t gtag[GCM_TAGLEN] = {0x5b, 0xc9, 0x4f, 0xbc, 0x32, 0x21, 0xa5, 0xdb, 0x94, 0xfa, 0xe9, 0x5a, 0xe7, 0x12, 0x1a, 0x47};
+
+
+/*
+ * OCB 검증용 벡터값 (RFC 7253 부록 A, AES-128, 128비트 태그)
+ * 키 = 00 01 .. 0f, nonce = bb aa 99 88 77 66 55 44 33 22 11 || n이다. AAD와 평문은 00 01 02 ..의
+ * 앞 alen, plen 바이트이므로 시험 중에 만들고, ct는 암호문 || 태그이다.
+ */
+uint8_t okey[KEYLEN] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+uint8_t ononce[OCB_NONCELEN] = {0xbb, 0xaa, 0x99, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x0f};
+struct {
+    uint8_t n;
+    int alen, plen;
+    uint8_t ct[40 + OCB_TAGLEN];
+} ocb_vec[] = {
+    {0x00, 0, 0,
+     {0x78, 0x54, 0x07, 0xbf, 0xff, 0xc8, 0xad, 0x9e, 0xdc, 0xc5, 0x52, 0x0a, 0xc9, 0x11, 0x1e, 0xe6}},
+    {0x01, 8, 8,
+     {0x68, 0x20, 0xb3, 0x65, 0x7b, 0x6f, 0x61, 0x5a, 0x57, 0x25, 0xbd, 0xa0, 0xd3, 0xb4, 0xeb, 0x3a,
+      0x25, 0x7c, 0x9a, 0xf1, 0xf8, 0xf0, 0x30, 0x09}},
+    {0x02, 8, 0,
+     {0x81, 0x01, 0x7f, 0x82, 0x03, 0xf0, 0x81, 0x27, 0x71, 0x52, 0xfa, 0xde, 0x69, 0x4a, 0x0a, 0x00}},
+    {0x03, 0, 8,
+     {0x45, 0xdd, 0x69, 0xf8, 0xf5, 0xaa, 0xe7, 0x24, 0x14, 0x05, 0x4c, 0xd1, 0xf3, 0x5d, 0x82, 0x76,
+      0x0b, 0x2c, 0xd0, 0x0d, 0x2f, 0x99, 0xbf, 0xa9}},
+    {0x04, 16, 16,
+     {0x57, 0x1d, 0x53, 0x5b, 0x60, 0xb2, 0x77, 0x18, 0x8b, 0xe5, 0x14, 0x71, 0x70, 0xa9, 0xa2, 0x2c,
+      0x3a, 0xd7, 0xa4, 0xff, 0x38, 0x35, 0xb8, 0xc5, 0x70, 0x1c, 0x1c, 0xce, 0xc8, 0xfc, 0x33, 0x58}},
+    {0x0f, 0, 40,
+     {0x44, 0x12, 0x92, 0x34, 0x93, 0xc5, 0x7d, 0x5d, 0xe0, 0xd7, 0x00, 0xf7, 0x53, 0xcc, 0xe0, 0xd1,
+      0xd2, 0xd9, 0x50, 0x60, 0x12, 0x2e, 0x9f, 0x15, 0xa5, 0xdd, 0xbf, 0xc5, 0x78, 0x7e, 0x50, 0xb5,
+      0xcc, 0x55, 0xee, 0x50, 0x7b, 0xcb, 0x08, 0x4e, 0x47, 0x9a, 0xd3, 0x63, 0xac, 0x36, 0x6b, 0x95,
+      0xa9, 0x8c, 0xa5, 0xf3, 0x00, 0x0b, 0x14, 0x79}}
+};
+
+
+/*
+ * AES-CBC + HMAC-SHA256 검증용 벡터값 (draft-mcgrew-aead-aes-cbc-hmac-sha2-05 5.1 AEAD_AES_128_CBC_HMAC_SHA256)
+ * MAC 키 = 00 01 .. 0f, 암호화 키 = 10 11 .. 1f
+ */
+const char *chm_ptxt = "A cipher system must not be required to be secret, and it must be able to fall into the hands of the enemy without inconvenience";
+const char *chm_aad = "The second principle of Auguste Kerckhoffs";
+uint8_t chm_iv[BLOCKLEN] = {0x1a, 0xf3, 0x8c, 0x2d, 0xc2, 0xb9, 0x6f, 0xfd, 0xd8, 0x66, 0x94, 0x09, 0x23, 0x41, 0xbc, 0x04};
+uint8_t chm_ctxt[144] = {
+    0xc8, 0x0e, 0xdf, 0xa3, 0x2d, 0xdf, 0x39, 0xd5, 0xef, 0x00, 0xc0, 0xb4, 0x68, 0x83, 0x42, 0x79,
+    0xa2, 0xe4, 0x6a, 0x1b, 0x80, 0x49, 0xf7, 0x92, 0xf7, 0x6b, 0xfe, 0x54, 0xb9, 0x03, 0xa9, 0xc9,
+    0xa9, 0x4a, 0xc9, 0xb4, 0x7a, 0xd2, 0x65, 0x5c, 0x5f, 0x10, 0xf9, 0xae, 0xf7, 0x14, 0x27, 0xe2,
+    0xfc, 0x6f, 0x9b, 0x3f, 0x39, 0x9a, 0x22, 0x14, 0x89, 0xf1, 0x63, 0x62, 0xc7, 0x03, 0x23, 0x36,
+    0x09, 0xd4, 0x5a, 0xc6, 0x98, 0x64, 0xe3, 0x32, 0x1c, 0xf8, 0x29, 0x35, 0xac, 0x40, 0x96, 0xc8,
+    0x6e, 0x13, 0x33, 0x14, 0xc5, 0x40, 0x19, 0xe8, 0xca, 0x79, 0x80, 0xdf, 0xa4, 0xb9, 0xcf, 0x1b,
+    0x38, 0x4c, 0x48, 0x6f, 0x3a, 0x54, 0xc5, 0x10, 0x78, 0x15, 0x8e, 0xe5, 0xd7, 0x9d, 0xe5, 0x9f,
+    0xbd, 0x34, 0xd8, 0x48, 0xb3, 0xd6, 0x95, 0x50, 0xa6, 0x76, 0x46, 0x34, 0x44, 0x27, 0xad, 0xe5,
+    0x4b, 0x88, 0x51, 0xff, 0xb5, 0x98, 0xf7, 0xf8, 0x00, 0x74, 0xb9, 0x47, 0x3c, 0x82, 0xe2, 0xdb
+};
+uint8_t chm_tag[CBCHMAC_TAGLEN] = {0x65, 0x2c, 0x3f, 0xa3, 0x6b, 0x0a, 0x7c, 0x5b, 0x32, 0x19, 0xfa, 0xb3, 0xa3, 0x0b, 0xc1, 0xc4};
+
+
+/*
+ * 시험용 파일 입출력: len 바이트를 path에 쓰거나, path를 최대 size 바이트까지 읽어 길이를 넘겨준다.
+ * 실패하면 각각 -1을 넘겨준다.
+ */
+static int write_file(const char *path, const uint8_t *buf, size_t len)
+{
+    FILE *fp = fopen(path, "wb");
+
+    if (fp == NULL)
+        return -1;
+    if (fwrite(buf, 1, len, fp) != len) {
+        fclose(fp);
+        return -1;
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+static long read_file(const char *path, uint8_t *buf, size_t size)
+{
+    FILE *fp = fopen(path, "rb");
+    size_t n;
+
+    if (fp == NULL)
+        return -1;
+    n = fread(buf, 1, size, fp);
+    fclose(fp);
+    return n;
+}
 
 int main(void)
 {
@@ -210,5 +393,544 @@ int main(void)
 
     }
 
+    /*
+     * GF(2^8) 영역 곱셈 시험: 0을 포함한 모든 두 수에 대해 gf8_mul이 시프트와 XOR로 계산한 곱과 같아야 하고,
+     * SIMD 본체와 나머지 처리가 모두 쓰이도록 여러 길이에 대해 gf8_mul_region의 결과가 바이트 단위 gf8_mul로
+     * 계산한 결과와 같아야 한다.
+     */
+    {
+        uint8_t src[100], dst[100], ref[100];
+        int c, i, n;
+
+        printf("---\n<GF(2^8) 영역 곱셈>");
+        for (c = 0; c < 256; ++c)
+            for (i = 0; i < 256; ++i) {
+                uint8_t a = c, b = i, p = 0;
+                for (n = 0; n < 8; ++n) {
+                    if (b & 1)
+                        p ^= a;
+                    a = (a << 1) ^ (a & 0x80 ? 0x1b : 0);
+                    b >>= 1;
+                }
+                if (gf8_mul(c, i) != p) {
+                    printf(".....FAILED: %02x * %02x\n", c, i);
+                    return 1;
+                }
+            }
+        for (c = 0; c < 256; c += 17) {
+            for (n = 0; n <= (int)sizeof(src); n += 11) {
+                arc4random_buf(src, sizeof(src));
+                arc4random_buf(dst, sizeof(dst));
+                src[n / 2] = 0;
+                for (i = 0; i < (int)sizeof(ref); ++i)
+                    ref[i] = dst[i] ^ (i < n ? gf8_mul(c, src[i]) : 0);
+                gf8_mul_region(dst, src, c, n);
+                if (memcmp(dst, ref, sizeof(ref))) {
+                    printf(".....FAILED: c = %02x, 길이 %d\n", c, n);
+                    return 1;
+                }
+            }
+        }
+        printf(".....PASSED\n");
+    }
+
+    /*
+     * CTR 모드 시험: 한 번에 처리한 결과와, 카운터를 옮겨 가며 블록 단위로 나누어 처리한 결과가
+     * 모두 검증용 암호문과 같아야 한다.
+     */
+    {
+        uint32_t roundKey[RNDKEYLEN];
+        uint8_t ctr[BLOCKLEN], buf[4*BLOCKLEN];
+        int i;
+
+        printf("<CTR 모드>");
+        KeyExpansion(mkey, roundKey, AES128);
+        memcpy(ctr, ctr_iv, BLOCKLEN);
+        aes_ctr_crypt(roundKey, AES128, ctr, mptxt, buf, sizeof(buf));
+        if (memcmp(buf, ctr_ctxt, sizeof(buf))) {
+            printf(".....FAILED: 암호문 불일치\n");
+            return 1;
+        }
+        for (i = 3; i >= 0; --i) {
+            memcpy(ctr, ctr_iv, BLOCKLEN);
+            aes_ctr_add(ctr, i);
+            aes_ctr_crypt(roundKey, AES128, ctr, ctr_ctxt + i*BLOCKLEN, buf + i*BLOCKLEN, BLOCKLEN);
+        }
+        if (memcmp(buf, mptxt, sizeof(buf))) {
+            printf(".....FAILED: 복호문 불일치\n");
+            return 1;
+        }
+        printf(".....PASSED\n");
+    }
+
+    /*
+     * OFB, CFB 모드 시험: 검증용 암호문과 같아야 하고, 백그라운드 생성기의 키 스트림을 블록 중간에서
+     * 끊어 가며 사용한 결과도 OFB 암호문과 같아야 한다.
+     */
+    {
+        uint32_t roundKey[RNDKEYLEN];
+        uint8_t iv[BLOCKLEN], buf[4*BLOCKLEN];
+        ofbstream_t ofb;
+        int i;
+
+        printf("<OFB, CFB 모드>");
+        KeyExpansion(mkey, roundKey, AES128);
+        memcpy(iv, ofb_iv, BLOCKLEN);
+        aes_ofb_crypt(roundKey, AES128, iv, mptxt, buf, sizeof(buf));
+        if (memcmp(buf, ofb_ctxt, sizeof(buf))) {
+            printf(".....FAILED: OFB 암호문 불일치\n");
+            return 1;
+        }
+        memcpy(iv, ofb_iv, BLOCKLEN);
+        aes_cfb_encrypt(roundKey, AES128, iv, mptxt, buf, sizeof(buf));
+        if (memcmp(buf, cfb_ctxt, sizeof(buf))) {
+            printf(".....FAILED: CFB 암호문 불일치\n");
+            return 1;
+        }
+        memcpy(iv, ofb_iv, BLOCKLEN);
+        aes_cfb_decrypt(roundKey, AES128, iv, buf, buf, sizeof(buf));
+        if (memcmp(buf, mptxt, sizeof(buf))) {
+            printf(".....FAILED: CFB 복호문 불일치\n");
+            return 1;
+        }
+        if (ofbstream_start(&ofb, mkey, AES128, ofb_iv, 2*BLOCKLEN)) {
+            printf(".....FAILED: 생성 스레드 시작 실패\n");
+            return 1;
+        }
+        for (i = 0; i < (int)sizeof(buf); i += 7)
+            ofbstream_xor(&ofb, mptxt + i, buf + i, sizeof(buf) - i < 7 ? sizeof(buf) - i : 7);
+        ofbstream_stop(&ofb);
+        if (memcmp(buf, ofb_ctxt, sizeof(buf))) {
+            printf(".....FAILED: 키 스트림 생성기 불일치\n");
+            return 1;
+        }
+        printf(".....PASSED\n");
+    }
+
+    /*
+     * XTS 모드 시험: 검증용 벡터와 일치해야 하고, BLOCKLEN의 배수가 아닌 길이(암호문 훔치기)도
+     * 복호화하면 원래 평문이 되어야 한다.
+     */
+    {
+        uint32_t roundKey1[RNDKEYLEN], roundKey2[RNDKEYLEN];
+        uint8_t zero[2*KEYLEN] = {0}, key[2*KEYLEN], msg[57], buf[57];
+        int i;
+
+        printf("<XTS 모드>");
+        KeyExpansion(zero, roundKey1, AES128);
+        KeyExpansion(zero + KEYLEN, roundKey2, AES128);
+        aes_xts_crypt(roundKey1, roundKey2, AES128, ENCRYPT, 0, zero, buf, sizeof(xts_ctxt));
+        if (memcmp(buf, xts_ctxt, sizeof(xts_ctxt))) {
+            printf(".....FAILED: 암호문 불일치\n");
+            return 1;
+        }
+        memset(key, 0x11, KEYLEN);
+        memset(key + KEYLEN, 0x22, KEYLEN);
+        memset(msg, 0x44, sizeof(xts_ctxt2));
+        KeyExpansion(key, roundKey1, AES128);
+        KeyExpansion(key + KEYLEN, roundKey2, AES128);
+        aes_xts_crypt(roundKey1, roundKey2, AES128, ENCRYPT, 0x3333333333, msg, buf, sizeof(xts_ctxt2));
+        if (memcmp(buf, xts_ctxt2, sizeof(xts_ctxt2))) {
+            printf(".....FAILED: Vector 2 암호문 불일치\n");
+            return 1;
+        }
+        for (i = 0; i < KEYLEN; ++i) {
+            key[i] = 0xff - i;
+            key[KEYLEN + i] = 0xbf - i;
+        }
+        for (i = 0; i < (int)sizeof(xts_ctxt15); ++i)
+            msg[i] = i;
+        KeyExpansion(key, roundKey1, AES128);
+        KeyExpansion(key + KEYLEN, roundKey2, AES128);
+        aes_xts_crypt(roundKey1, roundKey2, AES128, ENCRYPT, 0x123456789a, msg, buf, sizeof(xts_ctxt15));
+        if (memcmp(buf, xts_ctxt15, sizeof(xts_ctxt15))) {
+            printf(".....FAILED: Vector 15 암호문 불일치\n");
+            return 1;
+        }
+        arc4random_buf(msg, sizeof(msg));
+        aes_xts_crypt(roundKey1, roundKey2, AES128, ENCRYPT, 7, msg, buf, sizeof(msg));
+        aes_xts_crypt(roundKey1, roundKey2, AES128, DECRYPT, 7, buf, buf, sizeof(buf));
+        if (memcmp(buf, msg, sizeof(msg))) {
+            printf(".....FAILED: 복호문 불일치\n");
+            return 1;
+        }
+        if (aes_xts_crypt(roundKey1, roundKey2, AES128, ENCRYPT, 0, msg, buf, BLOCKLEN - 1) != XTS_INVALID_LEN) {
+            printf(".....FAILED: 한 블록보다 짧은 데이터를 받아들임\n");
+            return 1;
+        }
+        printf(".....PASSED\n");
+    }
+
+    /*
+     * GCM 시험: 암호문과 태그가 검증용 값과 같아야 하고, 태그가 변조되면 복호화를 거부해야 한다.
+     */
+    {
+        gcm_ctx_t gcm;
+        uint8_t buf[sizeof(gptxt)], tag[GCM_TAGLEN];
+
+        printf("<GCM 모드>");
+        aes_gcm_init(&gcm, gkey, AES128);
+        aes_gcm_seal(&gcm, giv, gaad, sizeof(gaad), gptxt, sizeof(gptxt), buf, tag);
+        if (memcmp(buf, gctxt, sizeof(buf)) || memcmp(tag, gtag, GCM_TAGLEN)) {
+            printf(".....FAILED: 암호문 불일치\n");
+            return 1;
+        }
+        if (aes_gcm_open(&gcm, giv, gaad, sizeof(gaad), gctxt, sizeof(gctxt), buf, gtag)
+            || memcmp(buf, gptxt, sizeof(buf))) {
+            printf(".....FAILED: 복호문 불일치\n");
+            return 1;
+        }
+        tag[0] ^= 1;
+        if (aes_gcm_open(&gcm, giv, gaad, sizeof(gaad), gctxt, sizeof(gctxt), buf, tag) != GCM_AUTH_FAIL) {
+            printf(".....FAILED: 변조된 태그를 받아들임\n");
+            return 1;
+        }
+        printf(".....PASSED\n");
+    }
+
+    /*
+     * 세그먼트 단위 AES-GCM 파일 시험: 100바이트 세그먼트 11개로 나눈 파일을 스레드 4개로 복호화하면
+     * 원래 평문이 되어야 하고, 세그먼트 경계에서 잘리거나 암호문 또는 파일 키의 salt가 변조된 파일은 거부해야 한다.
+     */
+    {
+        aeadfile_t af;
+        uint8_t msg[1037], buf[1037];
+        FILE *fp;
+
+        printf("<세그먼트 GCM 파일>");
+        arc4random_buf(msg, sizeof(msg));
+        if ((fp = fopen("aead_test.in", "wb")) == NULL || fwrite(msg, 1, sizeof(msg), fp) != sizeof(msg)) {
+            printf(".....FAILED: 평문 파일 생성 실패\n");
+            return 1;
+        }
+        fclose(fp);
+        if (aeadfile_seal("aead_test.in", "aead_test.enc", gkey, AES128, 100)
+            || aeadfile_open(&af, "aead_test.enc", gkey, AES128)) {
+            printf(".....FAILED: 암호화 실패\n");
+            return 1;
+        }
+        if (af.nseg != 11 || af.pt_len != sizeof(msg) || aeadfile_decrypt_all(&af, buf, 4)
+            || memcmp(buf, msg, sizeof(msg))) {
+            printf(".....FAILED: 복호문 불일치\n");
+            return 1;
+        }
+        aeadfile_close(&af);
+        // 마지막 세그먼트를 잘라내면 남은 마지막 세그먼트의 nonce 플래그가 맞지 않아 검증에 실패해야 한다.
+        if (truncate("aead_test.enc", AEADFILE_HDRLEN + 10 * (100 + GCM_TAGLEN))
+            || aeadfile_open(&af, "aead_test.enc", gkey, AES128)) {
+            printf(".....FAILED: 잘린 파일 열기 실패\n");
+            return 1;
+        }
+        if (aeadfile_decrypt_all(&af, buf, 4) != AEADFILE_AUTH_FAIL) {
+            printf(".....FAILED: 잘린 파일을 받아들임\n");
+            return 1;
+        }
+        aeadfile_close(&af);
+        // 세그먼트 4의 암호문 한 비트를 바꾼다.
+        if (aeadfile_seal("aead_test.in", "aead_test.enc", gkey, AES128, 100)
+            || (fp = fopen("aead_test.enc", "r+b")) == NULL) {
+            printf(".....FAILED: 암호화 실패\n");
+            return 1;
+        }
+        fseek(fp, AEADFILE_HDRLEN + 4 * (100 + GCM_TAGLEN) + 7, SEEK_SET);
+        fread(buf, 1, 1, fp);
+        buf[0] ^= 1;
+        fseek(fp, -1, SEEK_CUR);
+        fwrite(buf, 1, 1, fp);
+        fclose(fp);
+        if (aeadfile_open(&af, "aead_test.enc", gkey, AES128)
+            || aeadfile_decrypt_all(&af, buf, 4) != AEADFILE_AUTH_FAIL) {
+            printf(".....FAILED: 변조된 파일을 받아들임\n");
+            return 1;
+        }
+        aeadfile_close(&af);
+        // 파일 키를 유도하는 salt가 암호화할 때마다 달라야 하고, salt를 바꾸면 다른 파일 키가 되어 검증에 실패해야 한다.
+        if (aeadfile_seal("aead_test.in", "aead_test.enc", gkey, AES128, 100)
+            || aeadfile_seal("aead_test.in", "aead_test.out", gkey, AES128, 100)
+            || read_file("aead_test.enc", buf, AEADFILE_HDRLEN) != AEADFILE_HDRLEN
+            || read_file("aead_test.out", buf + AEADFILE_HDRLEN, AEADFILE_HDRLEN) != AEADFILE_HDRLEN
+            || !memcmp(buf + 16, buf + AEADFILE_HDRLEN + 16, AEADFILE_SALTLEN)) {
+            printf(".....FAILED: salt가 같음\n");
+            return 1;
+        }
+        if ((fp = fopen("aead_test.enc", "r+b")) == NULL) {
+            printf(".....FAILED: 암호화 실패\n");
+            return 1;
+        }
+        buf[16] ^= 1;
+        fwrite(buf, 1, AEADFILE_HDRLEN, fp);
+        fclose(fp);
+        if (aeadfile_open(&af, "aead_test.enc", gkey, AES128)
+            || aeadfile_decrypt_all(&af, buf, 4) != AEADFILE_AUTH_FAIL) {
+            printf(".....FAILED: salt가 변조된 파일을 받아들임\n");
+            return 1;
+        }
+        aeadfile_close(&af);
+        unlink("aead_test.in");
+        unlink("aead_test.enc");
+        unlink("aead_test.out");
+        printf(".....PASSED\n");
+    }
+
+    /*
+     * 파일 암호화 시험: 빈 파일, 블록보다 짧은 파일, 한 블록 파일, 64바이트 청크 여러 개에 걸친 파일을
+     * 암호화하면 헤더의 카운터 블록으로 aes_ctr_crypt()한 결과가 원래 파일이어야 하고, 복호화해도 원래 파일이
+     * 되어야 한다. CTR 형식에는 인증 태그가 없으므로 다른 키로 복호화하면 다른 평문이 나와야 하고,
+     * 카운터 블록보다 짧은 파일은 거부해야 한다.
+     */
+    {
+        static const size_t fsize[] = {0, 5, BLOCKLEN, 5 * 64 + 7};
+        filecrypt_opt_t fo;
+        uint32_t roundKey[RNDKEYLEN];
+        uint8_t msg[5 * 64 + 7], buf[BLOCKLEN + 5 * 64 + 8], ctr[BLOCKLEN];
+        long n;
+        int i;
+
+        printf("<CTR 파일 암호화>");
+        filecrypt_default(&fo);
+        fo.chunk_size = 64;
+        KeyExpansion(gkey, roundKey, AES128);
+        for (i = 0; i < (int)(sizeof(fsize) / sizeof(fsize[0])); ++i) {
+            arc4random_buf(msg, fsize[i]);
+            if (write_file("fc_test.in", msg, fsize[i])
+                || filecrypt("fc_test.in", "fc_test.enc", gkey, AES128, ENCRYPT, &fo, NULL)) {
+                printf(".....FAILED: %zu바이트 파일 암호화 실패\n", fsize[i]);
+                return 1;
+            }
+            n = read_file("fc_test.enc", buf, sizeof(buf));
+            memcpy(ctr, buf, BLOCKLEN);
+            aes_ctr_crypt(roundKey, AES128, ctr, buf + BLOCKLEN, buf + BLOCKLEN, fsize[i]);
+            if (n != (long)(BLOCKLEN + fsize[i]) || memcmp(buf + BLOCKLEN, msg, fsize[i])) {
+                printf(".....FAILED: %zu바이트 파일 암호문 불일치\n", fsize[i]);
+                return 1;
+            }
+            if (filecrypt("fc_test.enc", "fc_test.out", gkey, AES128, DECRYPT, &fo, NULL)
+                || read_file("fc_test.out", buf, sizeof(buf)) != (long)fsize[i] || memcmp(buf, msg, fsize[i])) {
+                printf(".....FAILED: %zu바이트 파일 복호문 불일치\n", fsize[i]);
+                return 1;
+            }
+        }
+        if (filecrypt("fc_test.enc", "fc_test.out", mkey, AES128, DECRYPT, &fo, NULL)
+            || read_file("fc_test.out", buf, sizeof(buf)) != (long)sizeof(msg) || !memcmp(buf, msg, sizeof(msg))) {
+            printf(".....FAILED: 다른 키로 원래 파일을 복호화함\n");
+            return 1;
+        }
+        if (truncate("fc_test.enc", BLOCKLEN - 1)
+            || filecrypt("fc_test.enc", "fc_test.out", gkey, AES128, DECRYPT, &fo, NULL) != FILECRYPT_BAD_FORMAT) {
+            printf(".....FAILED: 잘린 파일을 받아들임\n");
+            return 1;
+        }
+        unlink("fc_test.in");
+        unlink("fc_test.enc");
+        unlink("fc_test.out");
+        printf(".....PASSED\n");
+    }
+
+    /*
+     * 암호 파일 임의 위치 읽기 시험: 마지막 데이터 단위가 BLOCKLEN보다 짧아 앞 단위에 합쳐지는 길이의 파일을
+     * CTR과 XTS 형식으로 암호화하고, 파일 전체를 복호화한 결과가 원래 파일인지 확인한다. 그 다음 캐시를 켠 경우와
+     * 끈 경우 모두 페이지 경계와 합쳐진 마지막 단위에 걸친 읽기, 임의 위치와 길이의 읽기가 원래 파일과 같아야 한다.
+     */
+    {
+        static const struct { uint64_t off; size_t len; } span[] = {
+            {0, 3 * ENCREADER_PAGE + 7}, {ENCREADER_PAGE - 5, 10}, {ENCREADER_PAGE - 1, ENCREADER_PAGE + 2},
+            {2 * ENCREADER_PAGE - 3, ENCREADER_PAGE + 10}, {3 * ENCREADER_PAGE - 1, 8}, {3 * ENCREADER_PAGE + 7, 0}
+        };
+        static uint8_t msg[3 * ENCREADER_PAGE + 7], buf[BLOCKLEN + sizeof(msg)], out[sizeof(msg)];
+        uint32_t roundKey1[RNDKEYLEN], roundKey2[RNDKEYLEN];
+        uint8_t key[2*KEYLEN], ctr[BLOCKLEN];
+        encreader_opt_t opt[2];
+        encreader_t r;
+        uint64_t u, off;
+        size_t len;
+        int fmt, k, i;
+
+        printf("<암호 파일 임의 위치 읽기>");
+        arc4random_buf(msg, sizeof(msg));
+        arc4random_buf(key, sizeof(key));
+        encreader_default(&opt[0]);
+        opt[1].cache_pages = opt[1].readahead = 0;
+        if (write_file("er_test.in", msg, sizeof(msg))
+            || filecrypt("er_test.in", "er_test.ctr", key, AES128, ENCRYPT, NULL, NULL)
+            || encreader_xts_seal("er_test.in", "er_test.xts", key, AES128)) {
+            printf(".....FAILED: 파일 암호화 실패\n");
+            return 1;
+        }
+        KeyExpansion(key, roundKey1, AES128);
+        KeyExpansion(key + KEYLEN, roundKey2, AES128);
+        if (read_file("er_test.ctr", buf, sizeof(buf)) != (long)(BLOCKLEN + sizeof(msg))) {
+            printf(".....FAILED: CTR 파일 길이 불일치\n");
+            return 1;
+        }
+        memcpy(ctr, buf, BLOCKLEN);
+        aes_ctr_crypt(roundKey1, AES128, ctr, buf + BLOCKLEN, buf + BLOCKLEN, sizeof(msg));
+        if (memcmp(buf + BLOCKLEN, msg, sizeof(msg))) {
+            printf(".....FAILED: CTR 파일 복호문 불일치\n");
+            return 1;
+        }
+        if (read_file("er_test.xts", buf, sizeof(buf)) != (long)sizeof(msg)) {
+            printf(".....FAILED: XTS 파일 길이 불일치\n");
+            return 1;
+        }
+        for (u = 0; u < 2; ++u)
+            aes_xts_crypt(roundKey1, roundKey2, AES128, DECRYPT, u, buf + u * ENCREADER_PAGE,
+                          buf + u * ENCREADER_PAGE, ENCREADER_PAGE);
+        aes_xts_crypt(roundKey1, roundKey2, AES128, DECRYPT, 2, buf + 2 * ENCREADER_PAGE, buf + 2 * ENCREADER_PAGE,
+                      sizeof(msg) - 2 * ENCREADER_PAGE);
+        if (memcmp(buf, msg, sizeof(msg))) {
+            printf(".....FAILED: XTS 파일 복호문 불일치\n");
+            return 1;
+        }
+        for (fmt = ENCREADER_CTR; fmt <= ENCREADER_XTS; ++fmt)
+            for (k = 0; k < 2; ++k) {
+                if (encreader_open(&r, fmt == ENCREADER_CTR ? "er_test.ctr" : "er_test.xts", fmt, key, AES128, &opt[k])) {
+                    printf(".....FAILED: 파일 열기 실패\n");
+                    return 1;
+                }
+                for (i = 0; i < 1000; ++i) {
+                    if (i < (int)(sizeof(span) / sizeof(span[0]))) {
+                        off = span[i].off;
+                        len = span[i].len;
+                    } else {
+                        off = arc4random_uniform(sizeof(msg) + 1);
+                        len = arc4random_uniform(sizeof(msg) - off + 1);
+                    }
+                    if (encreader_pread(&r, out, len, off) || memcmp(out, msg + off, len)) {
+                        printf(".....FAILED: %s 형식 %llu:%zu 읽기 불일치\n", fmt == ENCREADER_CTR ? "CTR" : "XTS",
+                               (unsigned long long)off, len);
+                        return 1;
+                    }
+                }
+                if (encreader_pread(&r, out, 2, sizeof(msg) - 1) != ENCREADER_INVALID_ARG) {
+                    printf(".....FAILED: 파일 끝을 넘는 읽기를 받아들임\n");
+                    return 1;
+                }
+                encreader_close(&r);
+            }
+        unlink("er_test.in");
+        unlink("er_test.ctr");
+        unlink("er_test.xts");
+        printf(".....PASSED\n");
+    }
+
+    /*
+     * OCB 시험: RFC 7253 부록 A의 벡터와 일치해야 하고, 8블록 병렬 루프를 거치는 긴 메시지도
+     * 복호화하면 원래 평문이 되어야 하며, 태그가 변조되면 복호화를 거부해야 한다.
+     */
+    {
+        ocb_ctx_t ocb;
+        uint8_t msg[300], buf[300], tag[OCB_TAGLEN], nonce[OCB_NONCELEN];
+        int i, v;
+
+        printf("<OCB 모드>");
+        for (i = 0; i < 40; ++i)
+            msg[i] = i;
+        aes_ocb_init(&ocb, okey, AES128);
+        memcpy(nonce, ononce, OCB_NONCELEN);
+        for (v = 0; v < (int)(sizeof(ocb_vec) / sizeof(ocb_vec[0])); ++v) {
+            nonce[OCB_NONCELEN - 1] = ocb_vec[v].n;
+            aes_ocb_seal(&ocb, nonce, msg, ocb_vec[v].alen, msg, ocb_vec[v].plen, buf, tag);
+            if (memcmp(buf, ocb_vec[v].ct, ocb_vec[v].plen) || memcmp(tag, ocb_vec[v].ct + ocb_vec[v].plen, OCB_TAGLEN)) {
+                printf(".....FAILED: 암호문 불일치 (N = ..%02x)\n", ocb_vec[v].n);
+                return 1;
+            }
+            if (aes_ocb_open(&ocb, nonce, msg, ocb_vec[v].alen, ocb_vec[v].ct, ocb_vec[v].plen, buf,
+                             ocb_vec[v].ct + ocb_vec[v].plen) || memcmp(buf, msg, ocb_vec[v].plen)) {
+                printf(".....FAILED: 복호문 불일치 (N = ..%02x)\n", ocb_vec[v].n);
+                return 1;
+            }
+        }
+        arc4random_buf(msg, sizeof(msg));
+        aes_ocb_seal(&ocb, ononce, NULL, 0, msg, sizeof(msg), buf, tag);
+        if (aes_ocb_open(&ocb, ononce, NULL, 0, buf, sizeof(buf), buf, tag) || memcmp(buf, msg, sizeof(msg))) {
+            printf(".....FAILED: 복호문 불일치\n");
+            return 1;
+        }
+        tag[0] ^= 1;
+        if (aes_ocb_open(&ocb, ononce, NULL, 0, msg, sizeof(msg), buf, tag) != OCB_AUTH_FAIL) {
+            printf(".....FAILED: 변조된 태그를 받아들임\n");
+            return 1;
+        }
+        // 2^32 블록 이상은 L 테이블 범위를 벗어나므로 데이터를 읽기 전에 거부해야 한다.
+        if (aes_ocb_seal(&ocb, ononce, NULL, 0, msg, (size_t)BLOCKLEN << OCB_LMAX, buf, tag) != OCB_INVALID_LEN
+            || aes_ocb_open(&ocb, ononce, msg, (size_t)BLOCKLEN << OCB_LMAX, msg, 0, buf, tag) != OCB_INVALID_LEN) {
+            printf(".....FAILED: 너무 긴 길이를 받아들임\n");
+            return 1;
+        }
+        printf(".....PASSED\n");
+    }
+
+    /*
+     * AES-CBC + HMAC-SHA256 시험: 검증용 벡터와 일치해야 하고, 복호화하면 패딩을 제거한 원래 평문이 되어야 하며,
+     * 암호문이 변조되면 복호화를 거부해야 한다.
+     */
+    {
+        cbchmac_ctx_t chm;
+        uint8_t keys[2*KEYLEN], buf[sizeof(chm_ctxt)], tag[CBCHMAC_TAGLEN];
+        size_t plen = strlen(chm_ptxt), alen = strlen(chm_aad), n;
+        int i;
+
+        printf("<CBC-HMAC-SHA256>");
+        for (i = 0; i < 2*KEYLEN; ++i)
+            keys[i] = i;
+        aes_cbc_hmac_init(&chm, keys + KEYLEN, AES128, keys, KEYLEN);
+        aes_cbc_hmac_seal(&chm, chm_iv, (const uint8_t *)chm_aad, alen, (const uint8_t *)chm_ptxt, plen, buf, tag);
+        if (memcmp(buf, chm_ctxt, sizeof(chm_ctxt)) || memcmp(tag, chm_tag, CBCHMAC_TAGLEN)) {
+            printf(".....FAILED: 암호문 불일치\n");
+            return 1;
+        }
+        if (aes_cbc_hmac_open(&chm, chm_iv, (const uint8_t *)chm_aad, alen, buf, sizeof(buf), buf, &n, tag)
+            || n != plen || memcmp(buf, chm_ptxt, plen)) {
+            printf(".....FAILED: 복호문 불일치\n");
+            return 1;
+        }
+        memcpy(buf, chm_ctxt, sizeof(buf));
+        buf[sizeof(buf) - 1] ^= 1;
+        if (aes_cbc_hmac_open(&chm, chm_iv, (const uint8_t *)chm_aad, alen, buf, sizeof(buf), buf, &n, tag) != CBCHMAC_AUTH_FAIL) {
+            printf(".....FAILED: 변조된 암호문을 받아들임\n");
+            return 1;
+        }
+        /*
+         * 비트 길이가 2^32를 넘는 경우: 0x5a 2^29 + 100바이트의 SHA-256 값이 검증용 값과 같아야 하고,
+         * 이미 2^29 - 64바이트를 처리한 것처럼 만든 HMAC 상태로 봉인한 태그가 같은 상태에서
+         * sha256_update()로 계산한 HMAC과 같아야 한다.
+         */
+        {
+            static const uint8_t big_md[SHA256_DIGEST_SIZE] = {
+                0x46, 0x96, 0x21, 0x77, 0xcf, 0xc9, 0xe9, 0xf6, 0x34, 0x37, 0x28, 0x06, 0x61, 0x55, 0x1b, 0x14,
+                0xc5, 0x78, 0x69, 0xc3, 0xa6, 0x15, 0x7c, 0x32, 0x79, 0x40, 0x60, 0x3c, 0x2c, 0x0d, 0x4f, 0xe6};
+            static uint8_t chunk[1 << 16];
+            uint8_t md[SHA256_DIGEST_SIZE], al[8] = {0, 0, 0, 0, 0, 0, 0x01, 0x50};
+            sha256_ctx sc;
+
+            memset(chunk, 0x5a, sizeof(chunk));
+            sha256_init(&sc);
+            for (i = 0; i < 1 << 13; ++i)
+                sha256_update(&sc, chunk, sizeof(chunk));
+            sha256_update(&sc, chunk, 100);
+            sha256_final(&sc, md);
+            if (memcmp(md, big_md, sizeof(md))) {
+                printf(".....FAILED: 2^32비트를 넘는 SHA-256 값 불일치\n");
+                return 1;
+            }
+            chm.ipad.tot_len = (1 << 29) - SHA256_BLOCK_SIZE;
+            aes_cbc_hmac_seal(&chm, chm_iv, (const uint8_t *)chm_aad, alen, (const uint8_t *)chm_ptxt, plen, buf, tag);
+            sc = chm.ipad;
+            sha256_update(&sc, (const uint8_t *)chm_aad, alen);
+            sha256_update(&sc, chm_iv, BLOCKLEN);
+            sha256_update(&sc, buf, sizeof(buf));
+            sha256_update(&sc, al, sizeof(al));
+            sha256_final(&sc, md);
+            sc = chm.opad;
+            sha256_update(&sc, md, sizeof(md));
+            sha256_final(&sc, md);
+            if (memcmp(tag, md, CBCHMAC_TAGLEN)) {
+                printf(".....FAILED: 2^32비트를 넘는 HMAC 태그 불일치\n");
+                return 1;
+            }
+        }
+        printf(".....PASSED\n");
+    }
+
     return 0;
 }
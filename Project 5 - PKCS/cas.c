@@ -0,0 +1,512 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cas.h"
+#include "sha2_mb.h"
+
+#define PARALLEL_MIN (1 << 20)   /* 해시할 바이트 수가 이보다 적으면 스레드를 만들지 않는다 */
+#define INIT_SLOTS   (1 << 14)   /* 새 index의 칸 수(2의 거듭제곱) */
+
+// 조각 경계를 찾는 마스크이다. gear 해시는 왼쪽으로 밀며 더하므로 최근 64바이트가 모두 반영되는 위쪽 비트를 본다.
+// 평균 크기 전에는 더 어려운 마스크를, 후에는 더 쉬운 마스크를 사용하여 조각 크기를 평균 가까이 모은다.
+#define MASK_S (((1ULL << 15) - 1) << 49)
+#define MASK_L (((1ULL << 11) - 1) << 53)
+
+static const char magic[8] = {'C', 'A', 'S', 'I', 'D', 'X', '0', '1'};
+
+typedef struct {
+    char magic[8];
+    uint64_t nslots, count;
+    unsigned char pad[40];
+} index_header;
+
+typedef struct {
+    unsigned char digest[CAS_DIGEST_SIZE];
+    uint64_t off;               /* pack 안의 위치 */
+    uint32_t len;
+    uint32_t used;
+} index_slot;
+
+static uint64_t gear[256];
+
+// gear 표는 고정된 씨앗에서 splitmix64로 만든다. 조각 경계가 실행마다 같아야 하므로 무작위로 만들지 않는다.
+__attribute__((constructor))
+static void cas_gear_init(void)
+{
+    uint64_t x = 0x9e3779b97f4a7c15ULL, z;
+    int i;
+
+    for (i = 0; i < 256; i++) {
+        z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        gear[i] = z ^ (z >> 31);
+    }
+}
+
+/*
+ * cas_chunk() - data의 첫 조각 길이를 넘겨준다. 조각은 CAS_MIN_CHUNK 이상, CAS_MAX_CHUNK 이하이며
+ * 경계는 그 앞 64바이트의 내용으로만 정해지므로 앞부분에 삽입이나 삭제가 있어도 뒤쪽 경계는 그대로 남는다.
+ */
+size_t cas_chunk(const unsigned char *data, size_t len)
+{
+    size_t i = CAS_MIN_CHUNK, normal, max;
+    uint64_t h = 0;
+
+    if (len <= CAS_MIN_CHUNK)
+        return len;
+    normal = len < CAS_AVG_CHUNK ? len : CAS_AVG_CHUNK;
+    max = len < CAS_MAX_CHUNK ? len : CAS_MAX_CHUNK;
+    for (; i < normal; i++) {
+        h = (h << 1) + gear[data[i]];
+        if ((h & MASK_S) == 0)
+            return i + 1;
+    }
+    for (; i < max; i++) {
+        h = (h << 1) + gear[data[i]];
+        if ((h & MASK_L) == 0)
+            return i + 1;
+    }
+    return max;
+}
+
+static index_slot *slots(unsigned char *index)
+{
+    return (index_slot *)(index + sizeof(index_header));
+}
+
+// 주소는 SHA-256 값이므로 앞 8바이트를 그대로 칸 번호로 사용한다.
+static uint64_t home(const unsigned char *digest, uint64_t nslots)
+{
+    uint64_t h;
+
+    memcpy(&h, digest, sizeof(h));
+    return h & (nslots - 1);
+}
+
+// digest가 있는 칸이나, 없으면 들어갈 빈 칸을 넘겨준다. 칸의 절반 이상은 항상 비어 있다.
+static index_slot *probe(unsigned char *index, uint64_t nslots, const unsigned char *digest)
+{
+    index_slot *t = slots(index);
+    uint64_t i = home(digest, nslots);
+
+    while (t[i].used && memcmp(t[i].digest, digest, CAS_DIGEST_SIZE) != 0)
+        i = (i + 1) & (nslots - 1);
+    return &t[i];
+}
+
+static size_t index_size(uint64_t nslots)
+{
+    return sizeof(index_header) + nslots * sizeof(index_slot);
+}
+
+// fd를 칸이 nslots개인 index로 매핑한다. init이면 파일 크기를 맞추고 헤더를 쓴다.
+static unsigned char *map_index(int fd, uint64_t nslots, int init)
+{
+    size_t size = index_size(nslots);
+    unsigned char *p;
+
+    if (init && ftruncate(fd, size) != 0)
+        return NULL;
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+    if (init) {
+        memcpy(((index_header *)p)->magic, magic, sizeof(magic));
+        ((index_header *)p)->nslots = nslots;
+    }
+    return p;
+}
+
+/*
+ * 칸이 n개인 새 index를 index.tmp에 만들어 옮겨 담은 후 index로 이름을 바꾼다. pack 밖을 가리키는 칸
+ * (조각을 pack에 쓰기 전에 중단된 경우)은 옮기지 않는다.
+ */
+static int rebuild(cas_store *s, uint64_t n)
+{
+    uint64_t end = s->pack_size + s->wlen, count = 0, i;
+    unsigned char *p;
+    index_slot *t = slots(s->index);
+    int fd;
+
+    if ((fd = openat(s->dirfd, "index.tmp", O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+        return CAS_IO_FAIL;
+    if ((p = map_index(fd, n, 1)) == NULL) {
+        close(fd);
+        unlinkat(s->dirfd, "index.tmp", 0);
+        return CAS_IO_FAIL;
+    }
+    for (i = 0; i < s->nslots; i++) {
+        if (t[i].used && t[i].off + t[i].len <= end) {
+            *probe(p, n, t[i].digest) = t[i];
+            count++;
+        }
+    }
+    ((index_header *)p)->count = count;
+    if (renameat(s->dirfd, "index.tmp", s->dirfd, "index") != 0) {
+        munmap(p, index_size(n));
+        close(fd);
+        unlinkat(s->dirfd, "index.tmp", 0);
+        return CAS_IO_FAIL;
+    }
+    munmap(s->index, index_size(s->nslots));
+    close(s->index_fd);
+    s->index = p;
+    s->index_fd = fd;
+    s->nslots = n;
+    s->count = count;
+    return 0;
+}
+
+/*
+ * cas_open() - dir 디렉터리의 저장소를 연다. 디렉터리나 파일이 없으면 새로 만든다.
+ * 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int cas_open(cas_store *s, const char *dir)
+{
+    struct stat st;
+    index_header *h;
+    uint64_t i;
+    int err = CAS_OPEN_FAIL;
+
+    if (s == NULL || dir == NULL)
+        return CAS_INVALID_ARG;
+    memset(s, 0, sizeof(*s));
+    s->dirfd = s->pack_fd = s->index_fd = -1;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+        return CAS_OPEN_FAIL;
+    if ((s->dirfd = open(dir, O_RDONLY | O_DIRECTORY)) < 0)
+        goto fail;
+    if ((s->pack_fd = openat(s->dirfd, "pack", O_RDWR | O_CREAT, 0644)) < 0 || fstat(s->pack_fd, &st) != 0)
+        goto fail;
+    s->pack_size = st.st_size;
+    if ((s->index_fd = openat(s->dirfd, "index", O_RDWR | O_CREAT, 0644)) < 0 || fstat(s->index_fd, &st) != 0)
+        goto fail;
+    if (st.st_size == 0) {
+        if ((s->index = map_index(s->index_fd, INIT_SLOTS, 1)) == NULL)
+            goto fail;
+        s->nslots = INIT_SLOTS;
+    }
+    else {
+        // 헤더와 파일 크기가 맞지 않으면 깨진 index이다.
+        err = CAS_CORRUPT;
+        if ((size_t)st.st_size < sizeof(index_header)
+            || (h = (index_header *)map_index(s->index_fd, 0, 0)) == NULL)
+            goto fail;
+        if (memcmp(h->magic, magic, sizeof(magic)) != 0 || h->nslots == 0 || (h->nslots & (h->nslots - 1)) != 0
+            || (uint64_t)st.st_size != index_size(h->nslots)) {
+            munmap(h, sizeof(index_header));
+            goto fail;
+        }
+        s->nslots = h->nslots;
+        munmap(h, sizeof(index_header));
+        err = CAS_OPEN_FAIL;
+        if ((s->index = map_index(s->index_fd, s->nslots, 0)) == NULL)
+            goto fail;
+    }
+    s->count = ((index_header *)s->index)->count;
+    for (i = 0; i < s->nslots; i++) {
+        if (slots(s->index)[i].used && slots(s->index)[i].off + slots(s->index)[i].len > s->pack_size) {
+            if ((err = rebuild(s, s->nslots)) != 0)
+                goto fail;
+            break;
+        }
+    }
+    err = CAS_NO_MEMORY;
+    if ((s->wbuf = malloc(CAS_WBUF_SIZE)) == NULL)
+        goto fail;
+    return 0;
+
+fail:
+    cas_close(s);
+    return err;
+}
+
+// buf의 len 바이트를 pack의 off 위치에 모두 쓴다.
+static int write_all(int fd, const unsigned char *buf, size_t len, uint64_t off)
+{
+    ssize_t n;
+
+    while (len > 0) {
+        if ((n = pwrite(fd, buf, len, off)) < 0) {
+            if (errno == EINTR)
+                continue;
+            return CAS_IO_FAIL;
+        }
+        buf += n;
+        len -= n;
+        off += n;
+    }
+    return 0;
+}
+
+/*
+ * cas_flush() - 쓰기 버퍼에 모인 조각들을 pack에 쓴다. 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int cas_flush(cas_store *s)
+{
+    if (s->wlen == 0)
+        return 0;
+    if (write_all(s->pack_fd, s->wbuf, s->wlen, s->pack_size) != 0)
+        return CAS_IO_FAIL;
+    s->pack_size += s->wlen;
+    s->wlen = 0;
+    return 0;
+}
+
+// digest 주소로 data를 저장한다. 이미 있으면 아무것도 하지 않고 1을, 새로 저장하면 0을 넘겨준다.
+// 새 조각의 위치는 쓰기 버퍼를 pack 뒤에 이어 붙였을 때의 위치이다.
+static int put_blob(cas_store *s, const unsigned char *digest, const unsigned char *data, size_t len)
+{
+    index_slot *slot = probe(s->index, s->nslots, digest);
+    int err;
+
+    if (slot->used)
+        return 1;
+    if (len > UINT32_MAX)
+        return -CAS_INVALID_ARG;
+    if (len > CAS_WBUF_SIZE - s->wlen && (err = cas_flush(s)) != 0)
+        return -err;
+    memcpy(slot->digest, digest, CAS_DIGEST_SIZE);
+    slot->off = s->pack_size + s->wlen;
+    slot->len = len;
+    // 쓰기 버퍼보다 큰 레시피는 바로 쓴다.
+    if (len > CAS_WBUF_SIZE) {
+        if (write_all(s->pack_fd, data, len, s->pack_size) != 0)
+            return -CAS_IO_FAIL;
+        s->pack_size += len;
+    }
+    else {
+        memcpy(s->wbuf + s->wlen, data, len);
+        s->wlen += len;
+    }
+    slot->used = 1;
+    ((index_header *)s->index)->count = ++s->count;
+    // 채운 비율이 절반을 넘으면 index를 늘린다.
+    if (2 * s->count > s->nslots && (err = rebuild(s, 2 * s->nslots)) != 0)
+        return -err;
+    return 0;
+}
+
+/*
+ * 조각 first번부터 count개의 해시를 스레드 하나가 맡은 몫이다. 이어진 조각들을 맡기므로
+ * sha2_hash_many()가 한꺼번에 다중 버퍼 레인에 나누어 넣는다.
+ */
+typedef struct {
+    const unsigned char **msgs;
+    const size_t *lens;
+    unsigned char **digests;
+    size_t first, count;
+} work_t;
+
+static void *worker(void *arg)
+{
+    work_t *w = arg;
+
+    sha2_hash_many(SHA2_MB_SHA256, w->msgs + w->first, w->lens + w->first, w->count, w->digests + w->first);
+    return NULL;
+}
+
+static void hash_chunks(const unsigned char **msgs, const size_t *lens, unsigned char **digests, size_t n,
+                        size_t bytes, int nthreads)
+{
+    int k;
+
+    if (nthreads < 1 || bytes < PARALLEL_MIN)
+        nthreads = 1;
+    if ((size_t)nthreads > n)
+        nthreads = n > 0 ? n : 1;
+
+    work_t w[nthreads];
+
+    for (k = 0; k < nthreads; k++)
+        w[k] = (work_t){ msgs, lens, digests, n * k / nthreads, n * (k + 1) / nthreads - n * k / nthreads };
+    sha2_parallel(worker, w, sizeof(work_t), nthreads);
+}
+
+/*
+ * cas_put() - data를 조각내어 저장하고 파일의 주소(레시피의 SHA-256 값)를 id에 넘겨준다.
+ * st가 NULL이 아니면 조각 수와 새로 저장한 양을 더한다. 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int cas_put(cas_store *s, const void *data, size_t len, int nthreads, unsigned char *id, cas_stats *st)
+{
+    const unsigned char *p = data;
+    const unsigned char **msgs;
+    unsigned char *recipe, **digests;
+    size_t *lens, max = len / CAS_MIN_CHUNK + 1, n = 0, off, i;
+    int r = 0;
+
+    if (s == NULL || id == NULL || (data == NULL && len > 0))
+        return CAS_INVALID_ARG;
+    msgs = malloc(max * sizeof(*msgs));
+    lens = malloc(max * sizeof(*lens));
+    digests = malloc(max * sizeof(*digests));
+    recipe = malloc(max * CAS_DIGEST_SIZE);
+    if (msgs == NULL || lens == NULL || digests == NULL || recipe == NULL) {
+        r = -CAS_NO_MEMORY;
+        goto done;
+    }
+    // 경계를 모두 찾은 후 조각들의 해시를 한꺼번에 계산한다. 해시 값을 차례로 이은 것이 레시피이다.
+    for (off = 0; off < len; off += lens[n++]) {
+        msgs[n] = p + off;
+        lens[n] = cas_chunk(p + off, len - off);
+        digests[n] = recipe + n * CAS_DIGEST_SIZE;
+    }
+    hash_chunks(msgs, lens, digests, n, len, nthreads);
+    for (i = 0; i < n && r >= 0; i++) {
+        if ((r = put_blob(s, digests[i], msgs[i], lens[i])) >= 0 && st != NULL) {
+            st->chunks++;
+            st->bytes += lens[i];
+            st->new_chunks += r == 0;
+            st->new_bytes += r == 0 ? lens[i] : 0;
+        }
+    }
+    if (r >= 0) {
+        sha256(recipe, n * CAS_DIGEST_SIZE, id);
+        r = put_blob(s, id, recipe, n * CAS_DIGEST_SIZE);
+    }
+
+done:
+    free(msgs);
+    free(lens);
+    free(digests);
+    free(recipe);
+    return r < 0 ? -r : 0;
+}
+
+// digest 주소의 조각을 찾는다. 없거나 pack 밖을 가리키면(쓰다가 중단된 경우) NULL을 넘겨준다.
+static const index_slot *lookup(const cas_store *s, const unsigned char *digest)
+{
+    const index_slot *slot = probe(s->index, s->nslots, digest);
+
+    if (!slot->used || slot->off + slot->len > s->pack_size)
+        return NULL;
+    return slot;
+}
+
+static int read_all(int fd, unsigned char *buf, size_t len, uint64_t off)
+{
+    ssize_t n;
+
+    while (len > 0) {
+        if ((n = pread(fd, buf, len, off)) <= 0) {
+            if (n < 0 && errno == EINTR)
+                continue;
+            return CAS_IO_FAIL;
+        }
+        buf += n;
+        len -= n;
+        off += n;
+    }
+    return 0;
+}
+
+/*
+ * cas_get() - id 주소의 파일을 읽어 malloc()으로 할당한 *data에 넘겨준다. 호출자가 free()한다.
+ * 레시피와 조각마다 SHA-256 값을 다시 계산하여 주소와 다르면 CAS_CORRUPT를 넘겨준다.
+ */
+int cas_get(cas_store *s, const unsigned char *id, unsigned char **data, size_t *len)
+{
+    const index_slot *slot, *c;
+    const unsigned char **msgs = NULL;
+    unsigned char *recipe = NULL, *buf = NULL, **digests = NULL, (*check)[CAS_DIGEST_SIZE] = NULL;
+    size_t *lens = NULL, n, total = 0, i;
+    int err;
+
+    if (s == NULL || id == NULL || data == NULL || len == NULL)
+        return CAS_INVALID_ARG;
+    if ((err = cas_flush(s)) != 0)
+        return err;
+    if ((slot = lookup(s, id)) == NULL)
+        return CAS_NOT_FOUND;
+    if (slot->len % CAS_DIGEST_SIZE != 0)
+        return CAS_CORRUPT;
+    n = slot->len / CAS_DIGEST_SIZE;
+    err = CAS_NO_MEMORY;
+    recipe = malloc(slot->len + 1);
+    msgs = malloc((n + 1) * sizeof(*msgs));
+    lens = malloc((n + 1) * sizeof(*lens));
+    digests = malloc((n + 1) * sizeof(*digests));
+    check = malloc((n + 1) * CAS_DIGEST_SIZE);
+    if (recipe == NULL || msgs == NULL || lens == NULL || digests == NULL || check == NULL)
+        goto done;
+    if ((err = read_all(s->pack_fd, recipe, slot->len, slot->off)) != 0)
+        goto done;
+    // 레시피도 자신의 SHA-256 값이 주소이므로 id와 다르면 손상된 것이다.
+    sha256(recipe, slot->len, check[0]);
+    if (memcmp(check[0], id, CAS_DIGEST_SIZE) != 0) {
+        err = CAS_CORRUPT;
+        goto done;
+    }
+    for (i = 0; i < n; i++) {
+        if ((c = lookup(s, recipe + i * CAS_DIGEST_SIZE)) == NULL) {
+            err = CAS_NOT_FOUND;
+            goto done;
+        }
+        total += c->len;
+    }
+    err = CAS_NO_MEMORY;
+    if ((buf = malloc(total + 1)) == NULL)
+        goto done;
+    for (i = 0, total = 0; i < n; i++) {
+        c = lookup(s, recipe + i * CAS_DIGEST_SIZE);
+        if ((err = read_all(s->pack_fd, buf + total, c->len, c->off)) != 0)
+            goto done;
+        msgs[i] = buf + total;
+        lens[i] = c->len;
+        digests[i] = check[i];
+        total += c->len;
+    }
+    sha2_hash_many(SHA2_MB_SHA256, msgs, lens, n, digests);
+    err = CAS_CORRUPT;
+    for (i = 0; i < n; i++)
+        if (memcmp(check[i], recipe + i * CAS_DIGEST_SIZE, CAS_DIGEST_SIZE) != 0)
+            goto done;
+    *data = buf;
+    *len = total;
+    buf = NULL;
+    err = 0;
+
+done:
+    free(recipe);
+    free(msgs);
+    free(lens);
+    free(digests);
+    free(check);
+    free(buf);
+    return err;
+}
+
+/*
+ * cas_close() - 남은 조각을 pack에 쓰고 저장소를 닫는다.
+ */
+void cas_close(cas_store *s)
+{
+    if (s == NULL)
+        return;
+    if (s->pack_fd >= 0 && s->wbuf != NULL)
+        cas_flush(s);
+    if (s->index != NULL)
+        munmap(s->index, index_size(s->nslots));
+    if (s->index_fd >= 0)
+        close(s->index_fd);
+    if (s->pack_fd >= 0)
+        close(s->pack_fd);
+    if (s->dirfd >= 0)
+        close(s->dirfd);
+    free(s->wbuf);
+    memset(s, 0, sizeof(*s));
+    s->dirfd = s->pack_fd = s->index_fd = -1;
+}
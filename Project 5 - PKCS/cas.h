@@ -0,0 +1,67 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _CAS_H_
+#define _CAS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sha2.h"
+
+/*
+ * SHA-256 내용 주소 저장소
+ *
+ * 데이터를 내용 기반 분할(gear 해시, 평균 CAS_AVG_CHUNK 바이트)로 조각내고 조각마다 SHA-256 값을 주소로 삼아
+ * 한 번만 저장한다. 파일은 조각 주소들의 목록(레시피)으로 저장하며, 레시피도 하나의 조각처럼 자신의 SHA-256
+ * 값을 주소로 저장되므로 파일의 주소는 레시피의 해시 값이다. 조각들의 해시는 sha2_hash_many()로 한꺼번에,
+ * 입력이 크면 nthreads개의 스레드로 나누어 계산한다.
+ *
+ * 디렉터리 하나에 두 파일을 둔다. pack은 조각 데이터를 차례로 덧붙이는 파일이고, index는 mmap으로 매핑한
+ * 열린 주소 해시 테이블로 주소에서 pack 안의 위치와 길이를 O(1)에 찾는다. 새 조각은 쓰기 버퍼에 모았다가
+ * CAS_WBUF_SIZE 바이트가 차거나 cas_flush(), cas_close()를 호출할 때 한 번에 pack에 쓴다.
+ */
+#define CAS_DIGEST_SIZE SHA256_DIGEST_SIZE
+#define CAS_MIN_CHUNK   (2 << 10)
+#define CAS_AVG_CHUNK   (8 << 10)
+#define CAS_MAX_CHUNK   (64 << 10)
+#define CAS_WBUF_SIZE   (4 << 20)
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define CAS_INVALID_ARG 1
+#define CAS_OPEN_FAIL   2
+#define CAS_IO_FAIL     3
+#define CAS_NO_MEMORY   4
+#define CAS_NOT_FOUND   5
+#define CAS_CORRUPT     6
+
+typedef struct {
+    int dirfd, pack_fd, index_fd;
+    unsigned char *index;       /* mmap으로 매핑한 index 파일 */
+    uint64_t nslots, count;     /* 테이블 크기와 사용 중인 칸 수 */
+    uint64_t pack_size;         /* pack에 실제로 쓴 바이트 수 */
+    unsigned char *wbuf;        /* pack에 아직 쓰지 않은 새 조각들 */
+    size_t wlen;
+} cas_store;
+
+/*
+ * cas_put()이 넘겨주는 통계이다. 중복은 이미 저장되어 있던 조각이다.
+ */
+typedef struct {
+    uint64_t chunks, new_chunks;
+    uint64_t bytes, new_bytes;
+} cas_stats;
+
+int cas_open(cas_store *s, const char *dir);
+int cas_put(cas_store *s, const void *data, size_t len, int nthreads, unsigned char *id, cas_stats *st);
+int cas_get(cas_store *s, const unsigned char *id, unsigned char **data, size_t *len);
+int cas_flush(cas_store *s);
+void cas_close(cas_store *s);
+size_t cas_chunk(const unsigned char *data, size_t len);
+
+#endif
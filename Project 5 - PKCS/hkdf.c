@@ -0,0 +1,92 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include <string.h>
+#include "hkdf.h"
+
+/* hkdf_extract() - PRK = HMAC(salt, IKM)을 계산하여 prk에 해시 길이만큼 저장한다.
+   salt가 없으면 해시 길이만큼의 0을 사용하는데, HMAC 키는 블록 길이까지 0으로 채우므로 빈 키와 같다.
+*/
+int hkdf_extract(int sha2_ndx, const void *salt, size_t salt_len, const void *ikm, size_t ikm_len, void *prk)
+{
+    hmac_key key;
+
+    if (prk == NULL || (ikm == NULL && ikm_len > 0) || hmac_key_init(&key, sha2_ndx, salt, salt_len) != 0)
+        return HKDF_INVALID_ARG;
+    hmac_sha2(&key, ikm, ikm_len, prk);
+    hmac_key_clear(&key);
+    return 0;
+}
+
+int hkdf_prk_init(hmac_key *prk_key, int sha2_ndx, const void *prk, size_t prk_len)
+{
+    return hmac_key_init(prk_key, sha2_ndx, prk, prk_len) == 0 ? 0 : HKDF_INVALID_ARG;
+}
+
+/* hkdf_expand() - T(i) = HMAC(PRK, T(i-1) || info || i)를 이어 붙인 앞 len 바이트를 okm에 저장한다.
+   매 반복은 prk_key의 중간 상태에서 시작하므로 PRK의 패드 블록을 다시 압축하지 않는다.
+*/
+int hkdf_expand(const hmac_key *prk_key, const void *info, size_t info_len, void *okm, size_t len)
+{
+    unsigned char t[HMAC_MAX_SIZE], *out = okm;
+    unsigned char c;
+    size_t n, hlen;
+    hmac_ctx ctx;
+
+    if (prk_key == NULL || (info == NULL && info_len > 0) || (okm == NULL && len > 0))
+        return HKDF_INVALID_ARG;
+    hlen = prk_key->size;
+    if (len > 255 * hlen)
+        return HKDF_OKM_TOO_LONG;
+    for (c = 1; len > 0; c++) {
+        hmac_start(&ctx, prk_key);
+        if (c > 1)
+            hmac_update(&ctx, t, hlen);
+        hmac_update(&ctx, info, info_len);
+        hmac_update(&ctx, &c, 1);
+        hmac_final(&ctx, t);
+        n = len < hlen ? len : hlen;
+        memcpy(out, t, n);
+        out += n;
+        len -= n;
+    }
+    memset(t, 0, sizeof(t));
+    return 0;
+}
+
+/* hkdf_expand_batch() - 한 PRK에서 레이블 njobs개의 키를 차례대로 유도한다.
+   모든 레이블이 prk_key의 중간 상태를 함께 사용한다. 오류가 나면 처음 생긴 오류 코드를 넘겨주고 멈춘다.
+*/
+int hkdf_expand_batch(const hmac_key *prk_key, hkdf_job *job, int njobs)
+{
+    int i, result;
+
+    if (njobs < 0 || (job == NULL && njobs > 0))
+        return HKDF_INVALID_ARG;
+    for (i = 0; i < njobs; i++)
+        if ((result = hkdf_expand(prk_key, job[i].info, job[i].info_len, job[i].okm, job[i].len)) != 0)
+            return result;
+    return 0;
+}
+
+int hkdf(int sha2_ndx, const void *salt, size_t salt_len, const void *ikm, size_t ikm_len,
+         const void *info, size_t info_len, void *okm, size_t len)
+{
+    unsigned char prk[HMAC_MAX_SIZE];
+    hmac_key key;
+    int result;
+
+    // 추출 단계의 키(salt)로 PRK 길이도 알 수 있으므로 hkdf_extract()를 풀어서 쓴다.
+    if ((ikm == NULL && ikm_len > 0) || hmac_key_init(&key, sha2_ndx, salt, salt_len) != 0)
+        return HKDF_INVALID_ARG;
+    hmac_sha2(&key, ikm, ikm_len, prk);
+    hkdf_prk_init(&key, sha2_ndx, prk, key.size);
+    result = hkdf_expand(&key, info, info_len, okm, len);
+    hmac_key_clear(&key);
+    memset(prk, 0, sizeof(prk));
+    return result;
+}
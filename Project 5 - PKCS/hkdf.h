@@ -0,0 +1,45 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _HKDF_H_
+#define _HKDF_H_
+
+#include <stddef.h>
+#include "hmac.h"
+
+/*
+ * HKDF (RFC 5869)
+ *
+ * hkdf_extract()로 PRK를 만든 후 hkdf_prk_init()으로 PRK의 HMAC 중간 상태를 한 번만 계산해 두면,
+ * hkdf_expand()의 모든 반복과 hkdf_expand_batch()의 모든 레이블이 그 상태를 함께 사용한다.
+ * 해시 함수는 pkcs.h의 SHA224 ~ SHA512_256 중에서 고른다.
+ */
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define HKDF_INVALID_ARG  1
+#define HKDF_OKM_TOO_LONG 2
+
+/*
+ * hkdf_expand_batch()에 넘겨주는 레이블 하나이다. okm에 len 바이트의 키가 저장된다.
+ */
+typedef struct {
+    const void *info;
+    size_t info_len;
+    void *okm;
+    size_t len;
+} hkdf_job;
+
+int hkdf_extract(int sha2_ndx, const void *salt, size_t salt_len, const void *ikm, size_t ikm_len, void *prk);
+int hkdf_prk_init(hmac_key *prk_key, int sha2_ndx, const void *prk, size_t prk_len);
+int hkdf_expand(const hmac_key *prk_key, const void *info, size_t info_len, void *okm, size_t len);
+int hkdf_expand_batch(const hmac_key *prk_key, hkdf_job *job, int njobs);
+int hkdf(int sha2_ndx, const void *salt, size_t salt_len, const void *ikm, size_t ikm_len,
+         const void *info, size_t info_len, void *okm, size_t len);
+
+#endif
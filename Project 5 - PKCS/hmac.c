@@ -0,0 +1,116 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include <string.h>
+#include "hmac.h"
+#include "pkcs.h"
+
+// SHA-224/256은 32비트, 나머지는 64비트 워드 8개로 된 중간 상태를 사용한다.
+static int is256(int ndx)
+{
+    return ndx == SHA224 || ndx == SHA256;
+}
+
+// 블록 하나를 압축한 상태에서 다시 시작한다. 버퍼는 비어 있고 지금까지 처리한 길이는 블록 하나이다.
+static void ctx_load(hmac_ctx *ctx, int ndx, const void *h)
+{
+    if (is256(ndx)) {
+        memcpy(ctx->u.c256.h, h, sizeof(ctx->u.c256.h));
+        ctx->u.c256.tot_len = SHA256_BLOCK_SIZE;
+        ctx->u.c256.len = 0;
+    }
+    else {
+        memcpy(ctx->u.c512.h, h, sizeof(ctx->u.c512.h));
+        ctx->u.c512.tot_len = SHA512_BLOCK_SIZE;
+        ctx->u.c512.len = 0;
+    }
+}
+
+/* hmac_key_init() - 길이가 klen인 키 k로 sha2_ndx 해시 함수를 사용하는 HMAC 키를 만든다.
+   블록보다 긴 키는 해시 값을 키로 사용한다. 성공하면 0, 그렇지 않으면 HMAC_INVALID_ARG를 넘겨준다.
+*/
+int hmac_key_init(hmac_key *key, int sha2_ndx, const void *k, size_t klen)
+{
+    unsigned char kb[SHA512_BLOCK_SIZE] = {0}, pad[SHA512_BLOCK_SIZE];
+    const sha2_desc *hd;
+    hmac_ctx ctx;
+    int i, bsize;
+
+    if (key == NULL || (k == NULL && klen > 0) || sha2_ndx < SHA224 || sha2_ndx > SHA512_256)
+        return HMAC_INVALID_ARG;
+    hd = &sha2_descs[sha2_ndx];
+    key->ndx = sha2_ndx;
+    key->size = hd->digest_size;
+    bsize = hd->block_size;
+    if (klen > (size_t)bsize)
+        hd->hash(k, klen, kb);
+    else if (klen > 0)
+        memcpy(kb, k, klen);
+
+    // 두 패드 블록을 하나씩 압축하고 그 상태만 저장한다.
+    for (i = 0; i < bsize; i++)
+        pad[i] = kb[i] ^ 0x36;
+    hd->init(&ctx.u);
+    hd->update(&ctx.u, pad, bsize);
+    if (is256(sha2_ndx))
+        memcpy(key->ipad.h256, ctx.u.c256.h, sizeof(key->ipad.h256));
+    else
+        memcpy(key->ipad.h512, ctx.u.c512.h, sizeof(key->ipad.h512));
+    for (i = 0; i < bsize; i++)
+        pad[i] = kb[i] ^ 0x5c;
+    hd->init(&ctx.u);
+    hd->update(&ctx.u, pad, bsize);
+    if (is256(sha2_ndx))
+        memcpy(key->opad.h256, ctx.u.c256.h, sizeof(key->opad.h256));
+    else
+        memcpy(key->opad.h512, ctx.u.c512.h, sizeof(key->opad.h512));
+    memset(kb, 0, sizeof(kb));
+    memset(pad, 0, sizeof(pad));
+    memset(&ctx, 0, sizeof(ctx));
+    return 0;
+}
+
+void hmac_key_clear(hmac_key *key)
+{
+    memset(key, 0, sizeof(*key));
+}
+
+void hmac_start(hmac_ctx *ctx, const hmac_key *key)
+{
+    ctx->key = key;
+    ctx_load(ctx, key->ndx, is256(key->ndx) ? (const void *)key->ipad.h256 : (const void *)key->ipad.h512);
+}
+
+void hmac_update(hmac_ctx *ctx, const void *msg, size_t len)
+{
+    sha2_descs[ctx->key->ndx].update(&ctx->u, msg, len);
+}
+
+/* hmac_final() - 안쪽 해시를 끝내고 그 값을 바깥쪽 중간 상태에 이어서 해시하여 key->size 바이트의 MAC을 mac에 저장한다.
+*/
+void hmac_final(hmac_ctx *ctx, void *mac)
+{
+    const hmac_key *key = ctx->key;
+    const sha2_desc *hd = &sha2_descs[key->ndx];
+    unsigned char inner[HMAC_MAX_SIZE];
+
+    hd->final(&ctx->u, inner);
+    ctx_load(ctx, key->ndx, is256(key->ndx) ? (const void *)key->opad.h256 : (const void *)key->opad.h512);
+    hd->update(&ctx->u, inner, key->size);
+    hd->final(&ctx->u, mac);
+    memset(inner, 0, sizeof(inner));
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void hmac_sha2(const hmac_key *key, const void *msg, size_t len, void *mac)
+{
+    hmac_ctx ctx;
+
+    hmac_start(&ctx, key);
+    hmac_update(&ctx, msg, len);
+    hmac_final(&ctx, mac);
+}
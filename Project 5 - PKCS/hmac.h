@@ -0,0 +1,49 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _HMAC_H_
+#define _HMAC_H_
+
+#include <stddef.h>
+#include "sha2.h"
+
+/*
+ * HMAC-SHA2
+ *
+ * hmac_key_init()은 K ^ ipad 블록과 K ^ opad 블록을 한 번씩 압축한 중간 상태를 키에 저장해 둔다.
+ * 이후 MAC 하나를 계산할 때는 두 중간 상태에서 시작하므로 메시지 블록과 바깥쪽 블록 하나만 압축하면 된다.
+ * 해시 함수는 pkcs.h의 SHA224 ~ SHA512_256 중에서 고른다. 키 하나를 여러 스레드가 함께 사용해도 된다.
+ */
+#define HMAC_MAX_SIZE SHA512_DIGEST_SIZE
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define HMAC_INVALID_ARG 1
+
+typedef struct {
+    int ndx;                /* pkcs.h의 해시 함수 번호 */
+    int size;               /* MAC 길이(바이트) */
+    union {
+        uint32 h256[8];
+        uint64 h512[8];
+    } ipad, opad;           /* K ^ ipad, K ^ opad 블록을 압축한 후의 상태 */
+} hmac_key;
+
+typedef struct {
+    const hmac_key *key;
+    sha2_ctx u;
+} hmac_ctx;
+
+int hmac_key_init(hmac_key *key, int sha2_ndx, const void *k, size_t klen);
+void hmac_key_clear(hmac_key *key);
+void hmac_start(hmac_ctx *ctx, const hmac_key *key);
+void hmac_update(hmac_ctx *ctx, const void *msg, size_t len);
+void hmac_final(hmac_ctx *ctx, void *mac);
+void hmac_sha2(const hmac_key *key, const void *msg, size_t len, void *mac);
+
+#endif
@@ -0,0 +1,393 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "merkle.h"
+#include "sha2_mb.h"
+#include "pkcs.h"
+
+#define PARALLEL_MIN (1 << 20)   /* 해시할 바이트 수가 이보다 적으면 스레드를 만들지 않는다 */
+
+// H(prefix || a || b)를 계산한다. 잎은 b 없이 0x00을, 내부 노드는 0x01을 앞에 붙인다.
+// SHA-256 내부 노드(65바이트)처럼 짧은 입력은 이어 붙여서 sha256()의 두 블록 경로로 해시한다.
+static void hash2(int ndx, unsigned char prefix, const void *a, size_t alen, const void *b, size_t blen,
+                  unsigned char *out)
+{
+    if (ndx == SHA256 && 1 + alen + blen <= SHA256_SHORT_MAX) {
+        unsigned char buf[SHA256_SHORT_MAX];
+        buf[0] = prefix;
+        memcpy(buf + 1, a, alen);
+        if (blen > 0)
+            memcpy(buf + 1 + alen, b, blen);
+        sha256(buf, 1 + alen + blen, out);
+    }
+    else if (ndx == SHA256) {
+        sha256_ctx ctx;
+        sha256_init(&ctx);
+        sha256_update(&ctx, &prefix, 1);
+        sha256_update(&ctx, a, alen);
+        if (blen > 0)
+            sha256_update(&ctx, b, blen);
+        sha256_final(&ctx, out);
+    }
+    else {
+        sha512_ctx ctx;
+        sha512_init(&ctx);
+        sha512_update(&ctx, &prefix, 1);
+        sha512_update(&ctx, a, alen);
+        if (blen > 0)
+            sha512_update(&ctx, b, blen);
+        sha512_final(&ctx, out);
+    }
+}
+
+/*
+ * level[k]의 first번 노드부터 count개를 만드는 작업을 스레드 하나가 맡은 몫이다.
+ * k가 0이면 data를 chunk 바이트씩 잘라 잎을 만들고, 그렇지 않으면 level[k - 1]의 두 자식을 합친다.
+ */
+typedef struct {
+    merkle_t *t;
+    const unsigned char *data;
+    size_t len;
+    int k;
+    uint64_t first, count;
+    int id, nthreads;
+} work_t;
+
+static void *worker(void *arg)
+{
+    work_t *w = arg;
+    merkle_t *t = w->t;
+    const unsigned char *c;
+    uint64_t i, j;
+    size_t off;
+
+    // 스레드 id는 id, id + nthreads, id + 2*nthreads, ...번째 노드를 맡는다.
+    for (j = w->id; j < w->count; j += w->nthreads) {
+        i = w->first + j;
+        if (w->k == 0) {
+            off = j * t->chunk;
+            hash2(t->ndx, 0x00, w->data + off, w->len - off < t->chunk ? w->len - off : t->chunk,
+                  NULL, 0, t->level[0] + i * t->hlen);
+        }
+        else {
+            c = t->level[w->k - 1] + 2 * i * t->hlen;
+            hash2(t->ndx, 0x01, c, t->hlen, c + t->hlen, t->hlen, t->level[w->k] + i * t->hlen);
+        }
+    }
+    return NULL;
+}
+
+static void run(merkle_t *t, const unsigned char *data, size_t len, int k, uint64_t first, uint64_t count,
+                int nthreads)
+{
+    uint64_t bytes = k == 0 ? len : count * 2 * t->hlen;
+    int i;
+
+    if ((uint64_t)nthreads > count)
+        nthreads = count;
+    if (bytes < PARALLEL_MIN)
+        nthreads = 1;
+
+    work_t w[nthreads];
+
+    for (i = 0; i < nthreads; i++)
+        w[i] = (work_t){ t, data, len, k, first, count, i, nthreads };
+    sha2_parallel(worker, w, sizeof(work_t), nthreads);
+}
+
+// level[k]에 노드 n개가 들어갈 자리를 마련한다. 부족하면 두 배씩 늘린다.
+static int reserve(merkle_t *t, int k, uint64_t n)
+{
+    uint64_t cap = t->cap[k] ? t->cap[k] : 16;
+    unsigned char *p;
+
+    if (n <= t->cap[k])
+        return 0;
+    while (cap < n)
+        cap *= 2;
+    if ((p = realloc(t->level[k], cap * t->hlen)) == NULL)
+        return MERKLE_NO_MEMORY;
+    t->level[k] = p;
+    t->cap[k] = cap;
+    return 0;
+}
+
+int merkle_init(merkle_t *t, int sha2_ndx, size_t chunk)
+{
+    if (t == NULL || (sha2_ndx != SHA256 && sha2_ndx != SHA512))
+        return MERKLE_INVALID_ARG;
+    memset(t, 0, sizeof(*t));
+    t->ndx = sha2_ndx;
+    t->hlen = sha2_ndx == SHA256 ? SHA256_DIGEST_SIZE : SHA512_DIGEST_SIZE;
+    t->chunk = chunk ? chunk : MERKLE_CHUNK;
+    return 0;
+}
+
+// level[0]에 저장된 잎의 수로, 모아 둔 짧은 잎은 빠진다.
+static uint64_t stored(const merkle_t *t)
+{
+    return t->nleaves - (t->tail_len > 0);
+}
+
+/*
+ * add_leaves() - data를 chunk 바이트씩 잘라 잎으로 저장한다. 모아 둔 조각이 없을 때만 부른다.
+ * 새 잎을 모두 해시한 후 높이마다 새로 완성된 부분 트리의 루트만 만든다.
+ */
+static int add_leaves(merkle_t *t, const unsigned char *data, size_t len, int nthreads)
+{
+    uint64_t add, old, new, first;
+    int k;
+
+    add = (len - 1) / t->chunk + 1;
+    old = t->nleaves;
+    new = old + add;
+    for (k = 0; k < MERKLE_MAX_DEPTH && (new >> k) > 0; k++)
+        if (reserve(t, k, new >> k) != 0)
+            return MERKLE_NO_MEMORY;
+    run(t, data, len, 0, old, add, nthreads);
+    for (k = 1; k < MERKLE_MAX_DEPTH && (new >> k) > 0; k++) {
+        first = old >> k;
+        if ((new >> k) > first)
+            run(t, NULL, 0, k, first, (new >> k) - first, nthreads);
+    }
+    t->nleaves = new;
+    return 0;
+}
+
+/*
+ * merkle_append() - data를 앞서 모아 둔 조각 뒤에 이어 chunk 바이트씩 잘라 잎으로 덧붙인다.
+ * chunk 바이트가 안 되는 나머지는 다음 호출까지 모아 둔다. 성공하면 0을 넘겨준다.
+ */
+int merkle_append(merkle_t *t, const void *data, size_t len, int nthreads)
+{
+    const unsigned char *p = data;
+    size_t n;
+    int result;
+
+    if (t == NULL || (data == NULL && len > 0) || nthreads < 1)
+        return MERKLE_INVALID_ARG;
+    if (len == 0)
+        return 0;
+    if (t->tail == NULL && (t->tail = malloc(t->chunk)) == NULL)
+        return MERKLE_NO_MEMORY;
+    // 모아 둔 조각을 먼저 채우고, 다 차면 온전한 잎 하나로 저장한다.
+    if (t->tail_len > 0) {
+        n = t->chunk - t->tail_len < len ? t->chunk - t->tail_len : len;
+        memcpy(t->tail + t->tail_len, p, n);
+        p += n;
+        len -= n;
+        if (t->tail_len + n < t->chunk) {
+            t->tail_len += n;
+            hash2(t->ndx, 0x00, t->tail, t->tail_len, NULL, 0, t->tail_leaf);
+            return 0;
+        }
+        t->nleaves--;
+        t->tail_len = 0;
+        if ((result = add_leaves(t, t->tail, t->chunk, 1)) != 0)
+            return result;
+    }
+    n = len - len % t->chunk;
+    if (n > 0 && (result = add_leaves(t, p, n, nthreads)) != 0)
+        return result;
+    if (len > n) {
+        t->tail_len = len - n;
+        memcpy(t->tail, p + n, t->tail_len);
+        hash2(t->ndx, 0x00, t->tail, t->tail_len, NULL, 0, t->tail_leaf);
+        t->nleaves++;
+    }
+    return 0;
+}
+
+// 잎 n개보다 작은 가장 큰 2의 거듭제곱이다. n은 2 이상이다.
+static uint64_t split(uint64_t n)
+{
+    uint64_t s = 1;
+
+    while (s < (n + 1) / 2)
+        s <<= 1;
+    return s;
+}
+
+/* subtree_root() - 잎 [lo, lo + n)의 루트를 out에 저장한다. lo는 n보다 작지 않은 2의 거듭제곱의 배수이다.
+   n이 2의 거듭제곱이고 저장된 잎만 덮으면 저장된 노드이고, 모아 둔 짧은 잎 하나이면 그 해시이다.
+   그 밖에는 완전한 왼쪽 부분 트리와 나머지를 합친다.
+*/
+static void subtree_root(const merkle_t *t, uint64_t lo, uint64_t n, unsigned char *out)
+{
+    unsigned char l[SHA512_DIGEST_SIZE], r[SHA512_DIGEST_SIZE];
+    uint64_t s;
+    int k = 0;
+
+    if ((n & (n - 1)) == 0 && lo + n <= stored(t)) {
+        while (((uint64_t)1 << k) < n)
+            k++;
+        memcpy(out, t->level[k] + (lo >> k) * t->hlen, t->hlen);
+        return;
+    }
+    if (n == 1) {
+        memcpy(out, t->tail_leaf, t->hlen);
+        return;
+    }
+    s = split(n);
+    subtree_root(t, lo, s, l);
+    subtree_root(t, lo + s, n - s, r);
+    hash2(t->ndx, 0x01, l, t->hlen, r, t->hlen, out);
+}
+
+// 잎이 없는 트리의 루트는 빈 문자열의 해시 값이다.
+void merkle_root(const merkle_t *t, unsigned char *root)
+{
+    if (t->nleaves > 0)
+        subtree_root(t, 0, t->nleaves, root);
+    else if (t->ndx == SHA256)
+        sha256((const unsigned char *)"", 0, root);
+    else
+        sha512((const unsigned char *)"", 0, root);
+}
+
+static void path(const merkle_t *t, uint64_t m, uint64_t lo, uint64_t n, unsigned char *proof, int *cnt)
+{
+    uint64_t s;
+
+    if (n == 1)
+        return;
+    s = split(n);
+    if (m < lo + s) {
+        path(t, m, lo, s, proof, cnt);
+        subtree_root(t, lo + s, n - s, proof + *cnt * t->hlen);
+    }
+    else {
+        path(t, m, lo + s, n - s, proof, cnt);
+        subtree_root(t, lo, s, proof + *cnt * t->hlen);
+    }
+    (*cnt)++;
+}
+
+/*
+ * merkle_proof() - index번 잎의 포함 증명(RFC 6962의 PATH)을 잎에 가까운 형제부터 proof에 저장하고
+ * 해시 개수를 nproof에 저장한다. proof는 MERKLE_MAX_DEPTH개의 해시가 들어갈 수 있어야 한다.
+ */
+int merkle_proof(const merkle_t *t, uint64_t index, unsigned char *proof, int *nproof)
+{
+    if (t == NULL || proof == NULL || nproof == NULL || index >= t->nleaves)
+        return MERKLE_INVALID_ARG;
+    *nproof = 0;
+    path(t, index, 0, t->nleaves, proof, nproof);
+    return 0;
+}
+
+void merkle_leaf_hash(int sha2_ndx, const void *data, size_t len, unsigned char *out)
+{
+    hash2(sha2_ndx, 0x00, data, len, NULL, 0, out);
+}
+
+/*
+ * merkle_verify() - 잎이 size개인 트리에서 index번 잎의 해시 leaf와 포함 증명 proof로 루트를 다시 계산하여
+ * root와 비교한다(RFC 9162 2.1.3.2). 일치하면 0, 그렇지 않으면 -1을 넘겨준다.
+ */
+int merkle_verify(int sha2_ndx, const unsigned char *leaf, uint64_t index, uint64_t size,
+                  const unsigned char *proof, int nproof, const unsigned char *root)
+{
+    unsigned char r[SHA512_DIGEST_SIZE];
+    int hlen = sha2_ndx == SHA256 ? SHA256_DIGEST_SIZE : SHA512_DIGEST_SIZE;
+    uint64_t fn = index, sn = size - 1;
+    int i;
+
+    if (index >= size || (sha2_ndx != SHA256 && sha2_ndx != SHA512))
+        return -1;
+    memcpy(r, leaf, hlen);
+    for (i = 0; i < nproof; i++, proof += hlen) {
+        if (sn == 0)
+            return -1;
+        if ((fn & 1) || fn == sn) {
+            hash2(sha2_ndx, 0x01, proof, hlen, r, hlen, r);
+            // 오른쪽 끝 부분 트리에서 올라온 경우에는 형제가 없는 높이를 건너뛴다.
+            while (!(fn & 1) && fn != 0) {
+                fn >>= 1;
+                sn >>= 1;
+            }
+        }
+        else
+            hash2(sha2_ndx, 0x01, r, hlen, proof, hlen, r);
+        fn >>= 1;
+        sn >>= 1;
+    }
+    return sn == 0 && memcmp(r, root, hlen) == 0 ? 0 : -1;
+}
+
+// 버퍼를 가능한 한 가득 채운다. 잎 경계가 어긋나지 않도록 끝이나 오류가 날 때까지 반복한다.
+static ssize_t fill(int fd, unsigned char *buf, size_t size)
+{
+    size_t got = 0;
+    ssize_t r;
+
+    while (got < size) {
+        if ((r = read(fd, buf + got, size - got)) == 0)
+            break;
+        if (r < 0)
+            return -1;
+        got += r;
+    }
+    return got;
+}
+
+/*
+ * merkle_file() - path 파일의 머클 루트를 root에 저장한다. 일반 파일은 매핑하여 모든 잎을 한 번에
+ * nthreads개의 스레드로 해시하고, 매핑할 수 없는 입력은 잎 nthreads개 크기씩 읽어서 덧붙인다.
+ */
+int merkle_file(const char *path, int sha2_ndx, size_t chunk, int nthreads, unsigned char *root)
+{
+    merkle_t t;
+    struct stat st;
+    unsigned char *buf;
+    void *p;
+    ssize_t n;
+    int fd, result;
+
+    if (path == NULL || root == NULL || nthreads < 1)
+        return MERKLE_INVALID_ARG;
+    if ((result = merkle_init(&t, sha2_ndx, chunk)) != 0)
+        return result;
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return MERKLE_OPEN_FAIL;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && (uint64_t)st.st_size <= SIZE_MAX
+        && (p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED) {
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        result = merkle_append(&t, p, st.st_size, nthreads);
+        munmap(p, st.st_size);
+    }
+    else if ((buf = malloc(nthreads * t.chunk)) == NULL)
+        result = MERKLE_NO_MEMORY;
+    else {
+        while (result == 0 && (n = fill(fd, buf, nthreads * t.chunk)) > 0)
+            result = merkle_append(&t, buf, n, nthreads);
+        if (n < 0)
+            result = MERKLE_READ_FAIL;
+        free(buf);
+    }
+    close(fd);
+    if (result == 0)
+        merkle_root(&t, root);
+    merkle_free(&t);
+    return result;
+}
+
+void merkle_free(merkle_t *t)
+{
+    int k;
+
+    for (k = 0; k < MERKLE_MAX_DEPTH; k++)
+        free(t->level[k]);
+    free(t->tail);
+    memset(t, 0, sizeof(*t));
+}
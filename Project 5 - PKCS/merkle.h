@@ -0,0 +1,59 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _MERKLE_H_
+#define _MERKLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sha2.h"
+
+/*
+ * 머클 트리 해시 (RFC 6962/9162)
+ *
+ * 데이터를 chunk 바이트씩 잘라 잎으로 삼고, 잎은 H(0x00 || 조각), 내부 노드는 H(0x01 || 왼쪽 || 오른쪽)이다.
+ * chunk 바이트가 안 되는 마지막 조각은 tail에 모아 두었다가 다음 merkle_append()에서 채우므로, 데이터를
+ * 어떻게 나누어 덧붙이든 트리는 같다. 루트와 증명은 모아 둔 조각을 마지막 짧은 잎으로 보고 계산한다.
+ * 잎이 2^k개인 완전한 부분 트리의 루트만 level[k]에 차례대로 저장하므로, 잎을 덧붙이면 오른쪽 끝 경로의
+ * 노드만 새로 생기고 전체 루트는 완전한 부분 트리 루트들(최대 64개)을 접어서 구한다.
+ * 잎과 새로 생긴 내부 노드는 nthreads개의 스레드가 나누어 해시한다.
+ * 해시 함수는 pkcs.h의 SHA256 또는 SHA512를 사용한다.
+ */
+#define MERKLE_MAX_DEPTH 64
+#define MERKLE_CHUNK (1 << 20)   /* 기본 잎 크기(바이트) */
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define MERKLE_INVALID_ARG 1
+#define MERKLE_NO_MEMORY   2
+#define MERKLE_OPEN_FAIL   3
+#define MERKLE_READ_FAIL   4
+
+typedef struct {
+    int ndx;                                /* SHA256 또는 SHA512 */
+    int hlen;                               /* 해시 길이(바이트) */
+    size_t chunk;                           /* 잎 하나의 최대 크기(바이트) */
+    uint64_t nleaves;                       /* 모아 둔 짧은 잎을 포함한 잎의 수 */
+    unsigned char *level[MERKLE_MAX_DEPTH]; /* level[k]에는 잎 2^k개짜리 완전한 부분 트리의 루트가 차례대로 있다 */
+    uint64_t cap[MERKLE_MAX_DEPTH];         /* level[k]에 할당된 노드 수 */
+    unsigned char *tail;                    /* 아직 chunk 바이트가 안 된 마지막 조각 */
+    size_t tail_len;
+    unsigned char tail_leaf[SHA512_DIGEST_SIZE]; /* tail_len이 0이 아니면 짧은 잎의 해시 */
+} merkle_t;
+
+int merkle_init(merkle_t *t, int sha2_ndx, size_t chunk);
+int merkle_append(merkle_t *t, const void *data, size_t len, int nthreads);
+void merkle_root(const merkle_t *t, unsigned char *root);
+int merkle_proof(const merkle_t *t, uint64_t index, unsigned char *proof, int *nproof);
+void merkle_leaf_hash(int sha2_ndx, const void *data, size_t len, unsigned char *out);
+int merkle_verify(int sha2_ndx, const unsigned char *leaf, uint64_t index, uint64_t size,
+                  const unsigned char *proof, int nproof, const unsigned char *root);
+int merkle_file(const char *path, int sha2_ndx, size_t chunk, int nthreads, unsigned char *root);
+void merkle_free(merkle_t *t);
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pbkdf2.h"
+#include "hmac.h"
+#include "sha2_mb.h"
+#include "pkcs.h"
+
+#define LANES SHA256_MB_LANES   /* SHA512_MB_LANES와 같다 */
+
+/*
+ * 출력 블록 T_i 하나의 계산 상태이다. t에는 지금까지의 U_1 ^ ... ^ U_j가 들어 있다.
+ */
+typedef struct {
+    const hmac_key *key;
+    unsigned char t[HMAC_MAX_SIZE];
+    unsigned char *out;
+    size_t len;
+} dk_block;
+
+// 레인 상태의 앞 hlen 바이트를 빅 엔디안으로 blk에 쓴다. 다음 압축의 입력이 된다.
+// 해시 길이는 모두 4의 배수이므로 32비트씩 쓴다(SHA-512/224는 마지막 워드의 앞 절반만 쓴다).
+static void put_digest(int is256, const void *h, int l, unsigned char *blk, int hlen)
+{
+    const uint32 (*h256)[LANES] = h;
+    const uint64 (*h512)[LANES] = h;
+    uint32 w;
+    int k;
+
+    for (k = 0; k < hlen; k += 4) {
+        w = is256 ? h256[k / 4][l] : (uint32)(h512[k / 8][l] >> (k % 8 ? 0 : 32));
+        blk[k] = w >> 24;
+        blk[k + 1] = w >> 16;
+        blk[k + 2] = w >> 8;
+        blk[k + 3] = w;
+    }
+}
+
+/* run_lanes() - 블록 n개(LANES 이하)의 U_2 ~ U_iter를 레인 하나에 하나씩 배정하여 함께 계산한다.
+   U_j는 HMAC(P, U_{j-1})이고 HMAC 입력은 해시 길이이므로 안쪽과 바깥쪽 모두 패딩까지 한 블록에 들어간다.
+   두 블록은 레인마다 같은 버퍼를 사용하며, 앞 hlen 바이트만 바꾸어 가며 중간 상태에서 한 번씩 압축한다.
+*/
+static void run_lanes(dk_block *b, int n, unsigned long iter)
+{
+    const int ndx = b[0].key->ndx, hlen = b[0].key->size;
+    const int is256 = ndx == SHA224 || ndx == SHA256;
+    const int bs = is256 ? SHA256_BLOCK_SIZE : SHA512_BLOCK_SIZE;
+    unsigned char blk[LANES][SHA512_BLOCK_SIZE];
+    const unsigned char *bp[LANES];
+    uint32 h256[8][LANES];
+    uint64 h512[8][LANES];
+    uint64 bits = (uint64)(bs + hlen) << 3;
+    unsigned long j;
+    int l, i, k;
+
+    // 빈 레인은 압축하지 않지만 상태 배열은 통째로 넘기므로 0으로 채워 둔다.
+    memset(h256, 0, sizeof(h256));
+    memset(h512, 0, sizeof(h512));
+    for (l = 0; l < LANES; l++) {
+        bp[l] = l < n ? blk[l] : NULL;
+        if (l >= n)
+            continue;
+        memset(blk[l], 0, bs);
+        memcpy(blk[l], b[l].t, hlen);
+        blk[l][hlen] = 0x80;
+        for (i = 1; i <= 8; i++)
+            blk[l][bs - i] = bits >> (8 * (i - 1));
+    }
+    for (j = 1; j < iter; j++) {
+        if (is256) {
+            for (l = 0; l < n; l++)
+                for (i = 0; i < 8; i++)
+                    h256[i][l] = b[l].key->ipad.h256[i];
+            sha256_mb_transf(h256, bp);
+            for (l = 0; l < n; l++) {
+                put_digest(1, h256, l, blk[l], hlen);
+                for (i = 0; i < 8; i++)
+                    h256[i][l] = b[l].key->opad.h256[i];
+            }
+            sha256_mb_transf(h256, bp);
+            for (l = 0; l < n; l++)
+                put_digest(1, h256, l, blk[l], hlen);
+        }
+        else {
+            for (l = 0; l < n; l++)
+                for (i = 0; i < 8; i++)
+                    h512[i][l] = b[l].key->ipad.h512[i];
+            sha512_mb_transf(h512, bp);
+            for (l = 0; l < n; l++) {
+                put_digest(0, h512, l, blk[l], hlen);
+                for (i = 0; i < 8; i++)
+                    h512[i][l] = b[l].key->opad.h512[i];
+            }
+            sha512_mb_transf(h512, bp);
+            for (l = 0; l < n; l++)
+                put_digest(0, h512, l, blk[l], hlen);
+        }
+        for (l = 0; l < n; l++)
+            for (k = 0; k < hlen; k++)
+                b[l].t[k] ^= blk[l][k];
+    }
+    memset(blk, 0, sizeof(blk));
+    memset(h256, 0, sizeof(h256));
+    memset(h512, 0, sizeof(h512));
+}
+
+/*
+ * pbkdf2_batch() - 패스워드 njobs개의 키를 함께 유도한다. 모든 패스워드의 모든 출력 블록을
+ * 한 줄로 세워 LANES개씩 run_lanes()로 처리하므로 출력이 긴 키 하나도 여러 레인을 사용한다.
+ * 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int pbkdf2_batch(int sha2_ndx, unsigned long iter, pbkdf2_job *job, int njobs)
+{
+    hmac_key *key;
+    hmac_ctx ctx;
+    dk_block *blk;
+    unsigned char c[4];
+    size_t nblk = 0, hlen, off, k;
+    uint32 i;
+    int n;
+
+    if (sha2_ndx < SHA224 || sha2_ndx > SHA512_256 || iter == 0 || njobs < 0 || (job == NULL && njobs > 0))
+        return PBKDF2_INVALID_ARG;
+    hlen = sha2_descs[sha2_ndx].digest_size;
+    for (n = 0; n < njobs; n++) {
+        if ((job[n].pass == NULL && job[n].pass_len > 0) || (job[n].salt == NULL && job[n].salt_len > 0)
+            || (job[n].dk == NULL && job[n].dk_len > 0))
+            return PBKDF2_INVALID_ARG;
+        // 블록 번호는 32비트이므로 출력은 (2^32 - 1) * hLen 바이트를 넘을 수 없다.
+        if ((uint64)job[n].dk_len > 0xffffffffULL * hlen)
+            return PBKDF2_DK_TOO_LONG;
+        nblk += (job[n].dk_len + hlen - 1) / hlen;
+    }
+    if (nblk == 0)
+        return 0;
+    key = malloc(njobs * sizeof(hmac_key));
+    blk = malloc(nblk * sizeof(dk_block));
+    if (key == NULL || blk == NULL) {
+        free(key);
+        free(blk);
+        return PBKDF2_NO_MEMORY;
+    }
+
+    // U_1 = HMAC(P, S || INT(i))는 블록마다 길이가 다르므로 하나씩 계산한다.
+    for (n = 0, k = 0; n < njobs; n++) {
+        hmac_key_init(&key[n], sha2_ndx, job[n].pass, job[n].pass_len);
+        for (off = 0, i = 1; off < job[n].dk_len; off += hlen, i++, k++) {
+            c[0] = i >> 24; c[1] = i >> 16; c[2] = i >> 8; c[3] = i;
+            hmac_start(&ctx, &key[n]);
+            hmac_update(&ctx, job[n].salt, job[n].salt_len);
+            hmac_update(&ctx, c, 4);
+            hmac_final(&ctx, blk[k].t);
+            blk[k].key = &key[n];
+            blk[k].out = (unsigned char *)job[n].dk + off;
+            blk[k].len = job[n].dk_len - off < hlen ? job[n].dk_len - off : hlen;
+        }
+    }
+    for (k = 0; k < nblk; k += LANES)
+        run_lanes(blk + k, nblk - k < LANES ? nblk - k : LANES, iter);
+    for (k = 0; k < nblk; k++)
+        memcpy(blk[k].out, blk[k].t, blk[k].len);
+
+    memset(key, 0, njobs * sizeof(hmac_key));
+    memset(blk, 0, nblk * sizeof(dk_block));
+    free(key);
+    free(blk);
+    return 0;
+}
+
+int pbkdf2(int sha2_ndx, const void *pass, size_t pass_len, const void *salt, size_t salt_len,
+           unsigned long iter, void *dk, size_t dk_len)
+{
+    pbkdf2_job job;
+
+    job.pass = pass;
+    job.pass_len = pass_len;
+    job.salt = salt;
+    job.salt_len = salt_len;
+    job.dk = dk;
+    job.dk_len = dk_len;
+    return pbkdf2_batch(sha2_ndx, iter, &job, 1);
+}
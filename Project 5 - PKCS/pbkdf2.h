@@ -0,0 +1,45 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _PBKDF2_H_
+#define _PBKDF2_H_
+
+#include <stddef.h>
+
+/*
+ * PBKDF2-HMAC-SHA2 (RFC 8018)
+ *
+ * 출력 블록 T_i 하나를 계산하는 반복은 다른 블록이나 다른 패스워드와 독립이므로, 독립인 블록들을 다중 버퍼
+ * SHA-2의 레인에 하나씩 배정하여 모든 반복을 함께 진행한다. 반복마다 패스워드의 HMAC 중간 상태에서
+ * 시작하므로 반복 하나는 안쪽과 바깥쪽 블록을 하나씩, 모두 두 번만 압축한다.
+ * 해시 함수는 pkcs.h의 SHA224 ~ SHA512_256 중에서 고른다.
+ */
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define PBKDF2_INVALID_ARG 1
+#define PBKDF2_DK_TOO_LONG 2
+#define PBKDF2_NO_MEMORY   3
+
+/*
+ * pbkdf2_batch()에 넘겨주는 패스워드 하나이다. dk에 dk_len 바이트의 키가 저장된다.
+ */
+typedef struct {
+    const void *pass;
+    size_t pass_len;
+    const void *salt;
+    size_t salt_len;
+    void *dk;
+    size_t dk_len;
+} pbkdf2_job;
+
+int pbkdf2(int sha2_ndx, const void *pass, size_t pass_len, const void *salt, size_t salt_len,
+           unsigned long iter, void *dk, size_t dk_len);
+int pbkdf2_batch(int sha2_ndx, unsigned long iter, pbkdf2_job *job, int njobs);
+
+#endif
@@ -19,10 +19,7 @@
 #include <gmp.h>
 #include "pkcs.h"
 #include "sha2.h"
-
-// 해시 함수가 처리할 수 있는 message digest 크기(모음), count용 i, 반환값
-int hLen, i, result;
-const int hash_output[6] = {SHA224_DIGEST_SIZE, SHA256_DIGEST_SIZE, SHA384_DIGEST_SIZE, SHA512_DIGEST_SIZE, SHA224_DIGEST_SIZE, SHA256_DIGEST_SIZE};
+#include "sha2_mb.h"
 
 // padding string과 메시지를 분리하기 위한 0x01 / 암호문을 수치화한 값이 key보다 작도록 하는 0x00 / 서명문의 맨 뒤에 붙이는 0xbc
 const unsigned char line[1] = {0x01}, small[1] = {0x00}, bc[1] = {0xbc};
@@ -35,7 +32,7 @@ const unsigned char empty[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 */
 int check_length(size_t l_length, int sha_index) {
     // 이상 없을 시 반환할 결과값
-    result = 0;
+    int result = 0;
     // 메시지의 길이를 담을 변수를 초기화한다.
     mpz_t n_length;
     // 해시 함수가 최대로 지원하는 message 크기를 담을 변수를 초기화한다.
@@ -63,26 +60,6 @@ int check_length(size_t l_length, int sha_index) {
     return result;
 }
 
-/* calc_hash() - 사용자가 지정한 hash 함수를 이용하여 HASH(L)을 계산하는 함수
-   sha224/256/384/512/512_224/512_256을 지원한다.
-*/
-void calc_hash(void *label, size_t length, void *digest, int sha2_idx) {
-    // label을 사용자가 지정한 해시 함수로 처리하여 hash에 저장한다.
-    if (sha2_idx == SHA224) {
-        sha224(label, length, digest);
-    } else if (sha2_idx == SHA256) {
-        sha256(label, length, digest);
-    } else if (sha2_idx == SHA384) {
-        sha384(label, length, digest);
-    } else if (sha2_idx == SHA512) {
-        sha512(label, length, digest);
-    } else if (sha2_idx == SHA512_224) {
-        sha512_224(label, length, digest);
-    } else if (sha2_idx == SHA512_256) {
-        sha512_256(label, length, digest);
-    }
-}
-
 /* mgf1() - Mask Generation Functions
    src 배열을 해시 함수로 처리한 결과를 앞에서부터
    target의 길이만큼 잘라내어 복사하는 함수
@@ -91,41 +68,44 @@ int mgf1(void *src, size_t src_length, void *target, size_t maskLen, int sha2_nd
 
     // 한 종류의 해시 함수만 사용하는 것이 아니라 사용자가 지정한 해시 함수를 사용해야한다.
     // 따라서 hLen(사용자가 지정한 해시 함수가 처리할 수 있는 message digest 크기)이 필요하다.
+    const int hLen = sha2_descs[sha2_ndx].digest_size;
     // 반환할 결과값
-    result = 0;
+    int result = 0;
 
     // maskLen이 2^32 * hLen보다 클 경우 에러메시지를 반환한다.
     if (maskLen > ((uint64_t)hLen << 32)) result = PKCS_MASK_TOO_LONG;
 
     // mask를 몇 번째 생성 중인지 계산하는 변수
     size_t count = 0;
-    // count를 4바이트 string으로 변환한 결과를 담을 변수
-    unsigned char counter[4] ={0x00, 0x00, 0x00, 0x00};
-    // src + counter를 저장할 변수와 src + counter를 해시함수로 처리한 결과를 담을 변수
-    int temp_length = src_length + 4; unsigned char temp[src_length + 4], hash[hLen];
     // 해시함수로 처리한 결과를 누적해서 담을 변수
     unsigned char output[((maskLen + hLen) / hLen + 1) * hLen];
     // count가 ((maskLen + hLen - 1) / hLen) - 1에 도달할 때까지 반복한다.
     int limit = ((maskLen + hLen - 1) / hLen) - 1;
+    // 카운터마다 src와 counter 두 조각을 이어 붙이지 않고 그대로 한꺼번에 해시한다.
+    unsigned char counter[limit + 1][4];
+    sha2_iovec in[limit + 1][2];
+    const sha2_iovec *msgs[limit + 1];
+    int iovcnt[limit + 1];
+    unsigned char *digests[limit + 1];
+
     while (count <= limit) {
-        // count를 4바이트 string으로 변환한 결과를 counter에 저장한다.
-        // big-endian으로 저장해야한다.
-        counter[3] = (count) & 0xFF;
-        counter[2] = (count >> 8) & 0xFF;
-        counter[1] = (count >> 16) & 0xFF;
-        counter[0] = (count >> 24) & 0xFF;
-        // temp에 src와 counter를 순차적으로 저장한다.
-        memcpy(temp, src, src_length);
-        memcpy(temp + src_length, counter, 4);
-
-        // temp를 해시 처리하고 결과를 hash에 저장한다.
-        calc_hash(temp, temp_length, hash, sha2_ndx);
-
-        // hash에 저장된 결과를 output에 누적하여 저장한다.
-        memcpy(output + (count * hLen), hash, hLen);
+        // count는 big-endian 4바이트 string으로 저장해야한다.
+        counter[count][0] = (count >> 24) & 0xFF;
+        counter[count][1] = (count >> 16) & 0xFF;
+        counter[count][2] = (count >> 8) & 0xFF;
+        counter[count][3] = (count) & 0xFF;
+        in[count][0] = (sha2_iovec){src, src_length};
+        in[count][1] = (sha2_iovec){counter[count], 4};
+
+        // 해시 결과는 output의 count번째 자리에 바로 저장된다.
+        msgs[count] = in[count];
+        iovcnt[count] = 2;
+        digests[count] = output + (count * hLen);
 
         count++;
     }
+    // SHA2_MB_* 값은 sha2_ndx와 같다.
+    sha2_hash_many_iov(sha2_ndx, msgs, iovcnt, limit + 1, digests);
     // 최종적으로 output의 앞에서부터 maskLen까지의 string을 잘라내어 target에 저장한다.
     memcpy(target, output, maskLen);
 
@@ -251,25 +231,24 @@ static int rsa_cipher(void *_m, const void *_k, const void *_n)
 int rsaes_oaep_encrypt(const void *m, size_t mLen, const void *label, const void *e, const void *n, void *c, int sha2_ndx)
 {
     // 반환할 결과값
-    result = 0;
+    int i, result = 0;
     // Length Checking
     // label의 길이(바이트)를 구한다.
     size_t label_len = strlen((char *)label); 
-    // 반환할 결과값
-    result = 0;
 
     // label의 길이가 0이 아닌 경우 해시 함수로 처리 가능한지 확인한다.
     if (label_len != 0 && check_length(label_len, sha2_ndx)) return PKCS_LABEL_TOO_LONG;
 
     // hLen(사용자가 지정한 해시 함수가 처리할 수 있는 message digest 크기)을 생성한다.
-    hLen = hash_output[sha2_ndx];
+    const sha2_desc *hd = &sha2_descs[sha2_ndx];
+    const int hLen = hd->digest_size;
 
     // 만약 메시지의 길이가 kLen - 2 * hLen - 2보다 길면 오류 메시지를 반환한다.
     if (mLen > KLEN - 2 * hLen - 2) return PKCS_MSG_TOO_LONG;
 
     // 사용자가 지정한 hash 함수를 이용하여 HASH(L)을 계산한다.
     unsigned char hash_l[hLen];
-    calc_hash((void *)label, label_len, &hash_l, sha2_ndx);
+    hd->hash((void *)label, label_len, hash_l);
 
     // DataBlock을 생성한다.
     // DataBlock의 길이는 kLen - hLen - 1이다.
@@ -346,7 +325,7 @@ int rsaes_oaep_encrypt(const void *m, size_t mLen, const void *label, const void
 int rsaes_oaep_decrypt(void *m, size_t *mLen, const void *label, const void *d, const void *n, const void *c, int sha2_ndx)
 {
     // 반환할 결과값
-    result = 0;
+    int i, result = 0;
     // Length Checking
     // label의 길이(바이트)를 구한다.
     size_t label_len = strlen((char *)label); 
@@ -355,7 +334,8 @@ int rsaes_oaep_decrypt(void *m, size_t *mLen, const void *label, const void *d,
     if (label_len != 0 && check_length(label_len, sha2_ndx)) return PKCS_LABEL_TOO_LONG;
 
     // hLen(사용자가 지정한 해시 함수가 처리할 수 있는 message digest 크기)을 생성한다.
-    hLen = hash_output[sha2_ndx];
+    const sha2_desc *hd = &sha2_descs[sha2_ndx];
+    const int hLen = hd->digest_size;
 
     // 키의 길이가 2 * hLen + 2보다 작은 경우 오류 메시지를 반환한다.
     if (KLEN < 2 * hLen + 2) return DECRYPTION_ERROR;
@@ -409,7 +389,7 @@ int rsaes_oaep_decrypt(void *m, size_t *mLen, const void *label, const void *d,
 
     // 검증용 Hash(L)을 생성한다.
     unsigned char hash_l[hLen];
-    calc_hash((void *)label, label_len, &hash_l, sha2_ndx);
+    hd->hash((void *)label, label_len, hash_l);
 
     // DB에서 Hash(L)을 분리한다.
     unsigned char n_hash_l[hLen];
@@ -467,17 +447,18 @@ int rsaes_oaep_decrypt(void *m, size_t *mLen, const void *label, const void *d,
 int rsassa_pss_sign(const void *m, size_t mLen, const void *d, const void *n, void *s, int sha2_ndx)
 {
     // 반환할 결과값
-    result = 0;
+    int i, result = 0;
     // Length Checking
     // message가 해시 함수로 처리 가능한지 확인한다.
     if (check_length(mLen, sha2_ndx)) return PKCS_MSG_TOO_LONG;
 
     // hLen(사용자가 지정한 해시 함수가 처리할 수 있는 message digest 크기)을 생성한다.
-    hLen = hash_output[sha2_ndx];
+    const sha2_desc *hd = &sha2_descs[sha2_ndx];
+    const int hLen = hd->digest_size;
 
     // mHash를 생성한다.
     unsigned char mHash[hLen];
-    calc_hash((void *)m, mLen, &mHash, sha2_ndx);
+    hd->hash((void *)m, mLen, mHash);
 
     // emLen이 hLen + sLen + 2보다 작을 경우 에러메시지를 반환한다(salt의 길이는 hLen이다).
     if (EMLEN < 2 * hLen + 2) return PKCS_HASH_TOO_LONG;
@@ -486,16 +467,10 @@ int rsassa_pss_sign(const void *m, size_t mLen, const void *d, const void *n, vo
     unsigned char salt[hLen];
     arc4random_buf(&salt, sizeof(salt));
 
-    // hashed_m을 생성한다. 
-    int hm_length = 8 + 2 * hLen; 
-    unsigned char hashed_m[hm_length];
-    memcpy(hashed_m, empty, 8);
-    memcpy(hashed_m + 8, mHash, hLen);
-    memcpy(hashed_m + 8 + hLen, salt, hLen);
-
-    // hashed_m2를 생성한다.
+    // hashed_m = 0x00 * 8 || mHash || salt을 이어 붙이지 않고 세 조각 그대로 해시하여 hashed_m2를 생성한다.
+    const sha2_iovec hashed_m[3] = {{empty, 8}, {mHash, hLen}, {salt, hLen}};
     unsigned char hashed_m2[hLen];
-    calc_hash(&hashed_m, hm_length, &hashed_m2, sha2_ndx);
+    hd->hash_iov(hashed_m, 3, hashed_m2);
 
     // DataBlock을 생성한다. DB = PS || 0x01 || salt
     int db_length = EMLEN - hLen - 1, ps_len = EMLEN - 2 * hLen - 2; unsigned char DB[db_length]; 
@@ -543,13 +518,14 @@ int rsassa_pss_sign(const void *m, size_t mLen, const void *d, const void *n, vo
 int rsassa_pss_verify(const void *m, size_t mLen, const void *e, const void *n, const void *s, int sha2_ndx)
 {
     // 반환할 결과값
-    result = 0;
+    int i, result = 0;
     // Length Checking
     // message가 해시 함수로 처리 가능한지 확인한다.
     if (check_length(mLen, sha2_ndx)) return PKCS_MSG_TOO_LONG;
 
     // hLen(사용자가 지정한 해시 함수가 처리할 수 있는 message digest 크기)을 생성하고 키의 바이트 길이를 emLen에 저장한다.
-    hLen = hash_output[sha2_ndx];
+    const sha2_desc *hd = &sha2_descs[sha2_ndx];
+    const int hLen = hd->digest_size;
 
     // emLen이 2 * hLen + 2보다 작은 경우 오류 메시지를 반환한다(salt의 길이는 hLen이다).
     if (EMLEN < 2 * hLen + 2) return VERIFICATION_ERROR;
@@ -616,16 +592,12 @@ int rsassa_pss_verify(const void *m, size_t mLen, const void *e, const void *n,
 
     // 서명을 검증하기 위해 mhash를 생성한다.
     unsigned char mhash[hLen];
-    calc_hash((void *)m, mLen, &mhash, sha2_ndx);
+    hd->hash((void *)m, mLen, mhash);
 
-    // 검증용 메시지를 생성한다.
-    int hm_length = 8 + 2 * hLen;
-    unsigned char hashed_m[hm_length]; 
+    // 검증용 메시지를 생성한다. hashed_m은 서명할 때와 같이 세 조각 그대로 해시한다.
+    const sha2_iovec hashed_m[3] = {{empty, 8}, {mhash, hLen}, {salt, hLen}};
     unsigned char ver_m[hLen];
-    memcpy(hashed_m, empty, 8);
-    memcpy(hashed_m + 8, mhash, hLen);
-    memcpy(hashed_m + 8 + hLen, salt, hLen);
-    calc_hash(&hashed_m, hm_length, &ver_m, sha2_ndx);
+    hd->hash_iov(hashed_m, 3, ver_m);
 
     // 검증용 메시지와 복원된 메시지가 다르면 오류 메시지를 반환한다.
     if (memcmp(ver_m, hashed_m2, hLen)) return PKCS_HASH_MISMATCH;
@@ -36,6 +36,8 @@
 #ifndef SHA2_H
 #define SHA2_H
 
+#include <stddef.h>
+
 #define SHA224_DIGEST_SIZE ( 224 / 8)
 #define SHA256_DIGEST_SIZE ( 256 / 8)
 #define SHA384_DIGEST_SIZE ( 384 / 8)
@@ -46,6 +48,10 @@
 #define SHA384_BLOCK_SIZE  SHA512_BLOCK_SIZE
 #define SHA224_BLOCK_SIZE  SHA256_BLOCK_SIZE
 
+/* Longest message that sha224()/sha256() hash on the two-block short path */
+#define SHA256_SHORT_MAX   (2 * SHA256_BLOCK_SIZE - 9)
+#define SHA224_SHORT_MAX   SHA256_SHORT_MAX
+
 #ifndef SHA2_TYPES
 #define SHA2_TYPES
 typedef unsigned char uint8;
@@ -58,15 +64,15 @@ extern "C" {
 #endif
 
 typedef struct {
-    unsigned int tot_len;
-    unsigned int len;
+    uint64 tot_len;
+    size_t len;
     unsigned char block[2 * SHA256_BLOCK_SIZE];
     uint32 h[8];
 } sha256_ctx;
 
 typedef struct {
-    unsigned int tot_len;
-    unsigned int len;
+    uint64 tot_len;
+    size_t len;
     unsigned char block[2 * SHA512_BLOCK_SIZE];
     uint64 h[8];
 } sha512_ctx;
@@ -74,42 +80,110 @@ typedef struct {
 typedef sha512_ctx sha384_ctx;
 typedef sha256_ctx sha224_ctx;
 
+/* One fragment of a message given to the *_iov functions */
+typedef struct {
+    const void *base;
+    size_t len;
+} sha2_iovec;
+
+/* Versioned byte format of an exported midstate (see sha2.c) */
+#define SHA2_STATE_VERSION    2
+#define SHA2_STATE_SHA224     1
+#define SHA2_STATE_SHA256     2
+#define SHA2_STATE_SHA384     3
+#define SHA2_STATE_SHA512     4
+#define SHA2_STATE_SHA512_224 5
+#define SHA2_STATE_SHA512_256 6
+#define SHA256_STATE_MAX_SIZE (11 + 8 * 4 + SHA256_BLOCK_SIZE - 1)
+#define SHA512_STATE_MAX_SIZE (11 + 8 * 8 + SHA512_BLOCK_SIZE - 1)
+
+/* Compression function backends for sha2_set_backend() */
+#define SHA2_BACKEND_NATIVE   0   /* SHA-NI / AVX2 when available (default) */
+#define SHA2_BACKEND_PORTABLE 1   /* plain C */
+
 void sha224_init(sha224_ctx *ctx);
 void sha224_update(sha224_ctx *ctx, const unsigned char *message,
-                   unsigned int len);
+                   size_t len);
 void sha224_final(sha224_ctx *ctx, unsigned char *digest);
-void sha224(const unsigned char *message, unsigned int len,
+void sha224(const unsigned char *message, size_t len,
             unsigned char *digest);
 
 void sha256_init(sha256_ctx * ctx);
 void sha256_update(sha256_ctx *ctx, const unsigned char *message,
-                   unsigned int len);
+                   size_t len);
 void sha256_final(sha256_ctx *ctx, unsigned char *digest);
-void sha256(const unsigned char *message, unsigned int len,
+void sha256(const unsigned char *message, size_t len,
             unsigned char *digest);
+void sha256d(const unsigned char *message, size_t len,
+             unsigned char *digest);
+void sha256_update_iov(sha256_ctx *ctx, const sha2_iovec *iov, int iovcnt);
 
 void sha384_init(sha384_ctx *ctx);
 void sha384_update(sha384_ctx *ctx, const unsigned char *message,
-                   unsigned int len);
+                   size_t len);
 void sha384_final(sha384_ctx *ctx, unsigned char *digest);
-void sha384(const unsigned char *message, unsigned int len,
+void sha384(const unsigned char *message, size_t len,
             unsigned char *digest);
 
 void sha512_init(sha512_ctx *ctx);
 void sha512_224_init(sha512_ctx *ctx);
 void sha512_256_init(sha512_ctx *ctx);
 void sha512_update(sha512_ctx *ctx, const unsigned char *message,
-                   unsigned int len);
+                   size_t len);
 void sha512_final(sha512_ctx *ctx, unsigned char *digest);
 void sha512_224_final(sha512_ctx *ctx, unsigned char *digest);
 void sha512_256_final(sha512_ctx *ctx, unsigned char *digest);
-void sha512(const unsigned char *message, unsigned int len,
+void sha512_update_iov(sha512_ctx *ctx, const sha2_iovec *iov, int iovcnt);
+void sha512(const unsigned char *message, size_t len,
             unsigned char *digest);
-void sha512_224(const unsigned char *message, unsigned int len,
+void sha512_224(const unsigned char *message, size_t len,
             unsigned char *digest);
-void sha512_256(const unsigned char *message, unsigned int len,
+void sha512_256(const unsigned char *message, size_t len,
             unsigned char *digest);
 
+size_t sha224_export(const sha224_ctx *ctx, unsigned char *out);
+int sha224_import(sha224_ctx *ctx, const unsigned char *in, size_t in_len);
+size_t sha256_export(const sha256_ctx *ctx, unsigned char *out);
+int sha256_import(sha256_ctx *ctx, const unsigned char *in, size_t in_len);
+size_t sha384_export(const sha384_ctx *ctx, unsigned char *out);
+int sha384_import(sha384_ctx *ctx, const unsigned char *in, size_t in_len);
+size_t sha512_export(const sha512_ctx *ctx, unsigned char *out);
+int sha512_import(sha512_ctx *ctx, const unsigned char *in, size_t in_len);
+size_t sha512_224_export(const sha512_ctx *ctx, unsigned char *out);
+int sha512_224_import(sha512_ctx *ctx, const unsigned char *in, size_t in_len);
+size_t sha512_256_export(const sha512_ctx *ctx, unsigned char *out);
+int sha512_256_import(sha512_ctx *ctx, const unsigned char *in, size_t in_len);
+
+void sha2_set_backend(int backend);
+const char *sha256_backend_name(void);
+const char *sha512_backend_name(void);
+
+/* Table of the six SHA-2 functions, indexed SHA-224, SHA-256, SHA-384,
+ * SHA-512, SHA-512/224, SHA-512/256 (the SHA224 .. SHA512_256 indices of
+ * pkcs.h and ecdsa.h).
+ */
+#define SHA2_NUM_DESCS 6
+
+typedef union {
+    sha256_ctx c256;
+    sha512_ctx c512;
+} sha2_ctx;
+
+typedef struct {
+    const char *name;
+    int digest_size;
+    int block_size;
+    void (*init)(sha2_ctx *ctx);
+    void (*update)(sha2_ctx *ctx, const unsigned char *message, size_t len);
+    void (*final)(sha2_ctx *ctx, unsigned char *digest);
+    void (*hash)(const unsigned char *message, size_t len,
+                 unsigned char *digest);
+    void (*hash_iov)(const sha2_iovec *iov, int iovcnt,
+                     unsigned char *digest);
+} sha2_desc;
+
+extern const sha2_desc sha2_descs[SHA2_NUM_DESCS];
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,200 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sha2_file.h"
+#include "sha2.h"
+#include "pkcs.h"
+
+/*
+ * 해시 함수 종류에 관계없이 같은 방법으로 사용하는 해시 상태이다.
+ */
+typedef struct {
+    const sha2_desc *hd;
+    sha2_ctx ctx;
+} hash_t;
+
+static void hash_init(hash_t *h, int ndx)
+{
+    h->hd = &sha2_descs[ndx];
+    h->hd->init(&h->ctx);
+}
+
+static void hash_update(hash_t *h, const unsigned char *p, size_t len)
+{
+    h->hd->update(&h->ctx, p, len);
+}
+
+static void hash_final(hash_t *h, unsigned char *digest)
+{
+    h->hd->final(&h->ctx, digest);
+    memset(h, 0, sizeof(*h));
+}
+
+/* hash_mmap() - 매핑된 파일을 SHA2_FILE_WINDOW 단위로 해시한다.
+   현재 구간을 해시하는 동안 커널이 다음 구간을 읽어 오도록 MADV_WILLNEED를 미리 알린다.
+*/
+static void hash_mmap(hash_t *h, const unsigned char *p, size_t size)
+{
+    size_t off, n;
+
+    madvise((void *)p, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    // 페이지 캐시가 큰 페이지를 지원하지 않는 파일 시스템에서는 무시된다.
+    madvise((void *)p, size, MADV_HUGEPAGE);
+#endif
+    for (off = 0; off < size; off += n) {
+        n = size - off < SHA2_FILE_WINDOW ? size - off : SHA2_FILE_WINDOW;
+        if (off + n < size) {
+            size_t next = size - off - n < SHA2_FILE_WINDOW ? size - off - n : SHA2_FILE_WINDOW;
+            madvise((void *)(p + off + n), next, MADV_WILLNEED);
+        }
+        hash_update(h, p + off, n);
+    }
+}
+
+/*
+ * 매핑할 수 없는 입력을 읽는 스레드와 해시하는 호출자가 함께 사용하는 버퍼 두 개이다.
+ * 읽기 스레드는 buf[0], buf[1]을 번갈아 채우고 full을 1로 바꾸며, 호출자는 해시를 마친 버퍼의 full을 0으로 바꾼다.
+ * 입력 끝은 n이 0, 읽기 오류는 n이 -1인 버퍼로 알린다.
+ */
+typedef struct {
+    int fd;
+    unsigned char *buf[2];
+    ssize_t n[2];
+    int full[2];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} reader_t;
+
+// 버퍼 하나를 가능한 한 가득 채운다. 파이프는 한 번에 조금씩만 읽히므로 끝이나 오류가 날 때까지 반복한다.
+static ssize_t fill(int fd, unsigned char *buf, size_t size)
+{
+    size_t got = 0;
+    ssize_t r;
+
+    while (got < size) {
+        r = read(fd, buf + got, size - got);
+        if (r == 0)
+            break;
+        if (r < 0)
+            return -1;
+        got += r;
+    }
+    return got;
+}
+
+static void *reader(void *arg)
+{
+    reader_t *rd = arg;
+    ssize_t n;
+    int k;
+
+    for (k = 0; ; k ^= 1) {
+        pthread_mutex_lock(&rd->lock);
+        while (rd->full[k])
+            pthread_cond_wait(&rd->cond, &rd->lock);
+        pthread_mutex_unlock(&rd->lock);
+        n = fill(rd->fd, rd->buf[k], SHA2_FILE_BUFSIZE);
+        pthread_mutex_lock(&rd->lock);
+        rd->n[k] = n;
+        rd->full[k] = 1;
+        pthread_cond_signal(&rd->cond);
+        pthread_mutex_unlock(&rd->lock);
+        if (n <= 0)
+            break;
+    }
+    return NULL;
+}
+
+/* hash_stream() - 읽기 스레드가 다음 버퍼를 채우는 동안 이미 채워진 버퍼를 해시한다.
+   스레드를 만들 수 없으면 한 스레드에서 읽기와 해시를 번갈아 수행한다.
+*/
+static int hash_stream(hash_t *h, int fd)
+{
+    reader_t rd;
+    pthread_t thread;
+    ssize_t n;
+    int k, result = 0;
+
+    memset(&rd, 0, sizeof(rd));
+    rd.fd = fd;
+    if ((rd.buf[0] = malloc(2 * (size_t)SHA2_FILE_BUFSIZE)) == NULL)
+        return SHA2_FILE_NO_MEMORY;
+    rd.buf[1] = rd.buf[0] + SHA2_FILE_BUFSIZE;
+    // 읽기 스레드는 시작하자마자 잠금을 사용하므로 스레드를 만들기 전에 초기화한다.
+    pthread_mutex_init(&rd.lock, NULL);
+    pthread_cond_init(&rd.cond, NULL);
+    if (pthread_create(&thread, NULL, reader, &rd) != 0) {
+        pthread_mutex_destroy(&rd.lock);
+        pthread_cond_destroy(&rd.cond);
+        while ((n = fill(fd, rd.buf[0], SHA2_FILE_BUFSIZE)) > 0)
+            hash_update(h, rd.buf[0], n);
+        free(rd.buf[0]);
+        return n < 0 ? SHA2_FILE_READ_FAIL : 0;
+    }
+    for (k = 0; ; k ^= 1) {
+        pthread_mutex_lock(&rd.lock);
+        while (!rd.full[k])
+            pthread_cond_wait(&rd.cond, &rd.lock);
+        n = rd.n[k];
+        pthread_mutex_unlock(&rd.lock);
+        if (n <= 0) {
+            result = n < 0 ? SHA2_FILE_READ_FAIL : 0;
+            break;
+        }
+        hash_update(h, rd.buf[k], n);
+        pthread_mutex_lock(&rd.lock);
+        rd.full[k] = 0;
+        pthread_cond_signal(&rd.cond);
+        pthread_mutex_unlock(&rd.lock);
+    }
+    pthread_join(thread, NULL);
+    pthread_mutex_destroy(&rd.lock);
+    pthread_cond_destroy(&rd.cond);
+    free(rd.buf[0]);
+    return result;
+}
+
+int sha2_file(const char *path, int sha2_ndx, unsigned char *digest)
+{
+    struct stat st;
+    hash_t h;
+    void *p;
+    int fd, result = 0;
+
+    if (path == NULL || digest == NULL || sha2_ndx < SHA224 || sha2_ndx > SHA512_256)
+        return SHA2_FILE_INVALID_ARG;
+    if (strcmp(path, "-") == 0)
+        fd = STDIN_FILENO;
+    else if ((fd = open(path, O_RDONLY)) < 0)
+        return SHA2_FILE_OPEN_FAIL;
+    hash_init(&h, sha2_ndx);
+    // 크기를 알 수 있는 일반 파일만 매핑한다. 크기가 0으로 보이는 /proc 파일 등은 읽어서 처리한다.
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0
+        && (uint64_t)st.st_size <= SIZE_MAX
+        && (p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED) {
+        hash_mmap(&h, p, st.st_size);
+        munmap(p, st.st_size);
+    }
+    else
+        result = hash_stream(&h, fd);
+    if (fd != STDIN_FILENO)
+        close(fd);
+    if (result == 0)
+        hash_final(&h, digest);
+    else
+        memset(&h, 0, sizeof(h));
+    return result;
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _SHA2_FILE_H_
+#define _SHA2_FILE_H_
+
+/*
+ * 파일 해시
+ *
+ * 일반 파일은 mmap으로 매핑하여 커널에 순차 접근(MADV_SEQUENTIAL)과 큰 페이지(MADV_HUGEPAGE)를 알리고,
+ * SHA2_FILE_WINDOW 단위로 다음 구간을 미리 읽게(MADV_WILLNEED) 하면서 매핑된 메모리를 그대로 해시한다.
+ * 파이프처럼 매핑할 수 없는 입력은 읽기 스레드가 버퍼 두 개를 번갈아 채우는 동안 다른 버퍼를 해시하므로
+ * 읽기와 해시가 겹쳐서 진행된다. path가 "-"이면 표준 입력을 해시한다.
+ */
+#define SHA2_FILE_WINDOW (8 << 20)   /* mmap 미리 읽기 단위(바이트) */
+#define SHA2_FILE_BUFSIZE (1 << 20)  /* 매핑할 수 없는 입력의 버퍼 하나의 크기(바이트) */
+
+/*
+ * 오류 코드 목록이다. 오류가 없으면 0을 사용한다.
+ */
+#define SHA2_FILE_INVALID_ARG 1
+#define SHA2_FILE_OPEN_FAIL   2
+#define SHA2_FILE_READ_FAIL   3
+#define SHA2_FILE_NO_MEMORY   4
+
+/*
+ * sha2_file() - path 파일을 sha2_ndx(pkcs.h의 SHA224 ~ SHA512_256) 해시 함수로 해시하여 digest에 저장한다.
+ * digest에는 해시 함수의 출력 길이만큼 쓰인다. 성공하면 0, 그렇지 않으면 오류 코드를 넘겨준다.
+ */
+int sha2_file(const char *path, int sha2_ndx, unsigned char *digest);
+
+#endif
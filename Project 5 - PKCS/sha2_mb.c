@@ -0,0 +1,774 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#include <string.h>
+#include <pthread.h>
+#include "sha2_mb.h"
+
+// SHA-512 경로는 레인별 블록 주소를 64비트 색인으로 사용하므로 x86-64에서만 SIMD 경로를 사용한다.
+#if defined(__x86_64__)
+#define SHA2_MB_X86
+#include <immintrin.h>
+#endif
+
+// sha2.c에 정의된 초기값과 라운드 상수
+extern uint32 sha224_h0[8], sha256_h0[8], sha256_k[64];
+extern uint64 sha384_h0[8], sha512_h0[8], sha512_224_h0[8], sha512_256_h0[8], sha512_k[80];
+
+void sha256_transf(sha256_ctx *ctx, const unsigned char *message, size_t block_nb);
+void sha512_transf(sha512_ctx *ctx, const unsigned char *message, size_t block_nb);
+
+// 빈 레인이 대신 처리하는 블록으로 결과는 버린다.
+static const unsigned char zero_block[SHA512_BLOCK_SIZE];
+
+#ifdef SHA2_MB_X86
+#define MB_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define MB_ADD(x, y)  _mm256_add_epi32(x, y)
+#define MB_XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+
+// 32비트 워드 8개씩 8개 행을 전치한다. 전치 후 r[i]는 각 레인의 i번째 워드를 담는다.
+__attribute__((target("avx2")))
+static inline void transpose8(__m256i r[8])
+{
+    __m256i t[8], u[8];
+
+    for (int i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for (int i = 0; i < 8; i += 4) {
+        u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    for (int i = 0; i < 4; i++) {
+        r[i] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+#define MB_ROUND(a, b, c, d, e, f, g, h, j)                                               \
+{                                                                                         \
+    t1 = MB_ADD(MB_ADD(h, MB_XOR3(MB_ROTR(e, 6), MB_ROTR(e, 11), MB_ROTR(e, 25))),        \
+                MB_ADD(_mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g)), \
+                       MB_ADD(_mm256_set1_epi32(sha256_k[j]), w[j])));                    \
+    t2 = MB_ADD(MB_XOR3(MB_ROTR(a, 2), MB_ROTR(a, 13), MB_ROTR(a, 22)),                   \
+                _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)))); \
+    d = MB_ADD(d, t1);                                                                    \
+    h = MB_ADD(t1, t2);                                                                   \
+}
+
+/*
+ * 8개 레인의 블록을 하나씩 압축한다. blk[l]은 레인 l이 처리할 64바이트 블록이다.
+ * 메시지 스케줄 64워드를 먼저 모두 만든 후 라운드를 수행한다.
+ */
+__attribute__((target("avx2")))
+static void sha256_x8_avx2(uint32 h[8][SHA256_MB_LANES], const unsigned char *const blk[SHA256_MB_LANES])
+{
+    const __m256i bswap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                          12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    __m256i w[64], r[8], a, b, c, d, e, f, g, hh, t1, t2, s0, s1;
+
+    for (int half = 0; half < 2; half++) {
+        for (int l = 0; l < 8; l++)
+            r[l] = _mm256_loadu_si256((const __m256i *)(blk[l] + half * 32));
+        transpose8(r);
+        for (int i = 0; i < 8; i++)
+            w[half * 8 + i] = _mm256_shuffle_epi8(r[i], bswap);
+    }
+    for (int j = 16; j < 64; j++) {
+        s0 = MB_XOR3(MB_ROTR(w[j - 15], 7), MB_ROTR(w[j - 15], 18), _mm256_srli_epi32(w[j - 15], 3));
+        s1 = MB_XOR3(MB_ROTR(w[j - 2], 17), MB_ROTR(w[j - 2], 19), _mm256_srli_epi32(w[j - 2], 10));
+        w[j] = MB_ADD(MB_ADD(s1, w[j - 7]), MB_ADD(s0, w[j - 16]));
+    }
+    a = _mm256_loadu_si256((const __m256i *)h[0]);
+    b = _mm256_loadu_si256((const __m256i *)h[1]);
+    c = _mm256_loadu_si256((const __m256i *)h[2]);
+    d = _mm256_loadu_si256((const __m256i *)h[3]);
+    e = _mm256_loadu_si256((const __m256i *)h[4]);
+    f = _mm256_loadu_si256((const __m256i *)h[5]);
+    g = _mm256_loadu_si256((const __m256i *)h[6]);
+    hh = _mm256_loadu_si256((const __m256i *)h[7]);
+    for (int j = 0; j < 64; j += 8) {
+        MB_ROUND(a, b, c, d, e, f, g, hh, j);
+        MB_ROUND(hh, a, b, c, d, e, f, g, j + 1);
+        MB_ROUND(g, hh, a, b, c, d, e, f, j + 2);
+        MB_ROUND(f, g, hh, a, b, c, d, e, j + 3);
+        MB_ROUND(e, f, g, hh, a, b, c, d, j + 4);
+        MB_ROUND(d, e, f, g, hh, a, b, c, j + 5);
+        MB_ROUND(c, d, e, f, g, hh, a, b, j + 6);
+        MB_ROUND(b, c, d, e, f, g, hh, a, j + 7);
+    }
+    _mm256_storeu_si256((__m256i *)h[0], MB_ADD(a, _mm256_loadu_si256((const __m256i *)h[0])));
+    _mm256_storeu_si256((__m256i *)h[1], MB_ADD(b, _mm256_loadu_si256((const __m256i *)h[1])));
+    _mm256_storeu_si256((__m256i *)h[2], MB_ADD(c, _mm256_loadu_si256((const __m256i *)h[2])));
+    _mm256_storeu_si256((__m256i *)h[3], MB_ADD(d, _mm256_loadu_si256((const __m256i *)h[3])));
+    _mm256_storeu_si256((__m256i *)h[4], MB_ADD(e, _mm256_loadu_si256((const __m256i *)h[4])));
+    _mm256_storeu_si256((__m256i *)h[5], MB_ADD(f, _mm256_loadu_si256((const __m256i *)h[5])));
+    _mm256_storeu_si256((__m256i *)h[6], MB_ADD(g, _mm256_loadu_si256((const __m256i *)h[6])));
+    _mm256_storeu_si256((__m256i *)h[7], MB_ADD(hh, _mm256_loadu_si256((const __m256i *)h[7])));
+    _mm256_zeroupper();
+}
+
+/*
+ * SHA-512 레인 처리. 64비트 워드를 레인마다 하나씩 담으며, 블록 워드는 레인별 주소를 색인으로 하는
+ * gather 명령어로 바로 모은다. AVX-512는 회전 명령어가 있으므로 시프트 두 번과 OR이 필요 없다.
+ */
+#define MB4_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+#define MB4_ADD(x, y)  _mm256_add_epi64(x, y)
+#define MB4_XOR3(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+
+#define MB4_ROUND(a, b, c, d, e, f, g, h, j)                                              \
+{                                                                                         \
+    t1 = MB4_ADD(MB4_ADD(h, MB4_XOR3(MB4_ROTR(e, 14), MB4_ROTR(e, 18), MB4_ROTR(e, 41))), \
+                 MB4_ADD(_mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g)), \
+                         MB4_ADD(_mm256_set1_epi64x(sha512_k[j]), w[j])));                \
+    t2 = MB4_ADD(MB4_XOR3(MB4_ROTR(a, 28), MB4_ROTR(a, 34), MB4_ROTR(a, 39)),             \
+                 _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)))); \
+    d = MB4_ADD(d, t1);                                                                   \
+    h = MB4_ADD(t1, t2);                                                                  \
+}
+
+// 앞 4개 레인의 블록을 하나씩 압축한다. h[i]의 앞 4개 워드만 사용한다.
+__attribute__((target("avx2")))
+static void sha512_x4_avx2(uint64 h[8][SHA512_MB_LANES], const unsigned char *const blk[SHA512_MB_LANES])
+{
+    const __m256i bswap = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                                          8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i addr = _mm256_set_epi64x((long long)blk[3], (long long)blk[2], (long long)blk[1], (long long)blk[0]);
+    __m256i w[80], v[8], t1, t2, s0, s1;
+
+    for (int j = 0; j < 16; j++)
+        w[j] = _mm256_shuffle_epi8(_mm256_i64gather_epi64(NULL, _mm256_add_epi64(addr, _mm256_set1_epi64x(8 * j)), 1),
+                                   bswap);
+    for (int j = 16; j < 80; j++) {
+        s0 = MB4_XOR3(MB4_ROTR(w[j - 15], 1), MB4_ROTR(w[j - 15], 8), _mm256_srli_epi64(w[j - 15], 7));
+        s1 = MB4_XOR3(MB4_ROTR(w[j - 2], 19), MB4_ROTR(w[j - 2], 61), _mm256_srli_epi64(w[j - 2], 6));
+        w[j] = MB4_ADD(MB4_ADD(s1, w[j - 7]), MB4_ADD(s0, w[j - 16]));
+    }
+    for (int i = 0; i < 8; i++)
+        v[i] = _mm256_loadu_si256((const __m256i *)h[i]);
+    for (int j = 0; j < 80; j += 8) {
+        MB4_ROUND(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], j);
+        MB4_ROUND(v[7], v[0], v[1], v[2], v[3], v[4], v[5], v[6], j + 1);
+        MB4_ROUND(v[6], v[7], v[0], v[1], v[2], v[3], v[4], v[5], j + 2);
+        MB4_ROUND(v[5], v[6], v[7], v[0], v[1], v[2], v[3], v[4], j + 3);
+        MB4_ROUND(v[4], v[5], v[6], v[7], v[0], v[1], v[2], v[3], j + 4);
+        MB4_ROUND(v[3], v[4], v[5], v[6], v[7], v[0], v[1], v[2], j + 5);
+        MB4_ROUND(v[2], v[3], v[4], v[5], v[6], v[7], v[0], v[1], j + 6);
+        MB4_ROUND(v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[0], j + 7);
+    }
+    for (int i = 0; i < 8; i++)
+        _mm256_storeu_si256((__m256i *)h[i], MB4_ADD(v[i], _mm256_loadu_si256((const __m256i *)h[i])));
+    _mm256_zeroupper();
+}
+
+#define MB8_ROTR(x, n) _mm512_ror_epi64(x, n)
+#define MB8_ADD(x, y)  _mm512_add_epi64(x, y)
+#define MB8_XOR3(x, y, z) _mm512_ternarylogic_epi64(x, y, z, 0x96)
+
+#define MB8_ROUND(a, b, c, d, e, f, g, h, j)                                              \
+{                                                                                         \
+    t1 = MB8_ADD(MB8_ADD(h, MB8_XOR3(MB8_ROTR(e, 14), MB8_ROTR(e, 18), MB8_ROTR(e, 41))), \
+                 MB8_ADD(_mm512_ternarylogic_epi64(e, f, g, 0xca),                        \
+                         MB8_ADD(_mm512_set1_epi64(sha512_k[j]), w[j])));                 \
+    t2 = MB8_ADD(MB8_XOR3(MB8_ROTR(a, 28), MB8_ROTR(a, 34), MB8_ROTR(a, 39)),             \
+                 _mm512_ternarylogic_epi64(a, b, c, 0xe8));                               \
+    d = MB8_ADD(d, t1);                                                                   \
+    h = MB8_ADD(t1, t2);                                                                  \
+}
+
+// 8개 레인의 블록을 하나씩 압축한다. Ch와 Maj는 3입력 논리 명령어 하나로 계산한다.
+__attribute__((target("avx512f,avx512bw")))
+static void sha512_x8_avx512(uint64 h[8][SHA512_MB_LANES], const unsigned char *const blk[SHA512_MB_LANES])
+{
+    const __m512i bswap = _mm512_set4_epi64(0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL,
+                                            0x08090a0b0c0d0e0fULL, 0x0001020304050607ULL);
+    __m512i addr = _mm512_loadu_si512((const void *)blk);
+    __m512i w[80], v[8], t1, t2, s0, s1;
+
+    for (int j = 0; j < 16; j++)
+        w[j] = _mm512_shuffle_epi8(_mm512_i64gather_epi64(_mm512_add_epi64(addr, _mm512_set1_epi64(8 * j)), NULL, 1),
+                                   bswap);
+    for (int j = 16; j < 80; j++) {
+        s0 = MB8_XOR3(MB8_ROTR(w[j - 15], 1), MB8_ROTR(w[j - 15], 8), _mm512_srli_epi64(w[j - 15], 7));
+        s1 = MB8_XOR3(MB8_ROTR(w[j - 2], 19), MB8_ROTR(w[j - 2], 61), _mm512_srli_epi64(w[j - 2], 6));
+        w[j] = MB8_ADD(MB8_ADD(s1, w[j - 7]), MB8_ADD(s0, w[j - 16]));
+    }
+    for (int i = 0; i < 8; i++)
+        v[i] = _mm512_loadu_si512((const void *)h[i]);
+    for (int j = 0; j < 80; j += 8) {
+        MB8_ROUND(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], j);
+        MB8_ROUND(v[7], v[0], v[1], v[2], v[3], v[4], v[5], v[6], j + 1);
+        MB8_ROUND(v[6], v[7], v[0], v[1], v[2], v[3], v[4], v[5], j + 2);
+        MB8_ROUND(v[5], v[6], v[7], v[0], v[1], v[2], v[3], v[4], j + 3);
+        MB8_ROUND(v[4], v[5], v[6], v[7], v[0], v[1], v[2], v[3], j + 4);
+        MB8_ROUND(v[3], v[4], v[5], v[6], v[7], v[0], v[1], v[2], j + 5);
+        MB8_ROUND(v[2], v[3], v[4], v[5], v[6], v[7], v[0], v[1], j + 6);
+        MB8_ROUND(v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[0], j + 7);
+    }
+    for (int i = 0; i < 8; i++)
+        _mm512_storeu_si512((void *)h[i], MB8_ADD(v[i], _mm512_loadu_si512((const void *)h[i])));
+    _mm256_zeroupper();
+}
+#endif
+
+// sha512_simd는 SHA-512 SIMD 경로가 함께 처리하는 레인 수이며 0이면 SIMD 경로를 사용하지 않는다.
+static int use_avx2, sha512_simd;
+
+// 프로그램이 시작될 때 사용할 구현을 정한다. SHA 확장 명령어가 있으면 레인마다 sha256_transf()로
+// 처리하는 편이 AVX2 8레인보다 빠르므로 SHA-256의 AVX2 경로는 SHA 확장 명령어가 없을 때만 사용한다.
+__attribute__((constructor))
+static void sha2_mb_cpu_init(void)
+{
+#ifdef SHA2_MB_X86
+    __builtin_cpu_init();
+    use_avx2 = __builtin_cpu_supports("avx2") && !__builtin_cpu_supports("sha");
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        sha512_simd = 8;
+    else if (__builtin_cpu_supports("avx2"))
+        sha512_simd = 4;
+#endif
+}
+
+/*
+ * sha2_mb_set_backend() - 다중 버퍼 엔진의 레인 구현을 SHA2_MB_BACKEND_* 중 하나로 바꾼다. SHA 확장 명령어가
+ * 있어도 AVX2 8레인 커널을 시험하거나 구현별 성능을 비교할 때 사용한다. CPU가 지원하지 않는 구현이면 바꾸지
+ * 않고 -1을, 바꾸면 0을 넘겨준다. 스레드에 안전하지 않으므로 엔진을 사용하는 스레드가 없을 때 부르고,
+ * sha512_mb_init()은 레인 수를 정하므로 바꾼 뒤에 다시 불러야 한다.
+ */
+int sha2_mb_set_backend(int backend)
+{
+    switch (backend) {
+    case SHA2_MB_BACKEND_AUTO:
+        use_avx2 = 0;
+        sha512_simd = 0;
+        sha2_mb_cpu_init();
+        return 0;
+    case SHA2_MB_BACKEND_SCALAR:
+        use_avx2 = 0;
+        sha512_simd = 0;
+        return 0;
+#ifdef SHA2_MB_X86
+    case SHA2_MB_BACKEND_AVX2:
+        if (!__builtin_cpu_supports("avx2"))
+            return -1;
+        use_avx2 = 1;
+        sha512_simd = 4;
+        return 0;
+    case SHA2_MB_BACKEND_AVX512:
+        if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("avx512f")
+            || !__builtin_cpu_supports("avx512bw"))
+            return -1;
+        use_avx2 = 1;
+        sha512_simd = 8;
+        return 0;
+#endif
+    default:
+        return -1;
+    }
+}
+
+// 지금 선택된 레인 구현의 이름이다. "scalar"는 레인마다 sha256_transf(), sha512_transf()를 부르는 경로이다.
+const char *sha256_mb_backend_name(void)
+{
+    return use_avx2 ? "avx2-x8" : "scalar";
+}
+
+const char *sha512_mb_backend_name(void)
+{
+    return sha512_simd == 8 ? "avx512-x8" : sha512_simd == 4 ? "avx2-x4" : "scalar";
+}
+
+// 조각 *iov의 *off 위치부터 n 바이트를 dst에 모으고 다음에 읽을 위치로 옮긴다.
+static void iov_copy(const sha2_iovec **iov, size_t *off, unsigned char *dst, size_t n)
+{
+    size_t k;
+
+    while (n > 0) {
+        if (*off == (*iov)->len) {
+            (*iov)++;
+            *off = 0;
+            continue;
+        }
+        k = (*iov)->len - *off < n ? (*iov)->len - *off : n;
+        memcpy(dst, (const unsigned char *)(*iov)->base + *off, k);
+        dst += k;
+        n -= k;
+        *off += k;
+    }
+}
+
+// 메시지의 전체 블록이 끝나면 패딩 블록으로 넘어간다. 조각으로 나뉜 메시지는 남은 바이트를 이때 모은다.
+static void lane_tail(sha2_mb_lane *ln, size_t bs)
+{
+    if (ln->iov != NULL)
+        iov_copy(&ln->iov, &ln->off, ln->tail, ln->job->len % bs);
+    ln->p = ln->tail;
+    ln->nblk = ln->tail_nb;
+    ln->in_tail = 1;
+}
+
+/*
+ * job을 레인에 배정한다. 마지막 블록은 남은 메시지 뒤에 0x80과 0을 채우고 끝 len_size 바이트에
+ * 비트 길이를 빅 엔디안으로 넣어 만든다. 전체 블록은 메시지에서 바로 읽는다.
+ */
+static void lane_start(sha2_mb_lane *ln, sha2_mb_job *job, size_t bs, int len_size)
+{
+    size_t rem = job->len % bs;
+    uint64 bits = (uint64)job->len << 3;
+    int i;
+
+    ln->job = job;
+    ln->tail_nb = rem + 1 + len_size > bs ? 2 : 1;
+    memset(ln->tail, 0, sizeof(ln->tail));
+    ln->iov = job->message == NULL ? job->iov : NULL;
+    ln->off = 0;
+    if (ln->iov == NULL)
+        memcpy(ln->tail, job->message + job->len - rem, rem);
+    ln->tail[rem] = 0x80;
+    for (i = 1; i <= 8; i++, bits >>= 8)
+        ln->tail[ln->tail_nb * bs - i] = bits & 0xFF;
+    // size_t 길이의 비트 수는 64비트를 넘을 수 있으므로 넘친 부분을 그 앞 바이트에 넣는다.
+    if (len_size > 8)
+        ln->tail[ln->tail_nb * bs - 9] = (uint64)job->len >> 61;
+    ln->p = job->message;
+    ln->nblk = job->len / bs;
+    ln->in_tail = 0;
+    if (ln->nblk == 0)
+        lane_tail(ln, bs);
+}
+
+// 레인이 다음에 처리할 블록을 넘겨주고 한 블록 전진한다. 메시지의 전체 블록이 끝나면 패딩 블록으로 넘어간다.
+// 조각으로 나뉜 메시지는 블록이 조각 하나 안에 있으면 그대로 읽고, 조각 경계에 걸치면 gather에 모은다.
+static const unsigned char *lane_next(sha2_mb_lane *ln, size_t bs)
+{
+    const unsigned char *p = ln->p;
+
+    if (ln->iov != NULL && !ln->in_tail) {
+        while (ln->off == ln->iov->len) {
+            ln->iov++;
+            ln->off = 0;
+        }
+        if (ln->iov->len - ln->off >= bs) {
+            p = (const unsigned char *)ln->iov->base + ln->off;
+            ln->off += bs;
+        }
+        else {
+            iov_copy(&ln->iov, &ln->off, ln->gather, bs);
+            p = ln->gather;
+        }
+    }
+    else
+        ln->p += bs;
+    if (--ln->nblk == 0 && !ln->in_tail)
+        lane_tail(ln, bs);
+    return p;
+}
+
+static size_t lane_remaining(const sha2_mb_lane *ln)
+{
+    return ln->nblk + (ln->in_tail ? 0 : ln->tail_nb);
+}
+
+// 작업 중인 레인 가운데 가장 적게 남은 블록 수를 넘겨준다.
+static size_t lanes_min(const sha2_mb_lane *lane, int nlanes)
+{
+    size_t steps = (size_t)-1, r;
+
+    for (int l = 0; l < nlanes; l++)
+        if (lane[l].job != NULL && (r = lane_remaining(&lane[l])) < steps)
+            steps = r;
+    return steps;
+}
+
+/*
+ * 작업 중인 레인 가운데 남은 블록이 가장 적은 레인이 끝날 때까지 모든 레인을 함께 처리하고,
+ * 끝난 작업의 해시 값을 저장한 후 완료 목록에 넣는다.
+ */
+static void sha256_mb_run(sha256_mb_mgr *mgr)
+{
+    size_t steps = lanes_min(mgr->lane, SHA256_MB_LANES);
+    int l, i;
+
+#ifdef SHA2_MB_X86
+    if (use_avx2) {
+        const unsigned char *blk[SHA256_MB_LANES];
+        for (size_t s = 0; s < steps; s++) {
+            for (l = 0; l < SHA256_MB_LANES; l++)
+                blk[l] = mgr->lane[l].job != NULL ? lane_next(&mgr->lane[l], SHA256_BLOCK_SIZE) : zero_block;
+            sha256_x8_avx2(mgr->h, blk);
+        }
+    } else
+#endif
+    {
+        sha256_ctx ctx;
+        for (l = 0; l < SHA256_MB_LANES; l++) {
+            if (mgr->lane[l].job == NULL)
+                continue;
+            for (i = 0; i < 8; i++)
+                ctx.h[i] = mgr->h[i][l];
+            for (size_t s = 0; s < steps; s++)
+                sha256_transf(&ctx, lane_next(&mgr->lane[l], SHA256_BLOCK_SIZE), 1);
+            for (i = 0; i < 8; i++)
+                mgr->h[i][l] = ctx.h[i];
+        }
+    }
+    for (l = 0; l < SHA256_MB_LANES; l++) {
+        sha2_mb_job *job = mgr->lane[l].job;
+        if (job == NULL || lane_remaining(&mgr->lane[l]) != 0)
+            continue;
+        int words = job->type == SHA2_MB_SHA224 ? SHA224_DIGEST_SIZE / 4 : SHA256_DIGEST_SIZE / 4;
+        for (i = 0; i < words; i++) {
+            job->digest[4 * i] = mgr->h[i][l] >> 24;
+            job->digest[4 * i + 1] = mgr->h[i][l] >> 16;
+            job->digest[4 * i + 2] = mgr->h[i][l] >> 8;
+            job->digest[4 * i + 3] = mgr->h[i][l];
+        }
+        mgr->lane[l].job = NULL;
+        mgr->nactive--;
+        mgr->done[mgr->ndone++] = job;
+    }
+}
+
+void sha256_mb_init(sha256_mb_mgr *mgr)
+{
+    memset(mgr, 0, sizeof(*mgr));
+}
+
+/*
+ * sha256_mb_submit() - job을 빈 레인에 배정한다. 레인이 모두 차면 작업 하나가 끝날 때까지 처리한다.
+ * 완료된 작업이 있으면 그중 하나를 넘겨주고, 없으면 NULL을 넘겨준다.
+ */
+sha2_mb_job *sha256_mb_submit(sha256_mb_mgr *mgr, sha2_mb_job *job)
+{
+    const uint32 *iv = job->type == SHA2_MB_SHA224 ? sha224_h0 : sha256_h0;
+    int l, i;
+
+    for (l = 0; mgr->lane[l].job != NULL; l++)
+        ;
+    for (i = 0; i < 8; i++)
+        mgr->h[i][l] = iv[i];
+    lane_start(&mgr->lane[l], job, SHA256_BLOCK_SIZE, 8);
+    // 다음 작업이 들어갈 자리가 항상 있도록 레인이 모두 차면 바로 처리한다.
+    if (++mgr->nactive == SHA256_MB_LANES)
+        sha256_mb_run(mgr);
+    return mgr->ndone > 0 ? mgr->done[--mgr->ndone] : NULL;
+}
+
+/*
+ * sha256_mb_flush() - 빈 레인이 있어도 처리를 진행하여 완료된 작업 하나를 넘겨준다.
+ * 남은 작업이 없으면 NULL을 넘겨준다.
+ */
+sha2_mb_job *sha256_mb_flush(sha256_mb_mgr *mgr)
+{
+    if (mgr->ndone == 0 && mgr->nactive > 0)
+        sha256_mb_run(mgr);
+    return mgr->ndone > 0 ? mgr->done[--mgr->ndone] : NULL;
+}
+
+/*
+ * sha256_mb_transf() - 레인 l의 상태 h[.][l]에서 blk[l] 블록 하나를 압축한다. blk[l]이 NULL인 레인은 건너뛴다.
+ * 작업 관리자와 달리 레인마다 시작 상태를 호출자가 정하므로 HMAC 중간 상태에서 이어서 해시할 때 사용한다.
+ */
+void sha256_mb_transf(uint32 h[8][SHA256_MB_LANES], const unsigned char *const blk[SHA256_MB_LANES])
+{
+    sha256_ctx ctx;
+    int l, i;
+
+#ifdef SHA2_MB_X86
+    if (use_avx2) {
+        const unsigned char *b[SHA256_MB_LANES];
+        uint32 keep[8][SHA256_MB_LANES];
+        // 커널은 모든 레인을 압축하므로 빈 레인에는 zero_block을 넣고 끝난 뒤 원래 상태로 되돌린다.
+        memcpy(keep, h, sizeof(keep));
+        for (l = 0; l < SHA256_MB_LANES; l++)
+            b[l] = blk[l] != NULL ? blk[l] : zero_block;
+        sha256_x8_avx2(h, b);
+        for (l = 0; l < SHA256_MB_LANES; l++)
+            if (blk[l] == NULL)
+                for (i = 0; i < 8; i++)
+                    h[i][l] = keep[i][l];
+        return;
+    }
+#endif
+    for (l = 0; l < SHA256_MB_LANES; l++) {
+        if (blk[l] == NULL)
+            continue;
+        for (i = 0; i < 8; i++)
+            ctx.h[i] = h[i][l];
+        sha256_transf(&ctx, blk[l], 1);
+        for (i = 0; i < 8; i++)
+            h[i][l] = ctx.h[i];
+    }
+}
+
+// SHA-512 계열은 초기값과 해시 값의 길이만 다르다.
+static const uint64 *sha512_iv(int type, int *digest_size)
+{
+    switch (type) {
+    case SHA2_MB_SHA384:
+        *digest_size = SHA384_DIGEST_SIZE;
+        return sha384_h0;
+    case SHA2_MB_SHA512_224:
+        *digest_size = SHA224_DIGEST_SIZE;
+        return sha512_224_h0;
+    case SHA2_MB_SHA512_256:
+        *digest_size = SHA256_DIGEST_SIZE;
+        return sha512_256_h0;
+    default:
+        *digest_size = SHA512_DIGEST_SIZE;
+        return sha512_h0;
+    }
+}
+
+static void sha512_mb_run(sha512_mb_mgr *mgr)
+{
+    size_t steps = lanes_min(mgr->lane, mgr->nlanes);
+    int l, i, size;
+
+#ifdef SHA2_MB_X86
+    if (sha512_simd) {
+        const unsigned char *blk[SHA512_MB_LANES];
+        for (size_t s = 0; s < steps; s++) {
+            for (l = 0; l < mgr->nlanes; l++)
+                blk[l] = mgr->lane[l].job != NULL ? lane_next(&mgr->lane[l], SHA512_BLOCK_SIZE) : zero_block;
+            if (sha512_simd == 8)
+                sha512_x8_avx512(mgr->h, blk);
+            else
+                sha512_x4_avx2(mgr->h, blk);
+        }
+    } else
+#endif
+    {
+        sha512_ctx ctx;
+        for (l = 0; l < mgr->nlanes; l++) {
+            if (mgr->lane[l].job == NULL)
+                continue;
+            for (i = 0; i < 8; i++)
+                ctx.h[i] = mgr->h[i][l];
+            for (size_t s = 0; s < steps; s++)
+                sha512_transf(&ctx, lane_next(&mgr->lane[l], SHA512_BLOCK_SIZE), 1);
+            for (i = 0; i < 8; i++)
+                mgr->h[i][l] = ctx.h[i];
+        }
+    }
+    for (l = 0; l < mgr->nlanes; l++) {
+        sha2_mb_job *job = mgr->lane[l].job;
+        if (job == NULL || lane_remaining(&mgr->lane[l]) != 0)
+            continue;
+        sha512_iv(job->type, &size);
+        for (i = 0; i < size; i++)
+            job->digest[i] = mgr->h[i / 8][l] >> (56 - 8 * (i % 8));
+        mgr->lane[l].job = NULL;
+        mgr->nactive--;
+        mgr->done[mgr->ndone++] = job;
+    }
+}
+
+void sha512_mb_init(sha512_mb_mgr *mgr)
+{
+    memset(mgr, 0, sizeof(*mgr));
+    mgr->nlanes = sha512_simd ? sha512_simd : SHA512_MB_LANES;
+}
+
+/*
+ * sha512_mb_submit() - SHA-384/512/512_224/512_256 작업을 빈 레인에 배정한다.
+ * 사용법은 sha256_mb_submit()과 같다.
+ */
+sha2_mb_job *sha512_mb_submit(sha512_mb_mgr *mgr, sha2_mb_job *job)
+{
+    int l, i, size;
+    const uint64 *iv = sha512_iv(job->type, &size);
+
+    for (l = 0; mgr->lane[l].job != NULL; l++)
+        ;
+    for (i = 0; i < 8; i++)
+        mgr->h[i][l] = iv[i];
+    lane_start(&mgr->lane[l], job, SHA512_BLOCK_SIZE, 16);
+    if (++mgr->nactive == mgr->nlanes)
+        sha512_mb_run(mgr);
+    return mgr->ndone > 0 ? mgr->done[--mgr->ndone] : NULL;
+}
+
+sha2_mb_job *sha512_mb_flush(sha512_mb_mgr *mgr)
+{
+    if (mgr->ndone == 0 && mgr->nactive > 0)
+        sha512_mb_run(mgr);
+    return mgr->ndone > 0 ? mgr->done[--mgr->ndone] : NULL;
+}
+
+/*
+ * sha512_mb_transf() - sha256_mb_transf()와 같으며 항상 SHA512_MB_LANES개의 레인을 받는다.
+ * AVX2에서는 4레인씩 두 번에 나누어 처리한다.
+ */
+void sha512_mb_transf(uint64 h[8][SHA512_MB_LANES], const unsigned char *const blk[SHA512_MB_LANES])
+{
+    sha512_ctx ctx;
+    int l, i;
+
+#ifdef SHA2_MB_X86
+    if (sha512_simd) {
+        const unsigned char *b[SHA512_MB_LANES], *bhi[SHA512_MB_LANES];
+        uint64 hi[8][SHA512_MB_LANES], keep[8][SHA512_MB_LANES];
+        // sha256_mb_transf()와 같이 빈 레인의 상태는 커널을 부른 뒤 되돌린다.
+        memcpy(keep, h, sizeof(keep));
+        for (l = 0; l < SHA512_MB_LANES; l++)
+            b[l] = blk[l] != NULL ? blk[l] : zero_block;
+        if (sha512_simd == 8)
+            sha512_x8_avx512(h, b);
+        else {
+            sha512_x4_avx2(h, b);
+            // 커널은 앞 4레인만 처리하므로 뒤 4레인을 앞으로 옮겨서 처리한다.
+            if (blk[4] != NULL || blk[5] != NULL || blk[6] != NULL || blk[7] != NULL) {
+                for (l = 0; l < SHA512_MB_LANES; l++)
+                    bhi[l] = b[(l + 4) % SHA512_MB_LANES];
+                for (i = 0; i < 8; i++)
+                    memcpy(hi[i], &h[i][4], 4 * sizeof(uint64));
+                sha512_x4_avx2(hi, bhi);
+                for (i = 0; i < 8; i++)
+                    memcpy(&h[i][4], hi[i], 4 * sizeof(uint64));
+            }
+        }
+        for (l = 0; l < SHA512_MB_LANES; l++)
+            if (blk[l] == NULL)
+                for (i = 0; i < 8; i++)
+                    h[i][l] = keep[i][l];
+        return;
+    }
+#endif
+    for (l = 0; l < SHA512_MB_LANES; l++) {
+        if (blk[l] == NULL)
+            continue;
+        for (i = 0; i < 8; i++)
+            ctx.h[i] = h[i][l];
+        sha512_transf(&ctx, blk[l], 1);
+        for (i = 0; i < 8; i++)
+            h[i][l] = ctx.h[i];
+    }
+}
+
+/*
+ * sha2_hash_many()와 sha2_hash_many_iov()의 공통 부분이다. msgs가 NULL이면 iovs[i]의 iovcnt[i]개 조각을
+ * 이어 붙인 메시지를 해시한다. SHA2_MB_* 값은 sha2_descs의 순서와 같다.
+ */
+static void hash_many(int sha2_ndx, const unsigned char *const msgs[], const size_t lens[],
+                      const sha2_iovec *const iovs[], const int iovcnt[], size_t n, unsigned char *const digests[])
+{
+    const int is256 = sha2_ndx == SHA2_MB_SHA224 || sha2_ndx == SHA2_MB_SHA256;
+    const size_t bs = is256 ? SHA256_BLOCK_SIZE : SHA512_BLOCK_SIZE;
+    const size_t len_size = is256 ? 9 : 17;   /* 0x80과 길이 필드 */
+    const sha2_desc *hd = &sha2_descs[sha2_ndx];
+    sha2_mb_job job[SHA2_MANY_WINDOW];
+    size_t cls[SHA2_MANY_WINDOW];
+    int order[SHA2_MANY_WINDOW];
+    sha256_mb_mgr mgr256;
+    sha512_mb_mgr mgr512;
+    size_t base, k;
+    int m, i, j, t;
+
+#ifdef SHA2_MB_X86
+    if (is256 ? !use_avx2 : !sha512_simd)
+#endif
+    {
+        for (k = 0; k < n; k++) {
+            if (msgs != NULL)
+                hd->hash(msgs[k], lens[k], digests[k]);
+            else
+                hd->hash_iov(iovs[k], iovcnt[k], digests[k]);
+        }
+        return;
+    }
+    if (is256)
+        sha256_mb_init(&mgr256);
+    else
+        sha512_mb_init(&mgr512);
+    for (base = 0; base < n; base += m) {
+        m = n - base < SHA2_MANY_WINDOW ? (int)(n - base) : SHA2_MANY_WINDOW;
+        // 블록 수 순으로 삽입 정렬한다. 창이 작으므로 충분하다.
+        for (i = 0; i < m; i++) {
+            k = base + i;
+            // job은 초기화하지 않은 지역 배열이므로 사용하지 않는 필드도 모두 채운다.
+            if (msgs != NULL) {
+                job[i].message = msgs[k];
+                job[i].len = lens[k];
+                job[i].iov = NULL;
+            }
+            else {
+                job[i].message = NULL;
+                job[i].iov = iovs[k];
+                for (job[i].len = 0, t = 0; t < iovcnt[k]; t++)
+                    job[i].len += iovs[k][t].len;
+            }
+            job[i].digest = digests[k];
+            job[i].type = sha2_ndx;
+            job[i].user = NULL;
+            cls[i] = (job[i].len + len_size + bs - 1) / bs;
+            for (j = i; j > 0 && cls[order[j - 1]] > cls[i]; j--)
+                order[j] = order[j - 1];
+            order[j] = i;
+        }
+        for (t = 0; t < m; t++) {
+            if (is256)
+                sha256_mb_submit(&mgr256, &job[order[t]]);
+            else
+                sha512_mb_submit(&mgr512, &job[order[t]]);
+        }
+        // 다음 창이 job을 다시 사용하므로 남은 작업을 모두 끝낸다.
+        if (is256)
+            while (sha256_mb_flush(&mgr256) != NULL)
+                ;
+        else
+            while (sha512_mb_flush(&mgr512) != NULL)
+                ;
+    }
+}
+
+/*
+ * sha2_hash_many() - 서로 독립인 메시지 n개의 해시 값을 한꺼번에 계산한다. msgs[i]의 lens[i] 바이트를
+ * sha2_ndx(SHA2_MB_*) 함수로 해시하여 digests[i]에 저장한다. 패딩까지 포함한 블록 수가 비슷한 메시지끼리
+ * 같은 차례에 레인을 채우도록 SHA2_MANY_WINDOW개씩 블록 수 순으로 정렬하여 다중 버퍼 엔진에 넣는다.
+ * 엔진이 SIMD 레인을 사용하지 않는 경우(SHA 확장 명령어가 있는 SHA-256 등)에는 레인을 관리하는 비용만
+ * 늘어나므로 메시지마다 바로 해시한다.
+ */
+void sha2_hash_many(int sha2_ndx, const unsigned char *const msgs[], const size_t lens[], size_t n,
+                    unsigned char *const digests[])
+{
+    hash_many(sha2_ndx, msgs, lens, NULL, NULL, n, digests);
+}
+
+/*
+ * sha2_hash_many_iov() - sha2_hash_many()와 같지만 i번째 메시지는 msgs[i]의 iovcnt[i]개 조각을 차례로
+ * 이어 붙인 것이다. 조각들을 한 버퍼에 복사하지 않고 해시한다.
+ */
+void sha2_hash_many_iov(int sha2_ndx, const sha2_iovec *const msgs[], const int iovcnt[], size_t n,
+                        unsigned char *const digests[])
+{
+    hash_many(sha2_ndx, NULL, NULL, msgs, iovcnt, n, digests);
+}
+
+/*
+ * sha2_parallel() - 크기가 size 바이트인 작업 n개를 담은 배열 work의 각 원소로 fn을 실행한다.
+ * 첫 번째 작업은 호출한 스레드가, 나머지는 작업마다 스레드를 하나씩 만들어 처리한다. 스레드를 만들지 못한
+ * 작업은 호출한 스레드가 이어서 처리하므로 work는 부르기 전에 모두 채워 두어야 한다.
+ */
+void sha2_parallel(void *(*fn)(void *), void *work, size_t size, int n)
+{
+    pthread_t th[n > 1 ? n : 1];
+    unsigned char *w = work;
+    int i, k;
+
+    for (k = 1; k < n; k++)
+        if (pthread_create(&th[k], NULL, fn, w + k * size) != 0)
+            break;
+    fn(w);
+    for (i = 1; i < k; i++)
+        pthread_join(th[i], NULL);
+    for (i = k; i < n; i++)
+        fn(w + i * size);
+}
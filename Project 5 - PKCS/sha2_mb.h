@@ -0,0 +1,110 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+#ifndef _SHA2_MB_H_
+#define _SHA2_MB_H_
+
+#include <stddef.h>
+#include "sha2.h"
+
+/*
+ * 다중 버퍼 SHA-2
+ *
+ * 서로 독립인 여러 메시지를 SIMD 레지스터의 레인 하나에 하나씩 배정하여 동시에 해시한다.
+ * sha256_mb_submit()으로 작업을 넣으면 빈 레인에 배정되고, 레인이 모두 차면 가장 먼저 끝나는
+ * 작업이 완료될 때까지 모든 레인의 블록을 함께 처리한다. 더 넣을 작업이 없으면 sha256_mb_flush()를
+ * NULL을 넘겨줄 때까지 호출하여 남은 작업을 마저 처리한다. 작업은 넣은 순서와 다르게 완료될 수 있다.
+ * AVX2를 지원하지 않거나 SHA 확장 명령어를 지원하는 CPU에서는 레인마다 sha256_transf()로 차례대로 처리한다.
+ *
+ * SHA-384/512/512_224/512_256은 sha512_mb_*()를 같은 방법으로 사용한다. 64비트 레인을 사용하므로
+ * AVX-512에서는 8레인, AVX2에서는 4레인을 함께 처리하고, 둘 다 없으면 sha512_transf()로 처리한다.
+ */
+#define SHA256_MB_LANES 8
+#define SHA512_MB_LANES 8   /* 최대 레인 수, 실제로 사용하는 레인 수는 sha512_mb_mgr의 nlanes */
+#define SHA2_MANY_WINDOW 64 /* sha2_hash_many()가 한 번에 정렬하여 넣는 메시지 수 */
+
+/*
+ * 다중 버퍼 엔진의 레인 구현이다. sha2_mb_set_backend()에 넘겨준다. AVX-512 커널은 SHA-512 계열만 있으므로
+ * SHA2_MB_BACKEND_AVX512에서 SHA-256은 AVX2 8레인 커널을 사용한다.
+ */
+#define SHA2_MB_BACKEND_AUTO   0   /* CPU에 맞게 고른다 (기본값) */
+#define SHA2_MB_BACKEND_SCALAR 1   /* 레인마다 sha256_transf(), sha512_transf() */
+#define SHA2_MB_BACKEND_AVX2   2   /* SHA-256 8레인, SHA-512 4레인 AVX2 */
+#define SHA2_MB_BACKEND_AVX512 3   /* SHA-512 8레인 AVX-512 */
+
+/*
+ * 작업의 해시 함수 종류이다.
+ */
+#define SHA2_MB_SHA224     0
+#define SHA2_MB_SHA256     1
+#define SHA2_MB_SHA384     2
+#define SHA2_MB_SHA512     3
+#define SHA2_MB_SHA512_224 4
+#define SHA2_MB_SHA512_256 5
+
+/*
+ * 해시할 메시지 하나를 나타내는 작업이다. 완료될 때까지 message와 digest는 유효해야 한다.
+ * message가 NULL이면 iov의 조각들을 차례로 이어 붙인 len 바이트를 복사하지 않고 해시한다. 이때 len은
+ * 조각 길이의 합이어야 하고 iov도 완료될 때까지 유효해야 한다.
+ * user는 호출자가 완료된 작업을 식별하는 데 사용하며 엔진은 사용하지 않는다.
+ */
+typedef struct {
+    const unsigned char *message;
+    size_t len;
+    unsigned char *digest;
+    int type;
+    void *user;
+    const sha2_iovec *iov;
+} sha2_mb_job;
+
+typedef struct {
+    sha2_mb_job *job;                      /* NULL이면 빈 레인 */
+    const unsigned char *p;                /* 다음에 처리할 블록 */
+    size_t nblk;                           /* p부터 남은 블록 수 */
+    int in_tail, tail_nb;
+    unsigned char tail[2 * SHA512_BLOCK_SIZE];  /* 패딩을 포함한 마지막 블록들 */
+    const sha2_iovec *iov;                 /* 조각으로 나뉜 메시지에서 다음에 읽을 조각, 아니면 NULL */
+    size_t off;                            /* iov 안에서 다음에 읽을 위치 */
+    unsigned char gather[SHA512_BLOCK_SIZE];    /* 조각 경계에 걸친 블록을 모으는 곳 */
+} sha2_mb_lane;
+
+typedef struct {
+    uint32 h[8][SHA256_MB_LANES];          /* h[i][l]은 레인 l의 i번째 상태 워드 */
+    sha2_mb_lane lane[SHA256_MB_LANES];
+    sha2_mb_job *done[2 * SHA256_MB_LANES];  /* 완료되었지만 아직 넘겨주지 않은 작업 */
+    int nactive, ndone;
+} sha256_mb_mgr;
+
+typedef struct {
+    uint64 h[8][SHA512_MB_LANES];
+    sha2_mb_lane lane[SHA512_MB_LANES];
+    sha2_mb_job *done[2 * SHA512_MB_LANES];
+    int nlanes, nactive, ndone;
+} sha512_mb_mgr;
+
+void sha256_mb_init(sha256_mb_mgr *mgr);
+sha2_mb_job *sha256_mb_submit(sha256_mb_mgr *mgr, sha2_mb_job *job);
+sha2_mb_job *sha256_mb_flush(sha256_mb_mgr *mgr);
+
+void sha512_mb_init(sha512_mb_mgr *mgr);
+sha2_mb_job *sha512_mb_submit(sha512_mb_mgr *mgr, sha2_mb_job *job);
+sha2_mb_job *sha512_mb_flush(sha512_mb_mgr *mgr);
+
+void sha256_mb_transf(uint32 h[8][SHA256_MB_LANES], const unsigned char *const blk[SHA256_MB_LANES]);
+void sha512_mb_transf(uint64 h[8][SHA512_MB_LANES], const unsigned char *const blk[SHA512_MB_LANES]);
+
+int sha2_mb_set_backend(int backend);
+const char *sha256_mb_backend_name(void);
+const char *sha512_mb_backend_name(void);
+
+void sha2_hash_many(int sha2_ndx, const unsigned char *const msgs[], const size_t lens[], size_t n,
+                    unsigned char *const digests[]);
+void sha2_hash_many_iov(int sha2_ndx, const sha2_iovec *const msgs[], const int iovcnt[], size_t n,
+                        unsigned char *const digests[]);
+void sha2_parallel(void *(*fn)(void *), void *work, size_t size, int n);
+
+#endif
@@ -0,0 +1,214 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+
+/*
+ * sha2bench [-max 바이트] [-o 파일] [-backend auto|scalar|avx2|avx512]
+ *
+ * SHA-224/256/384/512/512_224/512_256의 처리 속도를 입력 크기(0 B ~ 1 GiB), 사용 방법(한 번에, 나누어
+ * 갱신, 여러 메시지를 한꺼번에), 압축 함수 구현별로 재고 결과를 JSON으로 출력한다. 빌드 사이의 성능 회귀를
+ * 비교할 때 사용한다. 측정은 한 번에 MIN_TIME초 이상 걸릴 때까지 반복 횟수를 늘린다.
+ * -backend는 여러 메시지를 한꺼번에 해시하는 다중 버퍼 엔진의 레인 구현을 sha2_mb_set_backend()로 고정한다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sha2.h"
+#include "sha2_mb.h"
+#include "pkcs.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_RDTSC
+#endif
+
+#define MIN_TIME     0.2         /* 측정 하나의 최소 시간(초) */
+#define STREAM_CHUNK 1000        /* 나누어 갱신할 때 한 번에 넘겨주는 바이트 수 */
+#define MANY_N       64          /* sha2_hash_many()로 한꺼번에 해시하는 메시지 수 */
+#define MANY_MAX     (64 << 10)  /* sha2_hash_many()를 재는 최대 메시지 크기 */
+
+static const size_t sizes[] = {0, 64, 256, 1 << 10, 4 << 10, 64 << 10, 1 << 20, 16 << 20, 256 << 20, 1 << 30};
+
+enum { ONESHOT, STREAM, MANY };
+static const char *mode_name[3] = {"oneshot", "stream", "many"};
+static const char *mb_backend_name[4] = {"auto", "scalar", "avx2", "avx512"};
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned long long cycles(void)
+{
+#ifdef BENCH_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// STREAM_CHUNK 바이트씩 나누어 갱신한다. 블록 경계와 맞지 않으므로 버퍼링 비용까지 잰다.
+static void stream(const sha2_desc *hd, const unsigned char *m, size_t len, unsigned char *d)
+{
+    sha2_ctx ctx;
+    size_t off, n;
+
+    hd->init(&ctx);
+    for (off = 0; off < len; off += n) {
+        n = len - off < STREAM_CHUNK ? len - off : STREAM_CHUNK;
+        hd->update(&ctx, m + off, n);
+    }
+    hd->final(&ctx, d);
+}
+
+/*
+ * measure() - ndx 함수로 len 바이트 메시지를 mode 방법으로 해시하는 시간을 잰다.
+ * 해시한 메시지 수를 *nhash, 걸린 시간과 사이클을 *sec, *cyc에 넘겨준다.
+ */
+static void measure(int ndx, int mode, const unsigned char *buf, size_t len,
+                    unsigned long *nhash, double *sec, double *cyc)
+{
+    const unsigned char *msgs[MANY_N];
+    unsigned char dg[MANY_N][SHA512_DIGEST_SIZE], *digests[MANY_N];
+    size_t lens[MANY_N];
+    unsigned long reps, r;
+    unsigned long long c0;
+    double t0;
+    int i;
+
+    for (i = 0; i < MANY_N; i++) {
+        msgs[i] = buf + (size_t)i * len;
+        lens[i] = len;
+        digests[i] = dg[i];
+    }
+    for (reps = 1; ; ) {
+        t0 = now();
+        c0 = cycles();
+        for (r = 0; r < reps; r++) {
+            if (mode == ONESHOT)
+                sha2_descs[ndx].hash(buf, len, dg[0]);
+            else if (mode == STREAM)
+                stream(&sha2_descs[ndx], buf, len, dg[0]);
+            else
+                sha2_hash_many(ndx, msgs, lens, MANY_N, digests);
+        }
+        *cyc = (double)(cycles() - c0);
+        *sec = now() - t0;
+        if (*sec >= MIN_TIME)
+            break;
+        // 지금까지 잰 시간으로 MIN_TIME을 조금 넘기는 반복 횟수를 어림한다.
+        reps = *sec < MIN_TIME / 64 ? reps * 64 : (unsigned long)(reps * 1.2 * MIN_TIME / *sec) + 1;
+    }
+    *nhash = reps * (mode == MANY ? MANY_N : 1);
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *out = stdout;
+    size_t max = (size_t)1 << 30, bufsize, len;
+    unsigned char *buf;
+    unsigned long nhash;
+    double sec, cyc;
+    int i, ndx, mode, b, first = 1, mb_backend = SHA2_MB_BACKEND_AUTO;
+    struct { int backend; const char *name256, *name512; } be[2];
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-max") == 0 && i + 1 < argc)
+            max = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            if ((out = fopen(argv[++i], "w")) == NULL) {
+                perror(argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-backend") == 0 && i + 1 < argc) {
+            for (mb_backend = 3; mb_backend >= 0 && strcmp(argv[i + 1], mb_backend_name[mb_backend]) != 0; mb_backend--)
+                ;
+            if (mb_backend < 0 || sha2_mb_set_backend(mb_backend) != 0) {
+                fprintf(stderr, "sha2bench: backend %s is not supported\n", argv[i + 1]);
+                return 1;
+            }
+            i++;
+        }
+        else {
+            fprintf(stderr, "usage: %s [-max bytes] [-o file] [-backend auto|scalar|avx2|avx512]\n", argv[0]);
+            return 1;
+        }
+    }
+    // 가장 큰 입력과, sha2_hash_many()에 넘겨줄 MANY_N개의 메시지가 모두 들어가는 버퍼를 사용한다.
+    for (bufsize = 0, i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+        if (sizes[i] <= max && sizes[i] > bufsize)
+            bufsize = sizes[i];
+    }
+    if (bufsize < (size_t)MANY_N * MANY_MAX)
+        bufsize = (size_t)MANY_N * MANY_MAX;
+    if ((buf = malloc(bufsize)) == NULL) {
+        fprintf(stderr, "sha2bench: out of memory\n");
+        return 1;
+    }
+    for (len = 0; len < bufsize; len++)
+        buf[len] = (unsigned char)(len * 131 + 7);
+
+    sha2_set_backend(SHA2_BACKEND_NATIVE);
+    be[0].backend = SHA2_BACKEND_NATIVE;
+    be[0].name256 = sha256_backend_name();
+    be[0].name512 = sha512_backend_name();
+    sha2_set_backend(SHA2_BACKEND_PORTABLE);
+    be[1].backend = SHA2_BACKEND_PORTABLE;
+    be[1].name256 = sha256_backend_name();
+    be[1].name512 = sha512_backend_name();
+
+    fprintf(out, "{\n  \"tool\": \"sha2bench\",\n  \"min_time\": %g,\n  \"stream_chunk\": %d,\n"
+                 "  \"many_n\": %d,\n  \"mb_backend\": {\"requested\": \"%s\", \"sha256\": \"%s\", \"sha512\": \"%s\"},\n"
+                 "  \"results\": [", MIN_TIME, STREAM_CHUNK, MANY_N, mb_backend_name[mb_backend],
+            sha256_mb_backend_name(), sha512_mb_backend_name());
+    for (b = 0; b < 2; b++) {
+        sha2_set_backend(be[b].backend);
+        for (ndx = SHA224; ndx <= SHA512_256; ndx++) {
+            const char *bname = ndx == SHA224 || ndx == SHA256 ? be[b].name256 : be[b].name512;
+            char mbname[32];
+            // 여러 메시지를 한꺼번에 해시한 결과는 다중 버퍼 엔진의 레인 구현 이름으로 표시한다.
+            snprintf(mbname, sizeof(mbname), "mb-%s",
+                     ndx == SHA224 || ndx == SHA256 ? sha256_mb_backend_name() : sha512_mb_backend_name());
+            // 가속 구현이 없으면 두 구현의 이름이 같으므로 한 번만 잰다.
+            if (b > 0 && strcmp(bname, ndx == SHA224 || ndx == SHA256 ? be[0].name256 : be[0].name512) == 0)
+                continue;
+            for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++) {
+                len = sizes[i];
+                if (len > max)
+                    continue;
+                for (mode = ONESHOT; mode <= MANY; mode++) {
+                    // 다중 버퍼 엔진은 -backend로 정한 레인 구현을 사용하므로 가속 구현으로 한 번만 잰다.
+                    if (mode == MANY && (b > 0 || len > MANY_MAX))
+                        continue;
+                    fprintf(stderr, "%s %s %s %zu\n", sha2_descs[ndx].name, mode == MANY ? mbname : bname,
+                            mode_name[mode], len);
+                    measure(ndx, mode, buf, len, &nhash, &sec, &cyc);
+                    fprintf(out, "%s\n    {\"hash\": \"%s\", \"backend\": \"%s\", \"mode\": \"%s\", "
+                                 "\"bytes\": %zu, \"hashes\": %lu, \"seconds\": %.6f, "
+                                 "\"hashes_per_sec\": %.1f, \"mb_per_sec\": %.2f, ",
+                            first ? "" : ",", sha2_descs[ndx].name, mode == MANY ? mbname : bname,
+                            mode_name[mode], len, nhash, sec, nhash / sec, nhash * (double)len / sec / 1e6);
+                    // 사이클 카운터가 없거나 입력이 비어 있으면 바이트당 사이클은 null이다.
+                    if (cyc > 0 && len > 0)
+                        fprintf(out, "\"cycles_per_byte\": %.3f}", cyc / ((double)nhash * len));
+                    else
+                        fprintf(out, "\"cycles_per_byte\": null}");
+                    first = 0;
+                }
+            }
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    sha2_set_backend(SHA2_BACKEND_NATIVE);
+    free(buf);
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
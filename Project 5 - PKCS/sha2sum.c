@@ -0,0 +1,87 @@
+/*
+ * Copyright(c) 2020-2024 All rights reserved by Heekuck Oh.
+ * 이 프로그램은 한양대학교 ERICA 컴퓨터학부 학생을 위한 교육용으로 제작되었다.
+ * 한양대학교 ERICA 학생이 아닌 자는 이 프로그램을 수정하거나 배포할 수 없다.
+ * 프로그램을 수정할 경우 날짜, 학과, 학번, 이름, 수정 내용을 기록한다.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "pkcs.h"
+#include "sha2.h"
+#include "sha2_file.h"
+
+/*
+ * SHA-2 파일 해시 도구
+ * 사용법: sha2sum [-a 224|256|384|512|512/224|512/256] [-q] 파일...
+ * 파일마다 해시 값과 파일 이름을 출력하고, 크기를 알 수 있는 파일은 처리 속도(GB/s)를 표준 오류로 출력한다.
+ * -q를 주면 처리 속도를 출력하지 않는다. 파일 이름이 "-"이면 표준 입력을 해시한다.
+ */
+static const char *alg_name[6] = {"224", "256", "384", "512", "512/224", "512/256"};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-a 224|256|384|512|512/224|512/256] [-q] file...\n", prog);
+    exit(2);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned char digest[SHA512_DIGEST_SIZE];
+    struct stat st;
+    double t, total_t = 0;
+    unsigned long long total_b = 0;
+    int c, j, ndx = SHA256, quiet = 0, val, failed = 0, nstat = 0;
+
+    while ((c = getopt(argc, argv, "a:q")) != -1) {
+        switch (c) {
+        case 'a':
+            for (ndx = 0; ndx < 6 && strcmp(optarg, alg_name[ndx]) != 0; ndx++)
+                ;
+            if (ndx == 6)
+                usage(argv[0]);
+            break;
+        case 'q': quiet = 1; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (optind == argc)
+        usage(argv[0]);
+
+    for (; optind < argc; optind++) {
+        t = now();
+        val = sha2_file(argv[optind], ndx, digest);
+        t = now() - t;
+        if (val) {
+            fprintf(stderr, "%s: sha2_file error: %d\n", argv[optind], val);
+            failed = 1;
+            continue;
+        }
+        for (j = 0; j < sha2_descs[ndx].digest_size; j++)
+            printf("%02x", digest[j]);
+        printf("  %s\n", argv[optind]);
+        // 표준 입력, 파이프, 크기가 0으로 보이는 파일은 속도를 출력하지 않는다.
+        if (!quiet && strcmp(argv[optind], "-") != 0 && stat(argv[optind], &st) == 0
+            && S_ISREG(st.st_mode) && st.st_size > 0) {
+            fprintf(stderr, "%s: %llu bytes, %.4f s, %.2f GB/s\n", argv[optind],
+                    (unsigned long long)st.st_size, t, t > 0 ? st.st_size / t / 1e9 : 0.0);
+            total_b += st.st_size;
+            total_t += t;
+            nstat++;
+        }
+    }
+    if (!quiet && nstat > 1 && total_t > 0)
+        fprintf(stderr, "total: %llu bytes, %.4f s, %.2f GB/s\n", total_b, total_t, total_b / total_t / 1e9);
+    return failed;
+}
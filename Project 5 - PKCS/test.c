@@ -14,7 +14,16 @@
 #endif
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include "pkcs.h"
+#include "sha2.h"
+#include "sha2_mb.h"
+#include "sha2_file.h"
+#include "hmac.h"
+#include "hkdf.h"
+#include "pbkdf2.h"
+#include "merkle.h"
+#include "cas.h"
 
 static char *poet = "윤동주";
 static char *poem = "죽는 날까지 하늘을 우러러 한 점 부끄럼이 없기를, 잎새에 이는 바람에도 나는 괴로워했다. 별을 노래하는 마음으로 모든 죽어 가는 것을 사랑해야지 그리고 나한테 주어진 길을 걸어가야겠다. 오늘 밤에도 별이 바람에 스치운다.";
@@ -29,6 +38,38 @@ int main(void)
 {
     char e[RSAKEYSIZE/8], d[RSAKEYSIZE/8], n[RSAKEYSIZE/8];
     char m[RSAKEYSIZE/8], c[RSAKEYSIZE/8], s[RSAKEYSIZE/8];
+    unsigned char md[SHA512_DIGEST_SIZE], mbd[20][SHA512_DIGEST_SIZE];
+    const int mb_size[6] = {SHA224_DIGEST_SIZE, SHA256_DIGEST_SIZE, SHA384_DIGEST_SIZE, SHA512_DIGEST_SIZE, SHA224_DIGEST_SIZE, SHA256_DIGEST_SIZE};
+    sha256_ctx ctx, ctx2;
+    unsigned char state[SHA256_STATE_MAX_SIZE];
+    size_t slen;
+    const unsigned char *many_msg[20];
+    size_t many_len[20];
+    unsigned char *many_dg[20];
+    sha2_iovec many_iov[20][3];
+    const sha2_iovec *many_iovp[20];
+    int many_cnt[20];
+    sha256_mb_mgr mgr;
+    sha512_mb_mgr mgr512;
+    sha2_mb_job job[20];
+    uint32 mb_h256[8][SHA256_MB_LANES];
+    uint64 mb_h512[8][SHA512_MB_LANES];
+    const unsigned char *mb_blk[SHA512_MB_LANES];
+    unsigned char mb_pad[SHA512_BLOCK_SIZE];
+    sha512_ctx ctx512;
+    hmac_key hkey;
+    hmac_ctx hctx;
+    hkdf_job hjob[2];
+    pbkdf2_job pjob[3];
+    merkle_t tree;
+    unsigned char mstream[350];
+    unsigned char proof[MERKLE_MAX_DEPTH * SHA512_DIGEST_SIZE];
+    int nproof;
+    cas_store store;
+    cas_stats cst;
+    unsigned char *cbuf, *cout;
+    size_t clen;
+    FILE *fp;
     long x, y;
     int i, val, count;
     size_t len;
@@ -36,6 +77,473 @@ int main(void)
     double cpu_time;
 
     start = clock();
+    /*
+     * <SHA-2 시험>
+     * FIPS 180-2 예제의 해시 값과 비교한다. CPU가 SHA 확장 명령어를 지원하면 그 경로를 시험한다.
+     */
+    sha256((unsigned char *)"abc", 3, md);
+    if (memcmp(md, "\xba\x78\x16\xbf\x8f\x01\xcf\xea\x41\x41\x40\xde\x5d\xae\x22\x23"
+                   "\xb0\x03\x61\xa3\x96\x17\x7a\x9c\xb4\x10\xff\x61\xf2\x00\x15\xad", 32) != 0) {
+        printf("SHA-256 Error -- FAILED\n");
+        return 1;
+    }
+    sha224((unsigned char *)"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56, md);
+    if (memcmp(md, "\x75\x38\x8b\x16\x51\x27\x76\xcc\x5d\xba\x5d\xa1\xfd\x89\x01\x50"
+                   "\xb0\xc6\x45\x5c\xb4\xf5\x8b\x19\x52\x52\x25\x25", 28) != 0) {
+        printf("SHA-224 Error -- FAILED\n");
+        return 1;
+    }
+    memset(m, 'a', 250);
+    sha256_init(&ctx);
+    for (i = 0; i < 4000; ++i)
+        sha256_update(&ctx, (unsigned char *)m, 250);
+    sha256_final(&ctx, md);
+    if (memcmp(md, "\xcd\xc7\x6e\x5c\x99\x14\xfb\x92\x81\xa1\xc7\xe2\x84\xd7\x3e\x67"
+                   "\xf1\x80\x9a\x48\xa4\x97\x20\x0e\x04\x6d\x39\xcc\xc7\x11\x2c\xd0", 32) != 0) {
+        printf("SHA-256 Long Message Error -- FAILED\n");
+        return 1;
+    }
+    /*
+     * 길이가 서로 다른 메시지 20개를 다중 버퍼 엔진으로 해시하여 하나씩 해시한 결과와 비교한다.
+     * SHA-224/256과 SHA-512 계열을 각각 시험한다.
+     */
+    for (i = 0; i < 250; ++i)
+        m[i] = i * 7;
+    sha256_mb_init(&mgr);
+    for (i = 0; i < 20; ++i) {
+        job[i].message = (unsigned char *)m;
+        job[i].len = i * 37 % 250;
+        job[i].digest = mbd[i];
+        job[i].type = i % 3 ? SHA2_MB_SHA256 : SHA2_MB_SHA224;
+        sha256_mb_submit(&mgr, &job[i]);
+    }
+    while (sha256_mb_flush(&mgr) != NULL)
+        ;
+    for (i = 0; i < 20; ++i) {
+        if (i % 3)
+            sha256((unsigned char *)m, i * 37 % 250, md);
+        else
+            sha224((unsigned char *)m, i * 37 % 250, md);
+        if (memcmp(md, mbd[i], i % 3 ? SHA256_DIGEST_SIZE : SHA224_DIGEST_SIZE) != 0) {
+            printf("SHA-256 Multi-buffer Error -- FAILED\n");
+            return 1;
+        }
+    }
+    sha512_mb_init(&mgr512);
+    for (i = 0; i < 20; ++i) {
+        job[i].message = (unsigned char *)m;
+        job[i].len = i * 53 % 250;
+        job[i].digest = mbd[i];
+        job[i].type = SHA2_MB_SHA384 + i % 4;
+        sha512_mb_submit(&mgr512, &job[i]);
+    }
+    while (sha512_mb_flush(&mgr512) != NULL)
+        ;
+    for (i = 0; i < 20; ++i) {
+        if (job[i].type == SHA2_MB_SHA384)
+            sha384((unsigned char *)m, job[i].len, md);
+        else if (job[i].type == SHA2_MB_SHA512)
+            sha512((unsigned char *)m, job[i].len, md);
+        else if (job[i].type == SHA2_MB_SHA512_224)
+            sha512_224((unsigned char *)m, job[i].len, md);
+        else
+            sha512_256((unsigned char *)m, job[i].len, md);
+        if (memcmp(md, mbd[i], mb_size[job[i].type]) != 0) {
+            printf("SHA-512 Multi-buffer Error -- FAILED\n");
+            return 1;
+        }
+    }
+    /*
+     * 길이가 서로 다른 메시지 20개를 sha2_hash_many()로 한꺼번에 해시하여 하나씩 해시한 결과와 비교한다.
+     */
+    for (i = 0; i < 20; ++i) {
+        many_msg[i] = (unsigned char *)m + i;
+        many_len[i] = 230 - i * 23 % 230;
+        many_dg[i] = mbd[i];
+    }
+    sha2_hash_many(SHA2_MB_SHA512, many_msg, many_len, 20, many_dg);
+    for (i = 0; i < 20; ++i) {
+        sha512(many_msg[i], many_len[i], md);
+        if (memcmp(md, mbd[i], SHA512_DIGEST_SIZE) != 0) {
+            printf("SHA-512 Batch Hash Error -- FAILED\n");
+            return 1;
+        }
+    }
+    /*
+     * 같은 메시지들을 블록 경계와 맞지 않는 세 조각으로 나누어 sha2_hash_many_iov()로 해시한 결과와 비교한다.
+     */
+    for (i = 0; i < 20; ++i) {
+        many_iov[i][0] = (sha2_iovec){many_msg[i], many_len[i] / 3};
+        many_iov[i][1] = (sha2_iovec){many_msg[i] + many_len[i] / 3, many_len[i] / 2 - many_len[i] / 3};
+        many_iov[i][2] = (sha2_iovec){many_msg[i] + many_len[i] / 2, many_len[i] - many_len[i] / 2};
+        many_iovp[i] = many_iov[i];
+        many_cnt[i] = 3;
+    }
+    sha2_hash_many_iov(SHA2_MB_SHA512, many_iovp, many_cnt, 20, many_dg);
+    for (i = 0; i < 20; ++i) {
+        sha512(many_msg[i], many_len[i], md);
+        if (memcmp(md, mbd[i], SHA512_DIGEST_SIZE) != 0) {
+            printf("SHA-512 Scatter/Gather Hash Error -- FAILED\n");
+            return 1;
+        }
+    }
+    /*
+     * 레인 0, 3, 6에만 "abc"를 패딩한 블록을 넣고 sha256_mb_transf(), sha512_mb_transf()로 초기값에서 압축한다.
+     * 채운 레인은 "abc"의 해시 값이 되어야 하고 blk가 NULL인 레인은 초기값 그대로여야 한다.
+     */
+    sha256_init(&ctx);
+    sha512_init(&ctx512);
+    memset(mb_pad, 0, sizeof(mb_pad));
+    memcpy(mb_pad, "abc", 3);
+    mb_pad[3] = 0x80;
+    mb_pad[SHA256_BLOCK_SIZE - 1] = 24;
+    for (i = 0; i < SHA256_MB_LANES; ++i) {
+        mb_blk[i] = i % 3 == 0 ? mb_pad : NULL;
+        for (val = 0; val < 8; ++val)
+            mb_h256[val][i] = ctx.h[val];
+    }
+    sha256_mb_transf(mb_h256, mb_blk);
+    sha256((unsigned char *)"abc", 3, md);
+    for (i = 0; i < SHA256_MB_LANES * 8; ++i) {
+        uint32 w = 0;
+        x = i % 8;
+        for (val = 0; val < 4; ++val)
+            w = w << 8 | md[4 * x + val];
+        if (mb_h256[x][i / 8] != (i / 8 % 3 == 0 ? w : ctx.h[x])) {
+            printf("SHA-256 Lane Transform Error -- FAILED\n");
+            return 1;
+        }
+    }
+    mb_pad[SHA256_BLOCK_SIZE - 1] = 0;
+    mb_pad[SHA512_BLOCK_SIZE - 1] = 24;
+    for (i = 0; i < SHA512_MB_LANES; ++i) {
+        mb_blk[i] = i % 3 == 0 ? mb_pad : NULL;
+        for (val = 0; val < 8; ++val)
+            mb_h512[val][i] = ctx512.h[val];
+    }
+    sha512_mb_transf(mb_h512, mb_blk);
+    sha512((unsigned char *)"abc", 3, md);
+    for (i = 0; i < SHA512_MB_LANES * 8; ++i) {
+        uint64 w = 0;
+        x = i % 8;
+        for (val = 0; val < 8; ++val)
+            w = w << 8 | md[8 * x + val];
+        if (mb_h512[x][i / 8] != (i / 8 % 3 == 0 ? w : ctx512.h[x])) {
+            printf("SHA-512 Lane Transform Error -- FAILED\n");
+            return 1;
+        }
+    }
+    /*
+     * 다중 버퍼 엔진을 CPU가 지원하는 레인 구현마다 고정하고 sha2_hash_many()로 SHA-256과 SHA-512를 해시하여
+     * 이식 가능한 C 압축 함수로 하나씩 해시한 결과와 비교한다. SHA 확장 명령어가 있는 CPU에서는 자동으로
+     * 고르지 않는 AVX2 8레인 SHA-256 커널도 이렇게 시험한다.
+     */
+    for (val = SHA2_MB_BACKEND_SCALAR; val <= SHA2_MB_BACKEND_AVX512; ++val) {
+        if (sha2_mb_set_backend(val) != 0)
+            continue;
+        sha2_hash_many(SHA2_MB_SHA256, many_msg, many_len, 20, many_dg);
+        sha2_set_backend(SHA2_BACKEND_PORTABLE);
+        for (i = 0; i < 20; ++i) {
+            sha256(many_msg[i], many_len[i], md);
+            if (memcmp(md, mbd[i], SHA256_DIGEST_SIZE) != 0) {
+                printf("SHA-256 Multi-buffer Backend %s Error -- FAILED\n", sha256_mb_backend_name());
+                return 1;
+            }
+        }
+        sha2_set_backend(SHA2_BACKEND_NATIVE);
+        sha2_hash_many(SHA2_MB_SHA512, many_msg, many_len, 20, many_dg);
+        sha2_set_backend(SHA2_BACKEND_PORTABLE);
+        for (i = 0; i < 20; ++i) {
+            sha512(many_msg[i], many_len[i], md);
+            if (memcmp(md, mbd[i], SHA512_DIGEST_SIZE) != 0) {
+                printf("SHA-512 Multi-buffer Backend %s Error -- FAILED\n", sha512_mb_backend_name());
+                return 1;
+            }
+        }
+        sha2_set_backend(SHA2_BACKEND_NATIVE);
+    }
+    sha2_mb_set_backend(SHA2_MB_BACKEND_AUTO);
+    /*
+     * 파일에 쓴 메시지를 sha2_file()로 해시하여 같은 메시지를 나누어 해시한 결과와 비교한다.
+     */
+    if ((fp = fopen("sha2_file.tmp", "wb")) == NULL) {
+        printf("SHA-2 File Error -- FAILED\n");
+        return 1;
+    }
+    sha256_init(&ctx);
+    for (i = 0; i < 1000; ++i) {
+        fwrite(m, 1, 250, fp);
+        sha256_update(&ctx, (unsigned char *)m, 250);
+    }
+    fclose(fp);
+    sha256_final(&ctx, md);
+    x = sha2_file("sha2_file.tmp", SHA256, mbd[0]);
+    remove("sha2_file.tmp");
+    if (x != 0 || memcmp(md, mbd[0], SHA256_DIGEST_SIZE) != 0) {
+        printf("SHA-2 File Error -- FAILED\n");
+        return 1;
+    }
+    /*
+     * RFC 4231의 HMAC 예제 2(짧은 키)와 예제 6(블록보다 긴 키)과 비교한다. 예제 6은 나누어 갱신한다.
+     */
+    hmac_key_init(&hkey, SHA256, "Jefe", 4);
+    hmac_sha2(&hkey, "what do ya want for nothing?", 28, md);
+    if (memcmp(md, "\x5b\xdc\xc1\x46\xbf\x60\x75\x4e\x6a\x04\x24\x26\x08\x95\x75\xc7"
+                   "\x5a\x00\x3f\x08\x9d\x27\x39\x83\x9d\xec\x58\xb9\x64\xec\x38\x43", 32) != 0) {
+        printf("HMAC-SHA-256 Error -- FAILED\n");
+        return 1;
+    }
+    hmac_key_init(&hkey, SHA512, "Jefe", 4);
+    hmac_sha2(&hkey, "what do ya want for nothing?", 28, md);
+    if (memcmp(md, "\x16\x4b\x7a\x7b\xfc\xf8\x19\xe2\xe3\x95\xfb\xe7\x3b\x56\xe0\xa3"
+                   "\x87\xbd\x64\x22\x2e\x83\x1f\xd6\x10\x27\x0c\xd7\xea\x25\x05\x54"
+                   "\x97\x58\xbf\x75\xc0\x5a\x99\x4a\x6d\x03\x4f\x65\xf8\xf0\xe6\xfd"
+                   "\xca\xea\xb1\xa3\x4d\x4a\x6b\x4b\x63\x6e\x07\x0a\x38\xbc\xe7\x37", 64) != 0) {
+        printf("HMAC-SHA-512 Error -- FAILED\n");
+        return 1;
+    }
+    memset(m, 0xaa, 131);
+    hmac_key_init(&hkey, SHA256, m, 131);
+    hmac_start(&hctx, &hkey);
+    hmac_update(&hctx, "Test Using Larger Than Block-Size Key", 37);
+    hmac_update(&hctx, " - Hash Key First", 17);
+    hmac_final(&hctx, md);
+    if (memcmp(md, "\x60\xe4\x31\x59\x1e\xe0\xb6\x7f\x0d\x8a\x26\xaa\xcb\xf5\xb7\x7f"
+                   "\x8e\x0b\xc6\x21\x37\x28\xc5\x14\x05\x46\x04\x0f\x0e\xe3\x7f\x54", 32) != 0) {
+        printf("HMAC-SHA-256 Long Key Error -- FAILED\n");
+        return 1;
+    }
+    /*
+     * RFC 5869의 HKDF 예제 1과 비교하고, 같은 PRK로 두 레이블을 한꺼번에 유도한 결과를 하나씩 유도한 결과와 비교한다.
+     */
+    memset(m, 0x0b, 22);
+    for (i = 0; i < 13; ++i)
+        c[i] = i;
+    for (i = 0; i < 10; ++i)
+        s[i] = 0xf0 + i;
+    if (hkdf(SHA256, c, 13, m, 22, s, 10, mbd[0], 42) != 0 ||
+        memcmp(mbd[0], "\x3c\xb2\x5f\x25\xfa\xac\xd5\x7a\x90\x43\x4f\x64\xd0\x36\x2f\x2a"
+                       "\x2d\x2d\x0a\x90\xcf\x1a\x5a\x4c\x5d\xb0\x2d\x56\xec\xc4\xc5\xbf"
+                       "\x34\x00\x72\x08\xd5\xb8\x87\x18\x58\x65", 42) != 0) {
+        printf("HKDF Error -- FAILED\n");
+        return 1;
+    }
+    hkdf_extract(SHA384, c, 13, m, 22, md);
+    hkdf_prk_init(&hkey, SHA384, md, SHA384_DIGEST_SIZE);
+    hjob[0].info = "key"; hjob[0].info_len = 3; hjob[0].okm = mbd[1]; hjob[0].len = 32;
+    hjob[1].info = "iv"; hjob[1].info_len = 2; hjob[1].okm = mbd[2]; hjob[1].len = 60;
+    hkdf_expand_batch(&hkey, hjob, 2);
+    hkdf(SHA384, c, 13, m, 22, "key", 3, mbd[3], 32);
+    hkdf(SHA384, c, 13, m, 22, "iv", 2, mbd[4], 60);
+    if (memcmp(mbd[1], mbd[3], 32) != 0 || memcmp(mbd[2], mbd[4], 60) != 0) {
+        printf("HKDF Batch Error -- FAILED\n");
+        return 1;
+    }
+    /*
+     * PBKDF2-HMAC-SHA256 예제("password", "salt", 4096회)와 비교하고, 패스워드 세 개를 한꺼번에 유도한 결과를
+     * 하나씩 유도한 결과와 비교한다. 두 번째 패스워드는 출력이 두 블록이다.
+     */
+    if (pbkdf2(SHA256, "password", 8, "salt", 4, 4096, md, 32) != 0 ||
+        memcmp(md, "\xc5\xe4\x78\xd5\x92\x88\xc8\x41\xaa\x53\x0d\xb6\x84\x5c\x4c\x8d"
+                   "\x96\x28\x93\xa0\x01\xce\x4e\x11\xa4\x96\x38\x73\xaa\x98\x13\x4a", 32) != 0) {
+        printf("PBKDF2 Error -- FAILED\n");
+        return 1;
+    }
+    for (i = 0; i < 3; ++i) {
+        pjob[i].pass = m + 10 * i;
+        pjob[i].pass_len = 5 + i;
+        pjob[i].salt = "salt";
+        pjob[i].salt_len = 4;
+        pjob[i].dk = mbd[2 * i];
+        pjob[i].dk_len = i == 1 ? 80 : 48;
+    }
+    pbkdf2_batch(SHA384, 100, pjob, 3);
+    for (i = 0; i < 3; ++i) {
+        pbkdf2(SHA384, m + 10 * i, 5 + i, "salt", 4, 100, mbd[10], pjob[i].dk_len);
+        if (memcmp(mbd[10], mbd[2 * i], pjob[i].dk_len) != 0) {
+            printf("PBKDF2 Batch Error -- FAILED\n");
+            return 1;
+        }
+    }
+    /*
+     * 250바이트와 100바이트를 차례로 덧붙인 350바이트(64바이트 잎 5개와 30바이트 잎 1개)의 머클 트리 루트를
+     * RFC 6962 방식으로 계산한 값과 비교하고, 마지막 잎의 포함 증명을 검증한다. 증명을 바꾸면 검증에
+     * 실패해야 한다. 같은 350바이트를 한 번에 덧붙이거나 잎 경계와 맞지 않게 나누어 덧붙여도 루트는 같아야 한다.
+     */
+    for (i = 0; i < 250; ++i)
+        m[i] = i;
+    merkle_init(&tree, SHA256, 64);
+    merkle_append(&tree, m, 250, 2);
+    merkle_append(&tree, m, 100, 2);
+    merkle_root(&tree, md);
+    if (tree.nleaves != 6 ||
+        memcmp(md, "\x02\x19\x50\x8c\x31\x94\x9d\x71\xfa\x3d\x72\xf8\xc8\x24\xa2\x71"
+                   "\x5e\xc8\xf5\x72\xe2\xcf\x9d\x62\xb7\xd1\x80\xc4\x20\x01\xf8\xa0", 32) != 0) {
+        printf("Merkle Tree Error -- FAILED\n");
+        return 1;
+    }
+    merkle_proof(&tree, 5, proof, &nproof);
+    merkle_leaf_hash(SHA256, m + 70, 30, mbd[0]);
+    if (merkle_verify(SHA256, mbd[0], 5, 6, proof, nproof, md) != 0) {
+        printf("Merkle Proof Error -- FAILED\n");
+        return 1;
+    }
+    merkle_free(&tree);
+    memcpy(mstream, m, 250);
+    memcpy(mstream + 250, m, 100);
+    for (i = 0; i < 3; ++i) {
+        merkle_init(&tree, SHA256, 64);
+        if (i == 0)
+            merkle_append(&tree, mstream, 350, 2);
+        else if (i == 1)
+            for (len = 0; len < 350; len += 7)
+                merkle_append(&tree, mstream + len, 7, 1);
+        else {
+            merkle_append(&tree, mstream, 10, 1);
+            merkle_append(&tree, mstream + 10, 200, 2);
+            merkle_append(&tree, mstream + 210, 140, 2);
+        }
+        merkle_root(&tree, mbd[1]);
+        if (tree.nleaves != 6 || memcmp(md, mbd[1], 32) != 0) {
+            printf("Merkle Split Append Error -- FAILED\n");
+            return 1;
+        }
+        if (i < 2)
+            merkle_free(&tree);
+    }
+    proof[0] ^= 1;
+    if (merkle_verify(SHA256, mbd[0], 5, 6, proof, nproof, md) == 0) {
+        printf("Merkle Proof Error -- FAILED\n");
+        return 1;
+    }
+    merkle_free(&tree);
+    /*
+     * 임의의 256KiB 데이터를 내용 주소 저장소에 두 번 넣는다. 두 번째에는 새로 저장되는 조각이 없어야 하고,
+     * 주소로 꺼낸 데이터는 원래 데이터와 같아야 한다. 시험이 끝나면 저장소를 지운다.
+     */
+    if ((cbuf = malloc(256 << 10)) == NULL) {
+        printf("Out of Memory -- FAILED\n");
+        return 1;
+    }
+    arc4random_buf(cbuf, 256 << 10);
+    memset(&cst, 0, sizeof(cst));
+    if (cas_open(&store, "cas_test.d") != 0 || cas_put(&store, cbuf, 256 << 10, 2, md, NULL) != 0 ||
+        cas_put(&store, cbuf, 256 << 10, 2, mbd[0], &cst) != 0 || cst.chunks == 0 || cst.new_chunks != 0 ||
+        memcmp(md, mbd[0], CAS_DIGEST_SIZE) != 0) {
+        printf("CAS Put Error -- FAILED\n");
+        return 1;
+    }
+    if (cas_get(&store, md, &cout, &clen) != 0 || clen != 256 << 10 || memcmp(cout, cbuf, clen) != 0) {
+        printf("CAS Get Error -- FAILED\n");
+        return 1;
+    }
+    free(cout);
+    /*
+     * 조각 하나짜리 1000바이트 파일 A, B를 넣고 pack에 있는 A의 레시피(조각의 SHA-256 값)를 B의 레시피로
+     * 바꾸면 A를 꺼낼 때 CAS_CORRUPT가 나와야 한다. pack은 뒤에 덧붙이므로 끝부분에서 레시피를 찾는다.
+     */
+    sha256(cbuf, 1000, mbd[2]);
+    sha256(cbuf + 1000, 1000, mbd[3]);
+    if (cas_put(&store, cbuf, 1000, 1, md, NULL) != 0 || cas_put(&store, cbuf + 1000, 1000, 1, mbd[1], NULL) != 0 ||
+        cas_flush(&store) != 0 || (fp = fopen("cas_test.d/pack", "r+b")) == NULL) {
+        printf("CAS Put Error -- FAILED\n");
+        return 1;
+    }
+    clen = 2 * (1000 + CAS_DIGEST_SIZE);
+    fseek(fp, -(long)clen, SEEK_END);
+    clen = fread(cbuf + 4096, 1, clen, fp);
+    for (len = 0; len + CAS_DIGEST_SIZE <= clen && memcmp(cbuf + 4096 + len, mbd[2], CAS_DIGEST_SIZE) != 0; ++len)
+        ;
+    fseek(fp, (long)len - (long)clen, SEEK_END);
+    fwrite(mbd[3], 1, CAS_DIGEST_SIZE, fp);
+    fclose(fp);
+    if (len + CAS_DIGEST_SIZE > clen || cas_get(&store, md, &cout, &clen) != CAS_CORRUPT) {
+        printf("CAS Tamper Error -- FAILED\n");
+        return 1;
+    }
+    cas_close(&store);
+    free(cbuf);
+    unlink("cas_test.d/pack");
+    unlink("cas_test.d/index");
+    rmdir("cas_test.d");
+    /*
+     * 중간 상태를 내보낸 후 다른 문맥으로 가져와서 이어서 해시한 결과를 한 번에 해시한 결과와 비교한다.
+     * 형식이 맞지 않는 입력은 거부해야 한다.
+     */
+    for (i = 0; i < 250; ++i)
+        m[i] = i * 7;
+    sha256_init(&ctx);
+    sha256_update(&ctx, (unsigned char *)m, 100);
+    slen = sha256_export(&ctx, state);
+    memset(&ctx2, 0, sizeof(ctx2));
+    if (sha256_import(&ctx2, state, slen) != 0 || sha256_import(&ctx2, state, slen - 1) == 0) {
+        printf("SHA-256 Midstate Import Error -- FAILED\n");
+        return 1;
+    }
+    sha256_update(&ctx2, (unsigned char *)m + 100, 150);
+    sha256_final(&ctx2, md);
+    sha256((unsigned char *)m, 250, mbd[0]);
+    if (memcmp(md, mbd[0], SHA256_DIGEST_SIZE) != 0) {
+        printf("SHA-256 Midstate Resume Error -- FAILED\n");
+        return 1;
+    }
+    /*
+     * 문맥 형식이 같아도 다른 함수가 내보낸 상태는 거부해야 한다.
+     */
+    sha224_init(&ctx);
+    sha224_update(&ctx, (unsigned char *)m, 100);
+    slen = sha224_export(&ctx, state);
+    if (sha256_import(&ctx2, state, slen) == 0 || sha224_import(&ctx2, state, slen) != 0) {
+        printf("SHA-224 Midstate Algorithm Error -- FAILED\n");
+        return 1;
+    }
+    sha224_update(&ctx2, (unsigned char *)m + 100, 150);
+    sha224_final(&ctx2, md);
+    sha224((unsigned char *)m, 250, mbd[0]);
+    if (memcmp(md, mbd[0], SHA224_DIGEST_SIZE) != 0) {
+        printf("SHA-224 Midstate Resume Error -- FAILED\n");
+        return 1;
+    }
+    /*
+     * 두 블록에 들어가는 짧은 입력은 sha224(), sha256()이 문맥 없이 따로 처리하므로 블록 경계를 지나는
+     * 길이마다 나누어 갱신한 결과와 비교한다. SHA-256d는 알려진 값과 비교한다.
+     */
+    for (len = 0; len <= SHA256_SHORT_MAX + 1; ++len) {
+        sha256_init(&ctx);
+        sha256_update(&ctx, (unsigned char *)m, len / 2);
+        sha256_update(&ctx, (unsigned char *)m + len / 2, len - len / 2);
+        sha256_final(&ctx, md);
+        sha256((unsigned char *)m, len, mbd[0]);
+        sha224_init(&ctx2);
+        sha224_update(&ctx2, (unsigned char *)m, len);
+        sha224_final(&ctx2, mbd[1]);
+        sha224((unsigned char *)m, len, mbd[2]);
+        if (memcmp(md, mbd[0], SHA256_DIGEST_SIZE) != 0 || memcmp(mbd[1], mbd[2], SHA224_DIGEST_SIZE) != 0) {
+            printf("SHA-256 Short Input Error -- FAILED\n");
+            return 1;
+        }
+    }
+    sha256d((unsigned char *)"hello", 5, md);
+    if (memcmp(md, "\x95\x95\xc9\xdf\x90\x07\x51\x48\xeb\x06\x86\x03\x65\xdf\x33\x58"
+                   "\x4b\x75\xbf\xf7\x82\xa5\x10\xc6\xcd\x48\x83\xa4\x19\x83\x3d\x50", 32) != 0) {
+        printf("SHA-256d Error -- FAILED\n");
+        return 1;
+    }
+    /*
+     * CPU 전용 압축 함수(SHA-NI, AVX2)와 C 구현의 결과를 비교한다.
+     */
+    sha2_set_backend(SHA2_BACKEND_PORTABLE);
+    sha256((unsigned char *)m, 250, mbd[0]);
+    sha512((unsigned char *)m, 250, mbd[1]);
+    sha2_set_backend(SHA2_BACKEND_NATIVE);
+    sha256((unsigned char *)m, 250, mbd[2]);
+    sha512((unsigned char *)m, 250, mbd[3]);
+    if (memcmp(mbd[0], mbd[2], SHA256_DIGEST_SIZE) != 0 || memcmp(mbd[1], mbd[3], SHA512_DIGEST_SIZE) != 0) {
+        printf("SHA-2 Backend Mismatch -- FAILED\n");
+        return 1;
+    }
+    printf("SHA-2 Known Answer Test -- PASSED\n---\n");
+
     /*
      * <RSA 키 생성 시험>
      * 길이는 RSAKEYSIZE 비트인 RSA 키를 생성한다.
@@ -25,9 +25,6 @@ ecdsa_p256_t G;
 const unsigned char Gx[ECDSA_P256/8] = {0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47, 0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2, 0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0, 0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96};
 const unsigned char Gy[ECDSA_P256/8] = {0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b, 0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16, 0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce, 0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5};
 
-// 해시 함수가 처리할 수 있는 message digest 크기(모음)
-int hLen; const int hash_output[6] = {SHA224_DIGEST_SIZE, SHA256_DIGEST_SIZE, SHA384_DIGEST_SIZE, SHA512_DIGEST_SIZE, SHA224_DIGEST_SIZE, SHA256_DIGEST_SIZE};
-
 /*
  * Initialize 256 bit ECDSA parameters
  * 시스템파라미터 p, n, a, G의 공간을 할당하고 값을 초기화한다.
@@ -92,26 +89,6 @@ int check_length(size_t l_length, int sha_index) {
     return result;
 }
 
-/* calc_hash() - 사용자가 지정한 hash 함수를 이용하여 HASH(L)을 계산하는 함수
-   sha224/256/384/512/512_224/512_256을 지원한다.
-*/
-void calc_hash(const void *label, size_t length, void *digest, int sha2_idx) {
-    // label을 사용자가 지정한 해시 함수로 처리하여 hash에 저장한다.
-    if (sha2_idx == SHA224) {
-        sha224(label, length, digest);
-    } else if (sha2_idx == SHA256) {
-        sha256(label, length, digest);
-    } else if (sha2_idx == SHA384) {
-        sha384(label, length, digest);
-    } else if (sha2_idx == SHA512) {
-        sha512(label, length, digest);
-    } else if (sha2_idx == SHA512_224) {
-        sha512_224(label, length, digest);
-    } else if (sha2_idx == SHA512_256) {
-        sha512_256(label, length, digest);
-    }
-}
-
 /*
 * bit2int - convert a bit string to an Integer mod n 
 *           via Modular reduction
@@ -408,11 +385,12 @@ int ecdsa_p256_sign(const void *msg, size_t len, const void *d, void *_r, void *
 	if (check_length(len, sha2_ndx)) return ECDSA_MSG_TOO_LONG;
 	
     // 해시 함수의 메시지 다이제스트를 담을 배열 E와 N_E를 생성한다.
-    hLen = hash_output[sha2_ndx];
+    const sha2_desc *hd = &sha2_descs[sha2_ndx];
+    const int hLen = hd->digest_size;
     unsigned char E[hLen], N_E[ECDSA_P256/8];
 
     // E에 해시 함수의 메시지 다이제스트를 담는다.
-    calc_hash(msg, len, E, sha2_ndx);
+    hd->hash(msg, len, E);
 
     // bit string E(N_E)를 정수로 변환한 값을 담을 e와
     // per-message secret number를 담을 k, d의 값을 담을 nd를 생성한다.
@@ -540,22 +518,20 @@ int ecdsa_p256_verify(const void *msg, size_t len, const ecdsa_p256_t *_Q, const
     }
 
     // 해시 함수의 메시지 다이제스트를 담을 배열 E와 N_E를 생성한다.
-    hLen = hash_output[sha2_ndx];
+    const sha2_desc *hd = &sha2_descs[sha2_ndx];
+    const int hLen = hd->digest_size;
     unsigned char E[hLen], N_E[ECDSA_P256/8];
 
     // 서명 검증과 계산 결과가 제대로 생성되었는지 확인하기 위한 값
     int result = 0;
 
     // E에 해시 함수의 메시지 다이제스트를 담는다.
-    calc_hash(msg, len, E, sha2_ndx);
+    hd->hash(msg, len, E);
 
     // bit string E(N_E)를 정수로 변환한 값을 담을 e를 생성한다.
     mpz_t e;
     mpz_inits(e, NULL);
 
-    // E에 해시 함수의 메시지 다이제스트를 담는다.
-    calc_hash(msg, len, E, sha2_ndx);
-
 	// 해시 함수의 메시지 다이제스트 길이가 256비트보다 긴 경우
 	if (hLen > ECDSA_P256 / 8) {
 		// N_E에 E의 원소를 256비트만큼 복사한다. 
@@ -41,6 +41,11 @@
 
 #include "sha2.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#define SHA2_X86
+#include <immintrin.h>
+#endif
+
 #define SHFR(x, n)    (x >> n)
 #define ROTR(x, n)   ((x >> n) | (x << ((sizeof(x) << 3) - n)))
 #define ROTL(x, n)   ((x << n) | (x >> ((sizeof(x) << 3) - n)))
@@ -223,20 +228,20 @@ uint64 sha512_k[80] =
 
 /* SHA-256 functions */
 
-void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
-                   unsigned int block_nb)
+static void sha256_transf_c(sha256_ctx *ctx, const unsigned char *message,
+                            size_t block_nb)
 {
     uint32 w[64];
     uint32 wv[8];
     uint32 t1, t2;
     const unsigned char *sub_block;
-    int i;
+    size_t i;
 
 #ifndef UNROLL_LOOPS
     int j;
 #endif
 
-    for (i = 0; i < (int) block_nb; i++) {
+    for (i = 0; i < block_nb; i++) {
         sub_block = message + (i << 6);
 
 #ifndef UNROLL_LOOPS
@@ -338,10 +343,172 @@ void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
     }
 }
 
-void sha256(const unsigned char *message, unsigned int len, unsigned char *digest)
+#ifdef SHA2_X86
+/*
+ * SHA-256 compression with the Intel SHA extensions. The state is kept as
+ * ABEF/CDGH pairs as required by sha256rnds2, which performs two rounds per
+ * instruction; sha256msg1/sha256msg2 compute the message schedule four
+ * words at a time.
+ */
+
+#define SHANI_RNDS4(msg, j)                                              \
+{                                                                        \
+    tmp = _mm_add_epi32(msg, _mm_loadu_si128((const __m128i *)           \
+                                             &sha256_k[j]));             \
+    state1 = _mm_sha256rnds2_epu32(state1, state0, tmp);                 \
+    tmp = _mm_shuffle_epi32(tmp, 0x0e);                                  \
+    state0 = _mm_sha256rnds2_epu32(state0, state1, tmp);                 \
+}
+
+#define SHANI_SCHED(m0, m1, m2, m3)                                      \
+{                                                                        \
+    m0 = _mm_sha256msg1_epu32(m0, m1);                                   \
+    m0 = _mm_add_epi32(m0, _mm_alignr_epi8(m3, m2, 4));                  \
+    m0 = _mm_sha256msg2_epu32(m0, m3);                                   \
+}
+
+__attribute__((target("sha,sse4.1")))
+static void sha256_transf_shani(sha256_ctx *ctx, const unsigned char *message,
+                                size_t block_nb)
+{
+    const __m128i bswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+                                         0x0405060700010203ULL);
+    __m128i state0, state1, save0, save1, tmp;
+    __m128i m0, m1, m2, m3;
+    const unsigned char *sub_block;
+    size_t i;
+    int j;
+
+    /* h[0..7] = ABCDEFGH -> state0 = ABEF, state1 = CDGH */
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &ctx->h[0]),
+                            0xb1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &ctx->h[4]),
+                               0x1b);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+    for (i = 0; i < block_nb; i++) {
+        sub_block = message + (i << 6);
+        save0 = state0;
+        save1 = state1;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)
+                                              (sub_block +  0)), bswap);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)
+                                              (sub_block + 16)), bswap);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)
+                                              (sub_block + 32)), bswap);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)
+                                              (sub_block + 48)), bswap);
+
+        SHANI_RNDS4(m0,  0); SHANI_RNDS4(m1,  4);
+        SHANI_RNDS4(m2,  8); SHANI_RNDS4(m3, 12);
+
+        for (j = 16; j < 64; j += 16) {
+            SHANI_SCHED(m0, m1, m2, m3); SHANI_RNDS4(m0, j);
+            SHANI_SCHED(m1, m2, m3, m0); SHANI_RNDS4(m1, j + 4);
+            SHANI_SCHED(m2, m3, m0, m1); SHANI_RNDS4(m2, j + 8);
+            SHANI_SCHED(m3, m0, m1, m2); SHANI_RNDS4(m3, j + 12);
+        }
+
+        state0 = _mm_add_epi32(state0, save0);
+        state1 = _mm_add_epi32(state1, save1);
+    }
+
+    /* ABEF/CDGH -> ABCD/EFGH */
+    tmp = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *) &ctx->h[0], state0);
+    _mm_storeu_si128((__m128i *) &ctx->h[4], state1);
+}
+#endif /* SHA2_X86 */
+
+static void (*sha256_transf_impl)(sha256_ctx *, const unsigned char *,
+                                  size_t) = sha256_transf_c;
+
+void sha256_transf(sha256_ctx *ctx, const unsigned char *message,
+                   size_t block_nb)
+{
+    sha256_transf_impl(ctx, message, block_nb);
+}
+
+/* Short inputs
+ *
+ * A message of at most SHA256_SHORT_MAX bytes fits in two blocks together
+ * with its padding, so it is padded once on the stack and compressed from
+ * the IV without going through the context buffer, tot_len bookkeeping and
+ * the generic final. Only ctx.h is touched by the compression functions.
+ */
+
+static void sha256_short(const uint32 *h0, const unsigned char *message,
+                         size_t len, unsigned char *digest, int words)
+{
+    unsigned char block[2 * SHA256_BLOCK_SIZE];
+    uint64 len_b = (uint64) len << 3;
+    sha256_ctx ctx;
+
+    memcpy(ctx.h, h0, sizeof(ctx.h));
+    memset(block, 0, sizeof(block));
+    memcpy(block, message, len);
+    block[len] = 0x80;
+    if (len <= SHA256_BLOCK_SIZE - 9) {
+        UNPACK64(len_b, block + SHA256_BLOCK_SIZE - 8);
+        sha256_transf(&ctx, block, 1);
+    } else {
+        UNPACK64(len_b, block + 2 * SHA256_BLOCK_SIZE - 8);
+        sha256_transf(&ctx, block, 2);
+    }
+    UNPACK32(ctx.h[0], &digest[ 0]);
+    UNPACK32(ctx.h[1], &digest[ 4]);
+    UNPACK32(ctx.h[2], &digest[ 8]);
+    UNPACK32(ctx.h[3], &digest[12]);
+    UNPACK32(ctx.h[4], &digest[16]);
+    UNPACK32(ctx.h[5], &digest[20]);
+    UNPACK32(ctx.h[6], &digest[24]);
+    if (words == 8) {
+        UNPACK32(ctx.h[7], &digest[28]);
+    }
+}
+
+/* Padding of a 32-byte message: 0x80, zeros, bit length 256 */
+static const unsigned char sha256_pad32[SHA256_BLOCK_SIZE - 32] = {
+    0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0x00
+};
+
+/* SHA-256d: SHA-256 of the SHA-256 digest of the message. The inner digest
+ * is written straight into a block whose second half is the constant
+ * padding above, so the outer hash is a single compression.
+ */
+void sha256d(const unsigned char *message, size_t len, unsigned char *digest)
 {
+    unsigned char block[SHA256_BLOCK_SIZE];
     sha256_ctx ctx;
 
+    sha256(message, len, block);
+    memcpy(block + SHA256_DIGEST_SIZE, sha256_pad32, sizeof(sha256_pad32));
+    memcpy(ctx.h, sha256_h0, sizeof(ctx.h));
+    sha256_transf(&ctx, block, 1);
+    UNPACK32(ctx.h[0], &digest[ 0]);
+    UNPACK32(ctx.h[1], &digest[ 4]);
+    UNPACK32(ctx.h[2], &digest[ 8]);
+    UNPACK32(ctx.h[3], &digest[12]);
+    UNPACK32(ctx.h[4], &digest[16]);
+    UNPACK32(ctx.h[5], &digest[20]);
+    UNPACK32(ctx.h[6], &digest[24]);
+    UNPACK32(ctx.h[7], &digest[28]);
+}
+
+void sha256(const unsigned char *message, size_t len, unsigned char *digest)
+{
+    sha256_ctx ctx;
+
+    if (len <= SHA256_SHORT_MAX) {
+        sha256_short(sha256_h0, message, len, digest, 8);
+        return;
+    }
     sha256_init(&ctx);
     sha256_update(&ctx, message, len);
     sha256_final(&ctx, digest);
@@ -366,44 +533,56 @@ void sha256_init(sha256_ctx *ctx)
 }
 
 void sha256_update(sha256_ctx *ctx, const unsigned char *message,
-                   unsigned int len)
+                   size_t len)
 {
-    unsigned int block_nb;
-    unsigned int new_len, rem_len, tmp_len;
-    const unsigned char *shifted_message;
+    size_t block_nb, rem_len;
 
-    tmp_len = SHA256_BLOCK_SIZE - ctx->len;
-    rem_len = len < tmp_len ? len : tmp_len;
-
-    memcpy(&ctx->block[ctx->len], message, rem_len);
-
-    if (ctx->len + len < SHA256_BLOCK_SIZE) {
+    /* Tiny update: still inside the current block, just buffer it */
+    if (len < SHA256_BLOCK_SIZE - ctx->len) {
+        memcpy(&ctx->block[ctx->len], message, len);
         ctx->len += len;
         return;
     }
 
-    new_len = len - rem_len;
-    block_nb = new_len / SHA256_BLOCK_SIZE;
-
-    shifted_message = message + rem_len;
+    /* Complete the buffered head, if any */
+    if (ctx->len != 0) {
+        rem_len = SHA256_BLOCK_SIZE - ctx->len;
+        memcpy(&ctx->block[ctx->len], message, rem_len);
+        sha256_transf(ctx, ctx->block, 1);
+        ctx->tot_len += SHA256_BLOCK_SIZE;
+        message += rem_len;
+        len -= rem_len;
+    }
 
-    sha256_transf(ctx, ctx->block, 1);
-    sha256_transf(ctx, shifted_message, block_nb);
+    /* Compress the aligned run of full blocks straight from the caller */
+    block_nb = len / SHA256_BLOCK_SIZE;
+    sha256_transf(ctx, message, block_nb);
+    ctx->tot_len += (uint64) block_nb << 6;
 
-    rem_len = new_len % SHA256_BLOCK_SIZE;
+    /* Buffer the tail */
+    rem_len = len % SHA256_BLOCK_SIZE;
+    memcpy(ctx->block, &message[block_nb << 6], rem_len);
+    ctx->len = rem_len;
+}
 
-    memcpy(ctx->block, &shifted_message[block_nb << 6],
-           rem_len);
+/* Absorb iovcnt fragments as if they were one contiguous message. Only the
+ * bytes that do not fill a whole block are copied, as in sha256_update().
+ * Also valid on a SHA-224 context.
+ */
+void sha256_update_iov(sha256_ctx *ctx, const sha2_iovec *iov, int iovcnt)
+{
+    int i;
 
-    ctx->len = rem_len;
-    ctx->tot_len += (block_nb + 1) << 6;
+    for (i = 0; i < iovcnt; i++) {
+        sha256_update(ctx, iov[i].base, iov[i].len);
+    }
 }
 
 void sha256_final(sha256_ctx *ctx, unsigned char *digest)
 {
     unsigned int block_nb;
     unsigned int pm_len;
-    unsigned int len_b;
+    uint64 len_b;
 
 #ifndef UNROLL_LOOPS
     int i;
@@ -417,7 +596,7 @@ void sha256_final(sha256_ctx *ctx, unsigned char *digest)
 
     memset(ctx->block + ctx->len, 0, pm_len - ctx->len);
     ctx->block[ctx->len] = 0x80;
-    UNPACK32(len_b, ctx->block + pm_len - 4);
+    UNPACK64(len_b, ctx->block + pm_len - 8);
 
     sha256_transf(ctx, ctx->block, block_nb);
 
@@ -439,16 +618,17 @@ void sha256_final(sha256_ctx *ctx, unsigned char *digest)
 
 /* SHA-512 functions */
 
-void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
-                   unsigned int block_nb)
+static void sha512_transf_c(sha512_ctx *ctx, const unsigned char *message,
+                            size_t block_nb)
 {
     uint64 w[80];
     uint64 wv[8];
     uint64 t1, t2;
     const unsigned char *sub_block;
-    int i, j;
+    size_t i;
+    int j;
 
-    for (i = 0; i < (int) block_nb; i++) {
+    for (i = 0; i < block_nb; i++) {
         sub_block = message + (i << 7);
 
 #ifndef UNROLL_LOOPS
@@ -534,7 +714,188 @@ void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
     }
 }
 
-void sha512(const unsigned char *message, unsigned int len,
+#ifdef SHA2_X86
+/*
+ * SHA-512 with an AVX2 message schedule. There are no SHA-512 instructions
+ * on common x86 parts, so the rounds stay scalar (fully unrolled) and the
+ * schedule is computed four words at a time, 16 words ahead of the rounds
+ * that consume it, with K[j] already added in.
+ */
+
+#define ROTR_4X64(x, n) _mm256_or_si256(_mm256_srli_epi64(x, n), \
+                                        _mm256_slli_epi64(x, 64 - (n)))
+
+#define SHA512_F3_4X64(x) _mm256_xor_si256(_mm256_xor_si256(              \
+                          ROTR_4X64(x,  1), ROTR_4X64(x,  8)),            \
+                          _mm256_srli_epi64(x,  7))
+#define SHA512_F4_4X64(x) _mm256_xor_si256(_mm256_xor_si256(              \
+                          ROTR_4X64(x, 19), ROTR_4X64(x, 61)),            \
+                          _mm256_srli_epi64(x,  6))
+
+#define SHA512_WK_AVX2(x, t)                                                \
+    _mm256_store_si256((__m256i *) &wk[t], _mm256_add_epi64(x,            \
+                       _mm256_loadu_si256((const __m256i *) &sha512_k[t])))
+
+/*
+ * x0..x3 hold w[t - 16 .. t - 1]; x0 is replaced by w[t .. t + 3] and
+ * w[t .. t + 3] + K[t .. t + 3] is stored to wk[t]. sigma1 of w[t + 2] and
+ * w[t + 3] depends on w[t] and w[t + 1], so it is added in two halves.
+ */
+#define SHA512_SCR_AVX2(x0, x1, x2, x3, t)                                  \
+{                                                                         \
+    __m256i w15, w7, s1;                                                  \
+                                                                          \
+    w15 = _mm256_permute4x64_epi64(_mm256_blend_epi32(x0, x1, 0x03), 0x39);\
+    w7 = _mm256_permute4x64_epi64(_mm256_blend_epi32(x2, x3, 0x03), 0x39); \
+    x0 = _mm256_add_epi64(_mm256_add_epi64(x0, w7), SHA512_F3_4X64(w15)); \
+    s1 = SHA512_F4_4X64(_mm256_permute4x64_epi64(x3, 0xee));              \
+    x0 = _mm256_add_epi64(x0, _mm256_blend_epi32(s1, zero, 0xf0));        \
+    s1 = SHA512_F4_4X64(_mm256_permute4x64_epi64(x0, 0x44));              \
+    x0 = _mm256_add_epi64(x0, _mm256_blend_epi32(zero, s1, 0xf0));        \
+    SHA512_WK_AVX2(x0, t);                                                \
+}
+
+#define SHA512_EXP_WK(a, b, c, d, e, f, g ,h, j)            \
+{                                                           \
+    t1 = wv[h] + SHA512_F2(wv[e]) + CH(wv[e], wv[f], wv[g]) \
+         + wk[j];                                           \
+    t2 = SHA512_F1(wv[a]) + MAJ(wv[a], wv[b], wv[c]);       \
+    wv[d] += t1;                                            \
+    wv[h] = t1 + t2;                                        \
+}
+
+#define SHA512_EXP_WK8(j)                                   \
+{                                                           \
+    SHA512_EXP_WK(0,1,2,3,4,5,6,7,(j) + 0);                 \
+    SHA512_EXP_WK(7,0,1,2,3,4,5,6,(j) + 1);                 \
+    SHA512_EXP_WK(6,7,0,1,2,3,4,5,(j) + 2);                 \
+    SHA512_EXP_WK(5,6,7,0,1,2,3,4,(j) + 3);                 \
+    SHA512_EXP_WK(4,5,6,7,0,1,2,3,(j) + 4);                 \
+    SHA512_EXP_WK(3,4,5,6,7,0,1,2,(j) + 5);                 \
+    SHA512_EXP_WK(2,3,4,5,6,7,0,1,(j) + 6);                 \
+    SHA512_EXP_WK(1,2,3,4,5,6,7,0,(j) + 7);                 \
+}
+
+__attribute__((target("avx2")))
+static void sha512_transf_avx2(sha512_ctx *ctx, const unsigned char *message,
+                               size_t block_nb)
+{
+    const __m256i bswap = _mm256_set_epi64x(0x08090a0b0c0d0e0fULL,
+                                            0x0001020304050607ULL,
+                                            0x08090a0b0c0d0e0fULL,
+                                            0x0001020304050607ULL);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i x0, x1, x2, x3;
+    uint64 wk[80] __attribute__((aligned(32)));
+    uint64 wv[8];
+    uint64 t1, t2;
+    const unsigned char *sub_block;
+    size_t i;
+    int j;
+
+    for (i = 0; i < block_nb; i++) {
+        sub_block = message + (i << 7);
+
+        x0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)
+                                                    (sub_block +  0)), bswap);
+        x1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)
+                                                    (sub_block + 32)), bswap);
+        x2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)
+                                                    (sub_block + 64)), bswap);
+        x3 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)
+                                                    (sub_block + 96)), bswap);
+        SHA512_WK_AVX2(x0,  0); SHA512_WK_AVX2(x1,  4);
+        SHA512_WK_AVX2(x2,  8); SHA512_WK_AVX2(x3, 12);
+
+        wv[0] = ctx->h[0]; wv[1] = ctx->h[1];
+        wv[2] = ctx->h[2]; wv[3] = ctx->h[3];
+        wv[4] = ctx->h[4]; wv[5] = ctx->h[5];
+        wv[6] = ctx->h[6]; wv[7] = ctx->h[7];
+
+        /* Rounds j .. j + 15 overlap the schedule of w[j + 16 .. j + 31] */
+        for (j = 0; j < 64; j += 16) {
+            SHA512_SCR_AVX2(x0, x1, x2, x3, j + 16);
+            SHA512_SCR_AVX2(x1, x2, x3, x0, j + 20);
+            SHA512_EXP_WK8(j);
+            SHA512_SCR_AVX2(x2, x3, x0, x1, j + 24);
+            SHA512_SCR_AVX2(x3, x0, x1, x2, j + 28);
+            SHA512_EXP_WK8(j + 8);
+        }
+        SHA512_EXP_WK8(64);
+        SHA512_EXP_WK8(72);
+
+        ctx->h[0] += wv[0]; ctx->h[1] += wv[1];
+        ctx->h[2] += wv[2]; ctx->h[3] += wv[3];
+        ctx->h[4] += wv[4]; ctx->h[5] += wv[5];
+        ctx->h[6] += wv[6]; ctx->h[7] += wv[7];
+    }
+}
+#endif /* SHA2_X86 */
+
+static void (*sha512_transf_impl)(sha512_ctx *, const unsigned char *,
+                                  size_t) = sha512_transf_c;
+
+/* Fastest compression functions this CPU supports */
+static void (*sha256_transf_native)(sha256_ctx *, const unsigned char *,
+                                    size_t) = sha256_transf_c;
+static void (*sha512_transf_native)(sha512_ctx *, const unsigned char *,
+                                    size_t) = sha512_transf_c;
+
+/* Select the compression functions once, at program start-up */
+__attribute__((constructor))
+static void sha2_cpu_init(void)
+{
+#ifdef SHA2_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1"))
+        sha256_transf_native = sha256_transf_shani;
+    if (__builtin_cpu_supports("avx2"))
+        sha512_transf_native = sha512_transf_avx2;
+#endif
+    sha256_transf_impl = sha256_transf_native;
+    sha512_transf_impl = sha512_transf_native;
+}
+
+/* Switch between the portable and the CPU-specific compression functions,
+ * e.g. to benchmark or cross-check them. Not thread-safe: call it while
+ * no other thread is hashing.
+ */
+void sha2_set_backend(int backend)
+{
+    if (backend == SHA2_BACKEND_PORTABLE) {
+        sha256_transf_impl = sha256_transf_c;
+        sha512_transf_impl = sha512_transf_c;
+    } else {
+        sha256_transf_impl = sha256_transf_native;
+        sha512_transf_impl = sha512_transf_native;
+    }
+}
+
+const char *sha256_backend_name(void)
+{
+#ifdef SHA2_X86
+    if (sha256_transf_impl == sha256_transf_shani)
+        return "shani";
+#endif
+    return "c";
+}
+
+const char *sha512_backend_name(void)
+{
+#ifdef SHA2_X86
+    if (sha512_transf_impl == sha512_transf_avx2)
+        return "avx2";
+#endif
+    return "c";
+}
+
+void sha512_transf(sha512_ctx *ctx, const unsigned char *message,
+                   size_t block_nb)
+{
+    sha512_transf_impl(ctx, message, block_nb);
+}
+
+void sha512(const unsigned char *message, size_t len,
             unsigned char *digest)
 {
     sha512_ctx ctx;
@@ -544,7 +905,7 @@ void sha512(const unsigned char *message, unsigned int len,
     sha512_final(&ctx, digest);
 }
 
-void sha512_224(const unsigned char *message, unsigned int len,
+void sha512_224(const unsigned char *message, size_t len,
             unsigned char *digest)
 {
     sha512_ctx ctx;
@@ -554,7 +915,7 @@ void sha512_224(const unsigned char *message, unsigned int len,
     sha512_224_final(&ctx, digest);
 }
 
-void sha512_256(const unsigned char *message, unsigned int len,
+void sha512_256(const unsigned char *message, size_t len,
             unsigned char *digest)
 {
     sha512_ctx ctx;
@@ -619,44 +980,55 @@ void sha512_256_init(sha512_ctx *ctx)
 }
 
 void sha512_update(sha512_ctx *ctx, const unsigned char *message,
-                   unsigned int len)
+                   size_t len)
 {
-    unsigned int block_nb;
-    unsigned int new_len, rem_len, tmp_len;
-    const unsigned char *shifted_message;
-
-    tmp_len = SHA512_BLOCK_SIZE - ctx->len;
-    rem_len = len < tmp_len ? len : tmp_len;
+    size_t block_nb, rem_len;
 
-    memcpy(&ctx->block[ctx->len], message, rem_len);
-
-    if (ctx->len + len < SHA512_BLOCK_SIZE) {
+    /* Tiny update: still inside the current block, just buffer it */
+    if (len < SHA512_BLOCK_SIZE - ctx->len) {
+        memcpy(&ctx->block[ctx->len], message, len);
         ctx->len += len;
         return;
     }
 
-    new_len = len - rem_len;
-    block_nb = new_len / SHA512_BLOCK_SIZE;
-
-    shifted_message = message + rem_len;
+    /* Complete the buffered head, if any */
+    if (ctx->len != 0) {
+        rem_len = SHA512_BLOCK_SIZE - ctx->len;
+        memcpy(&ctx->block[ctx->len], message, rem_len);
+        sha512_transf(ctx, ctx->block, 1);
+        ctx->tot_len += SHA512_BLOCK_SIZE;
+        message += rem_len;
+        len -= rem_len;
+    }
 
-    sha512_transf(ctx, ctx->block, 1);
-    sha512_transf(ctx, shifted_message, block_nb);
+    /* Compress the aligned run of full blocks straight from the caller */
+    block_nb = len / SHA512_BLOCK_SIZE;
+    sha512_transf(ctx, message, block_nb);
+    ctx->tot_len += (uint64) block_nb << 7;
 
-    rem_len = new_len % SHA512_BLOCK_SIZE;
+    /* Buffer the tail */
+    rem_len = len % SHA512_BLOCK_SIZE;
+    memcpy(ctx->block, &message[block_nb << 7], rem_len);
+    ctx->len = rem_len;
+}
 
-    memcpy(ctx->block, &shifted_message[block_nb << 7],
-           rem_len);
+/* Same as sha256_update_iov(); also valid on SHA-384 and SHA-512/t
+ * contexts.
+ */
+void sha512_update_iov(sha512_ctx *ctx, const sha2_iovec *iov, int iovcnt)
+{
+    int i;
 
-    ctx->len = rem_len;
-    ctx->tot_len += (block_nb + 1) << 7;
+    for (i = 0; i < iovcnt; i++) {
+        sha512_update(ctx, iov[i].base, iov[i].len);
+    }
 }
 
 void sha512_final(sha512_ctx *ctx, unsigned char *digest)
 {
     unsigned int block_nb;
     unsigned int pm_len;
-    unsigned int len_b;
+    uint64 len_b;
 
 #ifndef UNROLL_LOOPS
     int i;
@@ -670,7 +1042,9 @@ void sha512_final(sha512_ctx *ctx, unsigned char *digest)
 
     memset(ctx->block + ctx->len, 0, pm_len - ctx->len);
     ctx->block[ctx->len] = 0x80;
-    UNPACK32(len_b, ctx->block + pm_len - 4);
+    /* 128-bit length: the upper word holds the bits shifted out of len_b */
+    UNPACK64((ctx->tot_len + ctx->len) >> 61, ctx->block + pm_len - 16);
+    UNPACK64(len_b, ctx->block + pm_len - 8);
 
     sha512_transf(ctx, ctx->block, block_nb);
 
@@ -694,7 +1068,7 @@ void sha512_224_final(sha512_ctx *ctx, unsigned char *digest)
 {
     unsigned int block_nb;
     unsigned int pm_len;
-    unsigned int len_b;
+    uint64 len_b;
 
 #ifndef UNROLL_LOOPS
     int i;
@@ -708,7 +1082,9 @@ void sha512_224_final(sha512_ctx *ctx, unsigned char *digest)
 
     memset(ctx->block + ctx->len, 0, pm_len - ctx->len);
     ctx->block[ctx->len] = 0x80;
-    UNPACK32(len_b, ctx->block + pm_len - 4);
+    /* 128-bit length: the upper word holds the bits shifted out of len_b */
+    UNPACK64((ctx->tot_len + ctx->len) >> 61, ctx->block + pm_len - 16);
+    UNPACK64(len_b, ctx->block + pm_len - 8);
 
     sha512_transf(ctx, ctx->block, block_nb);
 
@@ -733,7 +1109,7 @@ void sha512_256_final(sha512_ctx *ctx, unsigned char *digest)
 {
     unsigned int block_nb;
     unsigned int pm_len;
-    unsigned int len_b;
+    uint64 len_b;
 
 #ifndef UNROLL_LOOPS
     int i;
@@ -747,7 +1123,9 @@ void sha512_256_final(sha512_ctx *ctx, unsigned char *digest)
 
     memset(ctx->block + ctx->len, 0, pm_len - ctx->len);
     ctx->block[ctx->len] = 0x80;
-    UNPACK32(len_b, ctx->block + pm_len - 4);
+    /* 128-bit length: the upper word holds the bits shifted out of len_b */
+    UNPACK64((ctx->tot_len + ctx->len) >> 61, ctx->block + pm_len - 16);
+    UNPACK64(len_b, ctx->block + pm_len - 8);
 
     sha512_transf(ctx, ctx->block, block_nb);
 
@@ -765,7 +1143,7 @@ void sha512_256_final(sha512_ctx *ctx, unsigned char *digest)
 
 /* SHA-384 functions */
 
-void sha384(const unsigned char *message, unsigned int len,
+void sha384(const unsigned char *message, size_t len,
             unsigned char *digest)
 {
     sha384_ctx ctx;
@@ -794,44 +1172,43 @@ void sha384_init(sha384_ctx *ctx)
 }
 
 void sha384_update(sha384_ctx *ctx, const unsigned char *message,
-                   unsigned int len)
+                   size_t len)
 {
-    unsigned int block_nb;
-    unsigned int new_len, rem_len, tmp_len;
-    const unsigned char *shifted_message;
-
-    tmp_len = SHA384_BLOCK_SIZE - ctx->len;
-    rem_len = len < tmp_len ? len : tmp_len;
-
-    memcpy(&ctx->block[ctx->len], message, rem_len);
+    size_t block_nb, rem_len;
 
-    if (ctx->len + len < SHA384_BLOCK_SIZE) {
+    /* Tiny update: still inside the current block, just buffer it */
+    if (len < SHA384_BLOCK_SIZE - ctx->len) {
+        memcpy(&ctx->block[ctx->len], message, len);
         ctx->len += len;
         return;
     }
 
-    new_len = len - rem_len;
-    block_nb = new_len / SHA384_BLOCK_SIZE;
-
-    shifted_message = message + rem_len;
-
-    sha512_transf(ctx, ctx->block, 1);
-    sha512_transf(ctx, shifted_message, block_nb);
-
-    rem_len = new_len % SHA384_BLOCK_SIZE;
+    /* Complete the buffered head, if any */
+    if (ctx->len != 0) {
+        rem_len = SHA384_BLOCK_SIZE - ctx->len;
+        memcpy(&ctx->block[ctx->len], message, rem_len);
+        sha512_transf(ctx, ctx->block, 1);
+        ctx->tot_len += SHA384_BLOCK_SIZE;
+        message += rem_len;
+        len -= rem_len;
+    }
 
-    memcpy(ctx->block, &shifted_message[block_nb << 7],
-           rem_len);
+    /* Compress the aligned run of full blocks straight from the caller */
+    block_nb = len / SHA384_BLOCK_SIZE;
+    sha512_transf(ctx, message, block_nb);
+    ctx->tot_len += (uint64) block_nb << 7;
 
+    /* Buffer the tail */
+    rem_len = len % SHA384_BLOCK_SIZE;
+    memcpy(ctx->block, &message[block_nb << 7], rem_len);
     ctx->len = rem_len;
-    ctx->tot_len += (block_nb + 1) << 7;
 }
 
 void sha384_final(sha384_ctx *ctx, unsigned char *digest)
 {
     unsigned int block_nb;
     unsigned int pm_len;
-    unsigned int len_b;
+    uint64 len_b;
 
 #ifndef UNROLL_LOOPS
     int i;
@@ -845,7 +1222,9 @@ void sha384_final(sha384_ctx *ctx, unsigned char *digest)
 
     memset(ctx->block + ctx->len, 0, pm_len - ctx->len);
     ctx->block[ctx->len] = 0x80;
-    UNPACK32(len_b, ctx->block + pm_len - 4);
+    /* 128-bit length: the upper word holds the bits shifted out of len_b */
+    UNPACK64((ctx->tot_len + ctx->len) >> 61, ctx->block + pm_len - 16);
+    UNPACK64(len_b, ctx->block + pm_len - 8);
 
     sha512_transf(ctx, ctx->block, block_nb);
 
@@ -865,11 +1244,15 @@ void sha384_final(sha384_ctx *ctx, unsigned char *digest)
 
 /* SHA-224 functions */
 
-void sha224(const unsigned char *message, unsigned int len,
+void sha224(const unsigned char *message, size_t len,
             unsigned char *digest)
 {
     sha224_ctx ctx;
 
+    if (len <= SHA224_SHORT_MAX) {
+        sha256_short(sha224_h0, message, len, digest, 7);
+        return;
+    }
     sha224_init(&ctx);
     sha224_update(&ctx, message, len);
     sha224_final(&ctx, digest);
@@ -894,44 +1277,43 @@ void sha224_init(sha224_ctx *ctx)
 }
 
 void sha224_update(sha224_ctx *ctx, const unsigned char *message,
-                   unsigned int len)
+                   size_t len)
 {
-    unsigned int block_nb;
-    unsigned int new_len, rem_len, tmp_len;
-    const unsigned char *shifted_message;
+    size_t block_nb, rem_len;
 
-    tmp_len = SHA224_BLOCK_SIZE - ctx->len;
-    rem_len = len < tmp_len ? len : tmp_len;
-
-    memcpy(&ctx->block[ctx->len], message, rem_len);
-
-    if (ctx->len + len < SHA224_BLOCK_SIZE) {
+    /* Tiny update: still inside the current block, just buffer it */
+    if (len < SHA224_BLOCK_SIZE - ctx->len) {
+        memcpy(&ctx->block[ctx->len], message, len);
         ctx->len += len;
         return;
     }
 
-    new_len = len - rem_len;
-    block_nb = new_len / SHA224_BLOCK_SIZE;
-
-    shifted_message = message + rem_len;
-
-    sha256_transf(ctx, ctx->block, 1);
-    sha256_transf(ctx, shifted_message, block_nb);
-
-    rem_len = new_len % SHA224_BLOCK_SIZE;
+    /* Complete the buffered head, if any */
+    if (ctx->len != 0) {
+        rem_len = SHA224_BLOCK_SIZE - ctx->len;
+        memcpy(&ctx->block[ctx->len], message, rem_len);
+        sha256_transf(ctx, ctx->block, 1);
+        ctx->tot_len += SHA224_BLOCK_SIZE;
+        message += rem_len;
+        len -= rem_len;
+    }
 
-    memcpy(ctx->block, &shifted_message[block_nb << 6],
-           rem_len);
+    /* Compress the aligned run of full blocks straight from the caller */
+    block_nb = len / SHA224_BLOCK_SIZE;
+    sha256_transf(ctx, message, block_nb);
+    ctx->tot_len += (uint64) block_nb << 6;
 
+    /* Buffer the tail */
+    rem_len = len % SHA224_BLOCK_SIZE;
+    memcpy(ctx->block, &message[block_nb << 6], rem_len);
     ctx->len = rem_len;
-    ctx->tot_len += (block_nb + 1) << 6;
 }
 
 void sha224_final(sha224_ctx *ctx, unsigned char *digest)
 {
     unsigned int block_nb;
     unsigned int pm_len;
-    unsigned int len_b;
+    uint64 len_b;
 
 #ifndef UNROLL_LOOPS
     int i;
@@ -945,7 +1327,7 @@ void sha224_final(sha224_ctx *ctx, unsigned char *digest)
 
     memset(ctx->block + ctx->len, 0, pm_len - ctx->len);
     ctx->block[ctx->len] = 0x80;
-    UNPACK32(len_b, ctx->block + pm_len - 4);
+    UNPACK64(len_b, ctx->block + pm_len - 8);
 
     sha256_transf(ctx, ctx->block, block_nb);
 
@@ -963,3 +1345,202 @@ void sha224_final(sha224_ctx *ctx, unsigned char *digest)
    UNPACK32(ctx->h[6], &digest[24]);
 #endif /* !UNROLL_LOOPS */
 }
+
+/* Midstate serialization
+ *
+ * Layout (all integers big-endian):
+ *   version (1) | alg (1) | tot_len (8) | len (1) | h[0..7] | block[0..len-1]
+ * where alg is one of SHA2_STATE_SHA224 .. SHA2_STATE_SHA512_256. SHA-224
+ * and SHA-256 store 4-byte h words, the SHA-512 family 8-byte words.
+ * Functions that share a context type have different initial values and
+ * digest sizes, so a state is only accepted by the import function of the
+ * algorithm that exported it.
+ */
+
+static size_t sha2_export(int alg, uint64 tot_len, size_t len,
+                          const unsigned char *block, const uint32 *h32,
+                          const uint64 *h64, unsigned char *out)
+{
+    unsigned char *p = out;
+    int i;
+
+    *p++ = SHA2_STATE_VERSION;
+    *p++ = (unsigned char) alg;
+    UNPACK64(tot_len, p);
+    p += 8;
+    *p++ = (unsigned char) len;
+    for (i = 0; i < 8; i++) {
+        if (h32 != NULL) {
+            UNPACK32(h32[i], p);
+            p += 4;
+        } else {
+            UNPACK64(h64[i], p);
+            p += 8;
+        }
+    }
+    memcpy(p, block, len);
+    return (size_t) (p - out) + len;
+}
+
+static int sha2_import(int alg, size_t block_size, const unsigned char *in,
+                       size_t in_len, uint64 *tot_len, size_t *len,
+                       unsigned char *block, uint32 *h32, uint64 *h64)
+{
+    const size_t word = h32 != NULL ? 4 : 8;
+    const unsigned char *p = in;
+    uint64 t;
+    size_t l;
+    int i;
+
+    if (in == NULL || in_len < 11 + 8 * word)
+        return -1;
+    if (p[0] != SHA2_STATE_VERSION || p[1] != alg)
+        return -1;
+    PACK64(p + 2, &t);
+    l = p[10];
+    if (l >= block_size || t % block_size != 0 || in_len != 11 + 8 * word + l)
+        return -1;
+    p += 11;
+    for (i = 0; i < 8; i++) {
+        if (h32 != NULL) {
+            PACK32(p, &h32[i]);
+        } else {
+            PACK64(p, &h64[i]);
+        }
+        p += word;
+    }
+    memcpy(block, p, l);
+    *tot_len = t;
+    *len = l;
+    return 0;
+}
+
+size_t sha224_export(const sha224_ctx *ctx, unsigned char *out)
+{
+    return sha2_export(SHA2_STATE_SHA224, ctx->tot_len, ctx->len, ctx->block,
+                       ctx->h, NULL, out);
+}
+
+int sha224_import(sha224_ctx *ctx, const unsigned char *in, size_t in_len)
+{
+    return sha2_import(SHA2_STATE_SHA224, SHA224_BLOCK_SIZE, in, in_len,
+                       &ctx->tot_len, &ctx->len, ctx->block, ctx->h, NULL);
+}
+
+size_t sha256_export(const sha256_ctx *ctx, unsigned char *out)
+{
+    return sha2_export(SHA2_STATE_SHA256, ctx->tot_len, ctx->len, ctx->block,
+                       ctx->h, NULL, out);
+}
+
+int sha256_import(sha256_ctx *ctx, const unsigned char *in, size_t in_len)
+{
+    return sha2_import(SHA2_STATE_SHA256, SHA256_BLOCK_SIZE, in, in_len,
+                       &ctx->tot_len, &ctx->len, ctx->block, ctx->h, NULL);
+}
+
+size_t sha384_export(const sha384_ctx *ctx, unsigned char *out)
+{
+    return sha2_export(SHA2_STATE_SHA384, ctx->tot_len, ctx->len, ctx->block,
+                       NULL, ctx->h, out);
+}
+
+int sha384_import(sha384_ctx *ctx, const unsigned char *in, size_t in_len)
+{
+    return sha2_import(SHA2_STATE_SHA384, SHA384_BLOCK_SIZE, in, in_len,
+                       &ctx->tot_len, &ctx->len, ctx->block, NULL, ctx->h);
+}
+
+size_t sha512_export(const sha512_ctx *ctx, unsigned char *out)
+{
+    return sha2_export(SHA2_STATE_SHA512, ctx->tot_len, ctx->len, ctx->block,
+                       NULL, ctx->h, out);
+}
+
+int sha512_import(sha512_ctx *ctx, const unsigned char *in, size_t in_len)
+{
+    return sha2_import(SHA2_STATE_SHA512, SHA512_BLOCK_SIZE, in, in_len,
+                       &ctx->tot_len, &ctx->len, ctx->block, NULL, ctx->h);
+}
+
+size_t sha512_224_export(const sha512_ctx *ctx, unsigned char *out)
+{
+    return sha2_export(SHA2_STATE_SHA512_224, ctx->tot_len, ctx->len,
+                       ctx->block, NULL, ctx->h, out);
+}
+
+int sha512_224_import(sha512_ctx *ctx, const unsigned char *in, size_t in_len)
+{
+    return sha2_import(SHA2_STATE_SHA512_224, SHA512_BLOCK_SIZE, in, in_len,
+                       &ctx->tot_len, &ctx->len, ctx->block, NULL, ctx->h);
+}
+
+size_t sha512_256_export(const sha512_ctx *ctx, unsigned char *out)
+{
+    return sha2_export(SHA2_STATE_SHA512_256, ctx->tot_len, ctx->len,
+                       ctx->block, NULL, ctx->h, out);
+}
+
+int sha512_256_import(sha512_ctx *ctx, const unsigned char *in, size_t in_len)
+{
+    return sha2_import(SHA2_STATE_SHA512_256, SHA512_BLOCK_SIZE, in, in_len,
+                       &ctx->tot_len, &ctx->len, ctx->block, NULL, ctx->h);
+}
+
+/* Hash descriptors
+ *
+ * One entry per SHA-2 function, in the order of the SHA224 .. SHA512_256
+ * indices used by the callers, so that a caller can pick the sizes and
+ * functions once instead of branching on the index at every call.
+ */
+
+#define SHA2_DESC_FUNCS(name, init_f, update_f, final_f, member)            \
+static void name##_desc_init(sha2_ctx *ctx)                                 \
+{                                                                           \
+    init_f(&ctx->member);                                                   \
+}                                                                           \
+static void name##_desc_update(sha2_ctx *ctx, const unsigned char *message, \
+                               size_t len)                                  \
+{                                                                           \
+    update_f(&ctx->member, message, len);                                   \
+}                                                                           \
+static void name##_desc_final(sha2_ctx *ctx, unsigned char *digest)         \
+{                                                                           \
+    final_f(&ctx->member, digest);                                          \
+}                                                                           \
+static void name##_desc_hash_iov(const sha2_iovec *iov, int iovcnt,         \
+                                 unsigned char *digest)                     \
+{                                                                           \
+    sha2_ctx ctx;                                                           \
+    int i;                                                                  \
+                                                                            \
+    init_f(&ctx.member);                                                    \
+    for (i = 0; i < iovcnt; i++) {                                          \
+        update_f(&ctx.member, iov[i].base, iov[i].len);                     \
+    }                                                                       \
+    final_f(&ctx.member, digest);                                           \
+}
+
+SHA2_DESC_FUNCS(sha224, sha224_init, sha224_update, sha224_final, c256)
+SHA2_DESC_FUNCS(sha256, sha256_init, sha256_update, sha256_final, c256)
+SHA2_DESC_FUNCS(sha384, sha384_init, sha384_update, sha384_final, c512)
+SHA2_DESC_FUNCS(sha512, sha512_init, sha512_update, sha512_final, c512)
+SHA2_DESC_FUNCS(sha512_224, sha512_224_init, sha512_update,
+                sha512_224_final, c512)
+SHA2_DESC_FUNCS(sha512_256, sha512_256_init, sha512_update,
+                sha512_256_final, c512)
+
+#define SHA2_DESC(name, label, digest_size, block_size)                    \
+    {label, digest_size, block_size, name##_desc_init, name##_desc_update, \
+     name##_desc_final, name, name##_desc_hash_iov}
+
+const sha2_desc sha2_descs[SHA2_NUM_DESCS] = {
+    SHA2_DESC(sha224, "SHA-224", SHA224_DIGEST_SIZE, SHA224_BLOCK_SIZE),
+    SHA2_DESC(sha256, "SHA-256", SHA256_DIGEST_SIZE, SHA256_BLOCK_SIZE),
+    SHA2_DESC(sha384, "SHA-384", SHA384_DIGEST_SIZE, SHA384_BLOCK_SIZE),
+    SHA2_DESC(sha512, "SHA-512", SHA512_DIGEST_SIZE, SHA512_BLOCK_SIZE),
+    SHA2_DESC(sha512_224, "SHA-512/224", SHA224_DIGEST_SIZE,
+              SHA512_BLOCK_SIZE),
+    SHA2_DESC(sha512_256, "SHA-512/256", SHA256_DIGEST_SIZE,
+              SHA512_BLOCK_SIZE)
+};